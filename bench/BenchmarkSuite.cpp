@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BenchmarkSuite.cpp
+ * \author     Richard Kvasnica
+ * \brief      CPU micro-benchmark suite definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "BenchmarkSuite.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace kvasnric
+{
+	BenchmarkSuite::BenchmarkSuite(std::string filter)
+		: m_Filter(std::move(filter)), m_Sink(0.0f)
+	{
+	}
+
+	bool BenchmarkSuite::Skip(const std::string& name) const
+	{
+		return !m_Filter.empty() && name.find(m_Filter) == std::string::npos;
+	}
+
+	void BenchmarkSuite::Store(const std::string& name, const std::string& size, double itemsPerOp, std::vector<double> nsPerOp)
+	{
+		std::nth_element(nsPerOp.begin(), nsPerOp.begin() + nsPerOp.size() / 2, nsPerOp.end());
+		const double ns = nsPerOp[nsPerOp.size() / 2];
+
+		m_Results.push_back({ name, size, ns, 1e9 / ns, itemsPerOp * 1e9 / ns });
+
+		// results are printed as they come, the whole suite takes a while
+		std::printf("%-32s %-22s %12.1f ns/op\n", name.c_str(), size.c_str(), ns);
+		std::fflush(stdout);
+	}
+
+	void BenchmarkSuite::Print(std::ostream& os) const
+	{
+		char line[160];
+		std::snprintf(line, sizeof(line), "%-32s %-22s %12s %12s %14s\n", "kernel", "size", "ns/op", "Mops/s", "Mitems/s");
+		os << line;
+
+		for (const auto& r : m_Results)
+		{
+			std::snprintf(line, sizeof(line), "%-32s %-22s %12.1f %12.4f %14.3f\n",
+				r.Name.c_str(), r.Size.c_str(), r.NsPerOp, r.OpsPerSecond / 1e6, r.ItemsPerSecond / 1e6);
+			os << line;
+		}
+
+		// printing the sink keeps it alive, it has no meaning
+		os << "checksum " << m_Sink << std::endl;
+	}
+
+	bool BenchmarkSuite::WriteCsv(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::out | std::ios::trunc);
+		if (!file.is_open()) return false;
+
+		char value[64];
+		file << "kernel,size,ns_per_op,ops_per_s,items_per_s\n";
+		for (const auto& r : m_Results)
+		{
+			std::snprintf(value, sizeof(value), ",%.3f,%.1f,%.1f\n", r.NsPerOp, r.OpsPerSecond, r.ItemsPerSecond);
+			file << r.Name << ',' << r.Size << value;
+		}
+		return true;
+	}
+
+	double BenchmarkSuite::NanosecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+}
@@ -0,0 +1,106 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BenchmarkSuite.hpp
+ * \author     Richard Kvasnica
+ * \brief      CPU micro-benchmark suite declaration
+ *
+ * Times small kernels of the engine and reports nanoseconds per operation and throughput.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kvasnric
+{
+	/**
+	 * Runs kernels in batches long enough for the clock to be precise and keeps the median batch.
+	 * Every kernel returns a float which is summed into a sink, so the compiler cannot remove the work.
+	 */
+	class BenchmarkSuite
+	{
+	public:
+		// timing of one kernel at one size
+		struct Result
+		{
+			std::string Name;
+			std::string Size;
+			double NsPerOp;
+			double OpsPerSecond;
+			double ItemsPerSecond;
+		};
+
+		/**
+		 * @param filter only kernels whose name contains the filter are run, empty runs all
+		 */
+		explicit BenchmarkSuite(std::string filter = "");
+
+		/**
+		 * Times the kernel and stores its result
+		 * @param name name of the kernel
+		 * @param size description of the data the kernel runs on
+		 * @param itemsPerOp number of items one operation processes, like triangles tested by one ray
+		 * @param op kernel called with the index of the operation, the index lets it walk through prepared inputs
+		 */
+		template <typename Op>
+		void Run(const std::string& name, const std::string& size, double itemsPerOp, Op&& op);
+
+		/**
+		 * Prints every result as a table
+		 */
+		void Print(std::ostream& os) const;
+
+		/**
+		 * Writes every result as one row of a csv file
+		 * @returns whether the file could be opened
+		 */
+		bool WriteCsv(const std::string& path) const;
+
+		inline const std::vector<Result>& Results() const { return m_Results; }
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		bool Skip(const std::string& name) const;
+		void Store(const std::string& name, const std::string& size, double itemsPerOp, std::vector<double> nsPerOp);
+
+		static double NanosecondsSince(Clock::time_point start);
+
+		// batch has to take at least this long to be measured, the median of the batches is reported
+		static const unsigned BATCH_MS = 20;
+		static const unsigned BATCHES = 7;
+
+		std::string m_Filter;
+		std::vector<Result> m_Results;
+		float m_Sink;
+	};
+
+	template <typename Op>
+	void BenchmarkSuite::Run(const std::string& name, const std::string& size, double itemsPerOp, Op&& op)
+	{
+		if (Skip(name)) return;
+
+		// warm up and find how many operations fill one batch
+		unsigned count = 1;
+		for (;;)
+		{
+			const auto start = Clock::now();
+			for (unsigned i = 0; i < count; ++i) m_Sink += op(i);
+			if (NanosecondsSince(start) >= BATCH_MS * 1000000.0 || count >= (1u << 30)) break;
+			count <<= 1;
+		}
+
+		std::vector<double> nsPerOp;
+		for (unsigned b = 0; b < BATCHES; ++b)
+		{
+			const auto start = Clock::now();
+			for (unsigned i = 0; i < count; ++i) m_Sink += op(i);
+			nsPerOp.push_back(NanosecondsSince(start) / count);
+		}
+
+		Store(name, size, itemsPerOp, std::move(nsPerOp));
+	}
+}
@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       SceneGeometry.cpp
+ * \author     Richard Kvasnica
+ * \brief      Static scene geometry loader definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "SceneGeometry.hpp"
+
+#include <Scene/PortalWalls.hpp>
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace kvasnric
+{
+	std::shared_ptr<Model> SceneGeometry::Load(const std::string& filename, unsigned copies)
+	{
+		Assimp::Importer importer;
+
+		const std::string filepath = "res/models/" + filename;
+
+		// the same flags as Resources::LoadModelFromFile, so the triangles are the ones the game intersects
+		const auto* scene = importer.ReadFile(filepath,
+			aiProcess_Triangulate |
+			aiProcess_GenSmoothNormals |
+			aiProcess_FlipUVs |
+			aiProcess_CalcTangentSpace |
+			aiProcess_PreTransformVertices |
+			aiProcess_MakeLeftHanded |
+			aiProcess_JoinIdenticalVertices |
+			aiProcess_OptimizeMeshes
+		);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			const std::string msg = "Cannot load model: " + filepath + " " + importer.GetErrorString();
+			throw std::runtime_error(msg.c_str());
+		}
+
+		// copies are spread on a square grid in the xz plane, one model size apart
+		glm::vec3 min(INFINITY), max(-INFINITY);
+		for (unsigned m = 0; m < scene->mNumMeshes; ++m)
+		{
+			const aiMesh* mesh = scene->mMeshes[m];
+			for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+			{
+				const glm::vec3 v(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+				min = glm::min(min, v);
+				max = glm::max(max, v);
+			}
+		}
+
+		const glm::vec3 spacing = (max - min) * 1.1f;
+		const unsigned side = (unsigned) std::ceil(std::sqrt((float) copies));
+
+		auto model = std::make_shared<Model>();
+		for (unsigned m = 0; m < scene->mNumMeshes; ++m)
+		{
+			const aiMesh* mesh = scene->mMeshes[m];
+			auto& out = model->NewMesh();
+
+			for (unsigned c = 0; c < copies; ++c)
+			{
+				const glm::vec3 offset((c % side) * spacing.x, 0.0f, (c / side) * spacing.z);
+				const uint32_t first = c * mesh->mNumVertices;
+
+				for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+				{
+					const auto& vert = mesh->mVertices[i];
+					const auto& norm = mesh->mNormals[i];
+					out.AddVertex(Vertex(
+						glm::vec3(vert.x, vert.y, vert.z) + offset,
+						{ norm.x, norm.y, norm.z },
+						{ 0.0f, 0.0f },
+						{ 0.0f, 0.0f, 0.0f }
+					));
+				}
+
+				for (unsigned i = 0; i < mesh->mNumFaces; ++i)
+				{
+					const auto& face = mesh->mFaces[i].mIndices;
+					out.AddFace(first + face[0], first + face[1], first + face[2]);
+				}
+			}
+		}
+
+		return model;
+	}
+
+	std::shared_ptr<Model> SceneGeometry::LoadPortalWalls()
+	{
+		auto model = std::make_shared<Model>();
+		PortalWalls::CreateGeometry(model->NewMesh());
+		return model;
+	}
+
+	unsigned SceneGeometry::Triangles(const Model& model)
+	{
+		unsigned count = 0;
+		for (const auto& mesh : model.GetMeshes()) count += mesh->GetCountOfIndices() / 3;
+		return count;
+	}
+}
@@ -0,0 +1,43 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       SceneGeometry.hpp
+ * \author     Richard Kvasnica
+ * \brief      Static scene geometry loader declaration
+ *
+ * Loads the meshes of the game without an opengl context.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <Scene/Model.hpp>
+
+#include <memory>
+#include <string>
+
+namespace kvasnric
+{
+	// Static class loading only vertices and faces of the game models. Meshes are neither registered nor given
+	// materials, so nothing touches opengl and the intersections run on exactly the triangles the game uses.
+	class SceneGeometry
+	{
+	public:
+		/**
+		 * Loads a model from res/models with the same post processing as Resources
+		 * @param filename model file name
+		 * @param copies the model is repeated this many times on a grid to scale the triangle count up,
+		 * all copies of one mesh are merged so a single FindIntersection walks over all of them
+		 */
+		static std::shared_ptr<Model> Load(const std::string& filename, unsigned copies = 1);
+
+		/**
+		 * @returns model holding the hardcoded portal walls mesh
+		 */
+		static std::shared_ptr<Model> LoadPortalWalls();
+
+		/**
+		 * @returns number of triangles of all meshes of the model
+		 */
+		static unsigned Triangles(const Model& model);
+	};
+}
@@ -0,0 +1,768 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       main.cpp
+ * \author     Richard Kvasnica
+ * \brief      CPU micro-benchmarks of the engine kernels
+ *
+ * Runs without an opengl context, the working directory has to be the repository root so res/models is found.
+ * Usage: PGRKvasnricBench [kernel filter] [--csv output.csv]
+*/
+//----------------------------------------------------------------------------------------
+
+#include "BenchmarkSuite.hpp"
+#include "SceneGeometry.hpp"
+
+#include <JobSystem.hpp>
+#include <Portal.hpp>
+#include <Renderer/CommandList.hpp>
+#include <Scene/EntityStore.hpp>
+#include <Scene/GameObject.hpp>
+#include <Scene/HeightGrid.hpp>
+#include <Scene/SceneRaycast.hpp>
+#include <Scene/Spline.hpp>
+#include <Scene/TriangleBlocks.hpp>
+#include <constants.hpp>
+
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace kvasnric
+{
+	// inputs are prepared ahead in arrays of this size, a power of two so the index is masked
+	static const unsigned INPUTS = 1024;
+
+	// control points of Wheatley's path in PortalTestRoom
+	static const std::vector<glm::vec3> WHEATLEY_PATH = {
+		{-4.768676f, 5.708214f, -4.713191f},
+		{-1.444324f, 1.900001f, 0.552242f},
+		{3.610741f, 1.750002f, -2.532145f},
+		{10.226067f, 1.750001f, -2.561681f},
+		{13.978791f, 1.750001f, -6.398846f},
+		{14.197656f, 3.896972f, -11.126340f},
+		{14.372760f, 1.750001f, -19.485508f},
+		{10.404376f, 1.750001f, -23.865780f},
+		{3.971180f, 1.750001f, -23.906567f},
+		{-1.752727f, 4.339311f, -23.938444f},
+		{-5.346721f, 4.542591f, -19.348381f},
+		{-5.865470f, 3.042348f, -12.525190f}
+	};
+
+	struct Ray
+	{
+		glm::vec3 Origin;
+		glm::vec3 Direction;
+	};
+
+	/**
+	 * Random positions inside the room, where the player and the objects move
+	 */
+	static std::vector<glm::vec3> RoomPositions(std::mt19937& rng, unsigned count)
+	{
+		std::uniform_real_distribution<float> x(-8.0f, 15.0f), y(-0.5f, 4.5f), z(-25.0f, 0.0f);
+
+		std::vector<glm::vec3> positions(count);
+		for (auto& p : positions) p = { x(rng), y(rng), z(rng) };
+		return positions;
+	}
+
+	/**
+	 * Rays shot from the room in random directions, like the portal gun aimed anywhere
+	 */
+	static std::vector<Ray> RoomRays(std::mt19937& rng, unsigned count)
+	{
+		std::normal_distribution<float> d(0.0f, 1.0f);
+		const auto origins = RoomPositions(rng, count);
+
+		std::vector<Ray> rays(count);
+		for (unsigned i = 0; i < count; ++i) rays[i] = { origins[i], glm::normalize(glm::vec3(d(rng), d(rng), d(rng))) };
+		return rays;
+	}
+
+	// closest hit distance and any hit within 5 units of every ray against every mesh of a model
+	struct RayAnswers
+	{
+		std::vector<float> Closest;
+		std::vector<uint8_t> Any;
+	};
+
+	static RayAnswers AnswerRays(const Model& model, const std::vector<Ray>& rays)
+	{
+		RayAnswers answers;
+		for (const auto& mesh : model.GetMeshes())
+		{
+			for (const Ray& r : rays)
+			{
+				MeshBVH::Hit hit;
+				answers.Closest.push_back(mesh->FindClosestHit(hit, r.Origin, r.Direction) ? hit.Distance : INFINITY);
+				answers.Any.push_back(mesh->IntersectsAny(r.Origin, r.Direction, 5.0f) ? 1 : 0);
+			}
+		}
+		return answers;
+	}
+
+	/**
+	 * Compares the answers of the hierarchy with the brute force ones, distances have to be bitwise the same
+	 */
+	static void CheckBVH(const std::string& name, const RayAnswers& bruteForce, const RayAnswers& bvh)
+	{
+		for (size_t i = 0; i < bruteForce.Closest.size(); ++i)
+		{
+			if (std::memcmp(&bruteForce.Closest[i], &bvh.Closest[i], sizeof(float)) != 0)
+				throw std::runtime_error("MeshBVH: closest hit of ray " + std::to_string(i) + " differs from the brute force on " + name);
+			if (bruteForce.Any[i] != bvh.Any[i])
+				throw std::runtime_error("MeshBVH: any hit of ray " + std::to_string(i) + " differs from the brute force on " + name);
+		}
+		std::cout << "MeshBVH matches the brute force on " << name << ", " << bruteForce.Closest.size() << " rays" << std::endl;
+	}
+
+	static void BenchmarkIntersections(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		const auto rays = RoomRays(rng, INPUTS);
+
+		struct Target
+		{
+			std::string Name;
+			std::shared_ptr<Model> Geometry;
+		};
+
+		// portal walls are what the game intersects on every click, the rest scales the triangle count up
+		const std::vector<Target> targets = {
+			{ "portal walls", SceneGeometry::LoadPortalWalls() },
+			{ "scene_floor", SceneGeometry::Load("scene_floor.obj") },
+			{ "wheatley", SceneGeometry::Load("wheatley.obj") },
+			{ "wheatley x16", SceneGeometry::Load("wheatley.obj", 16) },
+			{ "wheatley x256", SceneGeometry::Load("wheatley.obj", 256) },
+		};
+
+		for (const auto& target : targets)
+		{
+			Model& model = *target.Geometry;
+			const unsigned triangles = SceneGeometry::Triangles(model);
+			const std::string size = target.Name + " " + std::to_string(triangles) + " tris";
+
+			const auto closest = [&](unsigned i)
+			{
+				const Ray& r = rays[i & (INPUTS - 1)];
+				glm::vec3 out(0.0f), normal(0.0f);
+				float hit = 0.0f;
+				for (const auto& mesh : model.GetMeshes())
+				{
+					if (mesh->FindIntersection(out, normal, r.Origin, r.Direction)) hit += out.x + normal.y;
+				}
+				return hit;
+			};
+
+			const auto any = [&](unsigned i)
+			{
+				const Ray& r = rays[i & (INPUTS - 1)];
+				float hit = 0.0f;
+				for (const auto& mesh : model.GetMeshes())
+				{
+					if (mesh->IntersectsAny(r.Origin, r.Direction, 5.0f)) hit += 1.0f;
+				}
+				return hit;
+			};
+
+			// answers without the hierarchy, the hierarchy has to give the same ones
+			const RayAnswers bruteForce = AnswerRays(model, rays);
+
+			// items are the triangles of the model in all cases, so the throughput shows the speedup of the hierarchy
+			suite.Run("Mesh::FindIntersection", size, triangles, closest);
+			suite.Run("Mesh::IntersectsAny", size, triangles, any);
+
+			suite.Run("Mesh::BuildBVH", size, triangles, [&](unsigned)
+			{
+				model.BuildBVH();
+				return 0.0f;
+			});
+
+			// the build kernel may be filtered out
+			model.BuildBVH();
+			CheckBVH(target.Name, bruteForce, AnswerRays(model, rays));
+			suite.Run("Mesh::FindIntersection BVH", size, triangles, closest);
+			suite.Run("Mesh::IntersectsAny BVH", size, triangles, any);
+
+			suite.Run("Mesh::RefitBVH", size, triangles, [&](unsigned)
+			{
+				for (const auto& mesh : model.GetMeshes()) mesh->RefitBVH();
+				return 0.0f;
+			});
+		}
+
+		// single triangle tests walk the walls triangle by triangle with changing rays
+		const auto walls = SceneGeometry::LoadPortalWalls();
+		const Mesh& mesh = *walls->GetMeshes()[0];
+		const unsigned triangles = mesh.GetCountOfIndices() / 3;
+
+		suite.Run("Mesh::Intersects", "portal walls", 1.0, [&](unsigned i)
+		{
+			const Ray& r = rays[(i / triangles) & (INPUTS - 1)];
+			glm::vec3 out(0.0f);
+			return mesh.Intersects(out, r.Origin, r.Direction, (i % triangles) * 3) ? out.z : 0.0f;
+		});
+	}
+
+	/**
+	 * Compares every lane of the simd kernel with the scalar test, hits and distances have to be bitwise the same.
+	 * One ray goes from a random spot in the room through the centroid of each triangle, so most lanes are hit.
+	 */
+	static void CheckTriangleBlocks(const Mesh& mesh, std::mt19937& rng)
+	{
+		const auto& vertices = mesh.GetVertices();
+		const auto& indices = mesh.GetIndices();
+
+		std::vector<uint32_t> ids;
+		for (uint32_t i = 0; i < indices.size(); i += 3) ids.push_back(i);
+
+		TriangleBlocks blocks;
+		blocks.AddTriangles(ids.data(), (uint32_t) ids.size(), vertices, indices);
+
+		const auto origins = RoomPositions(rng, (unsigned) ids.size());
+		unsigned hits = 0;
+		for (uint32_t r = 0; r < ids.size(); ++r)
+		{
+			const glm::vec3 centroid = (vertices[indices[ids[r]]].Position + vertices[indices[ids[r] + 1]].Position + vertices[indices[ids[r] + 2]].Position) / 3.0f;
+			const glm::vec3 direction = glm::normalize(centroid - origins[r]);
+
+			for (uint32_t b = 0; b < blocks.Count(); ++b)
+			{
+				float t[TriangleBlocks::WIDTH];
+				const unsigned mask = blocks.IntersectLanes(t, b, origins[r], direction, INFINITY);
+
+				for (unsigned lane = 0; lane < TriangleBlocks::WIDTH; ++lane)
+				{
+					const uint32_t id = blocks.Triangle(b, lane);
+					const bool lanehit = (mask >> lane) & 1;
+					if (id == TriangleBlocks::NO_TRIANGLE)
+					{
+						if (lanehit) throw std::runtime_error("TriangleBlocks: padding lane was hit");
+						continue;
+					}
+
+					float scalar;
+					const bool hit = MeshBVH::IntersectTriangle(scalar, vertices[indices[id]].Position, vertices[indices[id + 1]].Position,
+						vertices[indices[id + 2]].Position, origins[r], direction) && scalar < INFINITY;
+
+					if (hit != lanehit || (hit && std::memcmp(&scalar, &t[lane], sizeof(float))))
+					{
+						throw std::runtime_error("TriangleBlocks: lane " + std::to_string(lane) + " differs from the scalar test at triangle " + std::to_string(id));
+					}
+					hits += hit;
+				}
+			}
+		}
+
+		std::cout << "TriangleBlocks " << TriangleBlocks::InstructionSet() << " matches the scalar test bitwise, "
+			<< ids.size() << " rays, " << hits << " hits" << std::endl;
+	}
+
+	static void BenchmarkTriangleBlocks(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		const auto walls = SceneGeometry::LoadPortalWalls();
+		const auto wheatley = SceneGeometry::Load("wheatley.obj");
+		CheckTriangleBlocks(*walls->GetMeshes()[0], rng);
+		CheckTriangleBlocks(*wheatley->GetMeshes()[0], rng);
+
+		const auto rays = RoomRays(rng, INPUTS);
+		const Mesh& mesh = *wheatley->GetMeshes()[0];
+		const auto& vertices = mesh.GetVertices();
+		const auto& indices = mesh.GetIndices();
+		const unsigned triangles = mesh.GetCountOfIndices() / 3;
+		const std::string size = "wheatley " + std::to_string(triangles) + " tris";
+
+		std::vector<uint32_t> ids;
+		for (uint32_t i = 0; i < indices.size(); i += 3) ids.push_back(i);
+		TriangleBlocks blocks;
+		blocks.AddTriangles(ids.data(), (uint32_t) ids.size(), vertices, indices);
+
+		// every triangle of the mesh against one ray, the scalar loop gathers the vertices through the elements
+		suite.Run("MeshBVH::IntersectTriangle", size, triangles, [&](unsigned i)
+		{
+			const Ray& r = rays[i & (INPUTS - 1)];
+			float closest = INFINITY;
+			for (uint32_t id = 0; id < indices.size(); id += 3)
+			{
+				float t;
+				if (MeshBVH::IntersectTriangle(t, vertices[indices[id]].Position, vertices[indices[id + 1]].Position,
+					vertices[indices[id + 2]].Position, r.Origin, r.Direction) && t < closest) closest = t;
+			}
+			return closest < INFINITY ? closest : 0.0f;
+		});
+
+		suite.Run(std::string("TriangleBlocks ") + TriangleBlocks::InstructionSet(), size, triangles, [&](unsigned i)
+		{
+			const Ray& r = rays[i & (INPUTS - 1)];
+			float closest = INFINITY;
+			uint32_t triangle = 0;
+			for (uint32_t b = 0; b < blocks.Count(); ++b) blocks.Intersect(closest, triangle, b, r.Origin, r.Direction);
+			return closest < INFINITY ? closest : 0.0f;
+		});
+	}
+
+	static void BenchmarkFloor(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		const auto floor = SceneGeometry::Load("scene_floor.obj");
+		floor->BuildBVH();
+		const HeightGrid grid(*floor);
+
+		const auto positions = RoomPositions(rng, INPUTS);
+		const glm::vec3 down(0.0f, -1.0f, 0.0f);
+
+		// grid has to find the same floor as the ray the camera used to shoot down
+		unsigned agree = 0;
+		for (const auto& p : positions)
+		{
+			float height = -INFINITY;
+			glm::vec3 out(-INFINITY), normal;
+			for (const auto& mesh : floor->GetMeshes())
+			{
+				glm::vec3 hit;
+				if (mesh->FindIntersection(hit, normal, p, down) && hit.y > out.y) out = hit;
+			}
+			grid.Height(height, p);
+			if (height == out.y || std::abs(height - out.y) < 0.0001f) ++agree;
+		}
+		if (agree != INPUTS)
+			throw std::runtime_error("HeightGrid: floor height differs from the downward ray at " + std::to_string(INPUTS - agree) + " positions");
+		std::cout << "HeightGrid " << grid.Cells().x << "x" << grid.Cells().y << " cells agrees with the downward ray at "
+			<< agree << " of " << INPUTS << " positions" << std::endl;
+
+		const std::string size = std::to_string(grid.TriangleCount()) + " tris";
+		suite.Run("Mesh::FindIntersection down", size, 1.0, [&](unsigned i)
+		{
+			glm::vec3 out(0.0f), normal(0.0f);
+			float hit = 0.0f;
+			for (const auto& mesh : floor->GetMeshes())
+			{
+				if (mesh->FindIntersection(out, normal, positions[i & (INPUTS - 1)], down)) hit += out.y;
+			}
+			return hit;
+		});
+
+		suite.Run("HeightGrid::Height", size, 1.0, [&](unsigned i)
+		{
+			float height = 0.0f;
+			return grid.Height(height, positions[i & (INPUTS - 1)]) ? height : 0.0f;
+		});
+
+		// all agents of a step at once, one operation grounds every position
+		std::vector<float> heights(INPUTS);
+		suite.Run("HeightGrid::Heights", std::to_string(INPUTS) + " agents", INPUTS, [&](unsigned)
+		{
+			grid.Heights(heights.data(), positions.data(), INPUTS);
+			return heights[0];
+		});
+	}
+
+	static void BenchmarkScene(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		const auto wheatley = SceneGeometry::Load("wheatley.obj");
+		wheatley->BuildBVH();
+		const auto rays = RoomRays(rng, INPUTS);
+
+		// the room has about a dozen objects, the larger count shows how the top level scales
+		for (const unsigned count : { 16u, 4096u })
+		{
+			std::vector<GameObject> objects;
+			objects.reserve(count);
+			for (const auto& p : RoomPositions(rng, count))
+			{
+				objects.emplace_back(wheatley, p);
+				objects.back().RotationYAxis(p.x * 10.0f).Scale(glm::vec3(0.6f));
+			}
+
+			SceneRaycast scene;
+			for (const auto& o : objects) scene.Add(o, SceneRaycast::SOLID | SceneRaycast::PICKABLE);
+			scene.Build();
+
+			// every object tested one by one is what the scene replaces
+			const auto closestByLoop = [&](const Ray& r, float& closest)
+			{
+				bool found = false;
+				for (const auto& o : objects)
+				{
+					const glm::mat4 inverse = glm::inverse(o.GetModelMatrix());
+					MeshBVH::Hit hit;
+					if (o.GetModel().GetMeshes()[0]->FindClosestHit(hit, glm::vec3(inverse * glm::vec4(r.Origin, 1.0f)),
+						glm::vec3(inverse * glm::vec4(r.Direction, 0.0f)), closest))
+					{
+						closest = hit.Distance;
+						found = true;
+					}
+				}
+				return found;
+			};
+
+			unsigned agree = 0;
+			for (const auto& r : rays)
+			{
+				float closest = INFINITY;
+				SceneRaycast::Hit hit;
+				const bool loop = closestByLoop(r, closest);
+				const bool found = scene.Raycast(hit, r.Origin, r.Direction);
+				if (loop == found && (!found || hit.Distance == closest)) ++agree;
+			}
+			if (agree != INPUTS)
+				throw std::runtime_error("SceneRaycast: " + std::to_string(INPUTS - agree) + " rays differ from the loop over " + std::to_string(count) + " objects");
+			std::cout << "SceneRaycast agrees with the loop over " << count << " objects at " << agree << " of " << INPUTS << " rays" << std::endl;
+
+			const std::string size = std::to_string(count) + " objects";
+			suite.Run("GameObject loop raycast", size, count, [&](unsigned i)
+			{
+				float closest = INFINITY;
+				return closestByLoop(rays[i & (INPUTS - 1)], closest) ? closest : 0.0f;
+			});
+
+			suite.Run("SceneRaycast::Raycast", size, count, [&](unsigned i)
+			{
+				const Ray& r = rays[i & (INPUTS - 1)];
+				SceneRaycast::Hit hit;
+				return scene.Raycast(hit, r.Origin, r.Direction) ? hit.Distance : 0.0f;
+			});
+
+			suite.Run("SceneRaycast::Occluded", size, count, [&](unsigned i)
+			{
+				const Ray& r = rays[i & (INPUTS - 1)];
+				return scene.Occluded(r.Origin, r.Direction, SceneRaycast::ALL, 5.0f) ? 1.0f : 0.0f;
+			});
+
+			suite.Run("SceneRaycast::Refit", size, count, [&](unsigned)
+			{
+				scene.Refit();
+				return 0.0f;
+			});
+		}
+	}
+
+	static void BenchmarkRayBatches(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		const auto wheatley = SceneGeometry::Load("wheatley.obj");
+		const auto walls = SceneGeometry::LoadPortalWalls();
+		wheatley->BuildBVH();
+		walls->BuildBVH();
+
+		// walls and a few dozen objects in the room, like the game scene
+		std::vector<GameObject> objects;
+		objects.reserve(64);
+		for (const auto& p : RoomPositions(rng, 64))
+		{
+			objects.emplace_back(wheatley, p);
+			objects.back().RotationYAxis(p.x * 10.0f).Scale(glm::vec3(0.6f));
+		}
+
+		SceneRaycast scene;
+		for (const auto& o : objects) scene.Add(o, SceneRaycast::SOLID | SceneRaycast::PICKABLE);
+		scene.Add(*walls, UNIT_MATRIX, SceneRaycast::SOLID | SceneRaycast::PORTAL_CONDUCTIVE);
+		scene.Build();
+
+		const unsigned count = 65536;
+		std::vector<SceneRaycast::Ray> batch;
+		batch.reserve(count);
+		for (const auto& r : RoomRays(rng, count)) batch.push_back({ r.Origin, r.Direction, 10.0f });
+
+		std::vector<SceneRaycast::Hit> hits(count);
+		std::vector<uint8_t> occluded(count);
+
+		// one thread, four and all hardware threads of the machine
+		std::vector<unsigned> threadCounts = { 1, 4 };
+		const unsigned all = std::max(1u, std::thread::hardware_concurrency());
+		if (all != 1 && all != 4) threadCounts.push_back(all);
+
+		for (const unsigned threads : threadCounts)
+		{
+			JobSystem jobs(threads);
+
+			// batch has to give the same hits as the single queries, whichever thread took the packet
+			scene.RaycastBatch(hits.data(), batch.data(), count, SceneRaycast::ALL, &jobs);
+			unsigned agree = 0;
+			for (unsigned i = 0; i < count; ++i)
+			{
+				SceneRaycast::Hit hit;
+				const bool found = scene.Raycast(hit, batch[i].Origin, batch[i].Direction, SceneRaycast::ALL, batch[i].MaxDistance);
+				if (found ? hit.Distance == hits[i].Distance && hit.Instance == hits[i].Instance : hits[i].Distance == INFINITY) ++agree;
+			}
+			if (agree != count)
+				throw std::runtime_error("SceneRaycast::RaycastBatch: " + std::to_string(count - agree) + " rays differ from single rays on " + std::to_string(threads) + " threads");
+
+			scene.OccludedBatch(occluded.data(), batch.data(), count, SceneRaycast::ALL, &jobs);
+			for (unsigned i = 0; i < count; ++i)
+			{
+				if (occluded[i] != (scene.Occluded(batch[i].Origin, batch[i].Direction, SceneRaycast::ALL, batch[i].MaxDistance) ? 1 : 0))
+					throw std::runtime_error("SceneRaycast::OccludedBatch: ray " + std::to_string(i) + " differs from the single ray on " + std::to_string(threads) + " threads");
+			}
+			std::cout << "SceneRaycast::RaycastBatch and OccludedBatch on " << threads << " threads agree with single rays at " << agree << " of " << count << std::endl;
+
+			const std::string size = std::to_string(count) + " rays " + std::to_string(threads) + " threads";
+			suite.Run("SceneRaycast::RaycastBatch", size, count, [&](unsigned)
+			{
+				scene.RaycastBatch(hits.data(), batch.data(), count, SceneRaycast::ALL, &jobs);
+				return hits[0].Distance < INFINITY ? hits[0].Distance : 0.0f;
+			});
+			suite.Run("SceneRaycast::OccludedBatch", size, count, [&](unsigned)
+			{
+				scene.OccludedBatch(occluded.data(), batch.data(), count, SceneRaycast::ALL, &jobs);
+				return (float) occluded[0];
+			});
+		}
+	}
+
+	static void BenchmarkSplines(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		const Spline wheatley(WHEATLEY_PATH);
+		const Spline large(RoomPositions(rng, 4096));
+
+		// times step through the spline like frames do, in both the realistic and the large one
+		suite.Run("Spline::GetPosition", "12 points", 1.0, [&](unsigned i) { return wheatley.GetPosition(i * 0.013f).x; });
+		suite.Run("Spline::GetPosition", "4096 points", 1.0, [&](unsigned i) { return large.GetPosition(i * 0.013f).x; });
+		suite.Run("Spline::GetDirection", "12 points", 1.0, [&](unsigned i) { return wheatley.GetDirection(i * 0.013f).x; });
+		suite.Run("Spline::GetDirection", "4096 points", 1.0, [&](unsigned i) { return large.GetDirection(i * 0.013f).x; });
+	}
+
+	static void BenchmarkPortals(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		// portals on the opposite walls of the room, as the benchmark mode of the game places them
+		Portal blue({ 0.0f, 1.0f, -15.0f }, { 0.0f, 0.0f, 1.0f });
+		Portal orange({ 0.0f, 1.0f, -15.0f }, { 0.0f, 0.0f, -1.0f });
+		blue.ModifyPortal({ 0.0f, 1.5f, -25.186893f }, { 0.0f, 0.0f, 1.0f });
+		orange.ModifyPortal({ 0.0f, 1.5f, 0.0f }, { 0.0f, 0.0f, -1.0f });
+		blue.SetTeleporation(orange);
+		orange.SetTeleporation(blue);
+
+		// half of the points are near the portal so the collision does not always fail on the first comparison
+		auto points = RoomPositions(rng, INPUTS);
+		std::uniform_real_distribution<float> offset(-0.6f, 0.6f);
+		for (unsigned i = 0; i < INPUTS; i += 2) points[i] = blue.GetPosition() + glm::vec3(offset(rng), offset(rng), offset(rng) * 0.1f);
+
+		suite.Run("Portal::Teleport", "1 point", 1.0, [&](unsigned i)
+		{
+			return blue.Teleport(glm::vec4(points[i & (INPUTS - 1)], 1.0f)).x;
+		});
+		suite.Run("Portal::IsColliding", "1 point", 1.0, [&](unsigned i)
+		{
+			return blue.IsColliding(points[i & (INPUTS - 1)]) ? 1.0f : 0.0f;
+		});
+	}
+
+	static void BenchmarkObjects(BenchmarkSuite& suite, std::mt19937& rng)
+	{
+		const auto wheatley = SceneGeometry::Load("wheatley.obj");
+		const auto spline = std::make_shared<Spline>(WHEATLEY_PATH);
+
+		// the room has about a dozen objects, the larger counts show how the per object cost scales
+		for (const unsigned count : { 16u, 65536u })
+		{
+			std::vector<GameObject> objects;
+			objects.reserve(count);
+			for (const auto& p : RoomPositions(rng, count))
+			{
+				objects.emplace_back(wheatley, p);
+				objects.back().RotationYAxis(p.x * 10.0f).Scale(glm::vec3(0.6f));
+			}
+
+			suite.Run("GameObject::GetModelMatrix", std::to_string(count) + " objects", 1.0, [&](unsigned i)
+			{
+				return objects[i % count].GetModelMatrix()[3][0];
+			});
+
+			// every moving entity carries three props, the second one holding the third like a hand holds a cup
+			const unsigned roots = std::max(count / 4, 1u);
+			const auto props = RoomPositions(rng, 3 * roots);
+			EntityStore store;
+			std::vector<Entity> handles;
+			for (unsigned r = 0; r < roots; ++r)
+			{
+				const Entity root = store.Create(wheatley, ZERO_VECTOR);
+				store.AttachMover(root, spline);
+				const Entity hand = store.Create(wheatley, props[3 * r + 1] * 0.1f, UNIT_MATRIX, EntityStore::QUEUED, root);
+				handles.push_back(root);
+				handles.push_back(hand);
+				handles.push_back(store.Create(wheatley, props[3 * r + 2] * 0.1f, UNIT_MATRIX, EntityStore::QUEUED, hand));
+				store.Create(wheatley, props[3 * r] * 0.1f, UNIT_MATRIX, EntityStore::QUEUED, root);
+			}
+
+			const std::string size = std::to_string(roots) + " moving + " + std::to_string(3 * roots) + " attached";
+			suite.Run("EntityStore::UpdateMovers", std::to_string(roots) + " movers", (double) roots, [&](unsigned i)
+			{
+				store.UpdateMovers(i * 0.013f);
+				return store.GetPosition(handles[0]).x;
+			});
+
+			// movers follow the spline and the props the chain of their parents
+			store.UpdateMovers(0.5f);
+			store.UpdateTransforms();
+			for (unsigned r = 0; r < roots; ++r)
+			{
+				const glm::mat4 expected = store.GetModelMatrix(handles[3 * r]) * glm::translate(UNIT_MATRIX, props[3 * r + 1] * 0.1f)
+					* glm::translate(UNIT_MATRIX, props[3 * r + 2] * 0.1f);
+				if (glm::any(glm::greaterThan(glm::abs(store.GetWorldPosition(handles[3 * r]) - spline->GetPosition(0.5f)), glm::vec3(0.0001f)))
+					|| glm::any(glm::greaterThan(glm::abs(store.GetModelMatrix(handles[3 * r + 2])[3] - expected[3]), glm::vec4(0.0001f))))
+				{
+					throw std::runtime_error("EntityStore: world matrix of an entity differs from the parent chain");
+				}
+			}
+
+			suite.Run("EntityStore::UpdateTransforms", size + ", all moved", 4.0 * roots, [&](unsigned i)
+			{
+				store.UpdateMovers(i * 0.013f);
+				store.UpdateTransforms();
+				return store.GetModelMatrixAt(0)[3][0];
+			});
+
+			suite.Run("EntityStore::UpdateTransforms", size + ", none moved", 4.0 * roots, [&](unsigned)
+			{
+				store.UpdateTransforms();
+				return store.GetModelMatrixAt(0)[3][0];
+			});
+
+			// views from random places of the room towards random other places
+			const auto eyes = RoomPositions(rng, INPUTS), targets = RoomPositions(rng, INPUTS);
+			const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.05f, 500.0f);
+			std::vector<glm::mat4> views(INPUTS);
+			for (unsigned v = 0; v < INPUTS; ++v) views[v] = projection * glm::lookAt(eyes[v], targets[v] + glm::vec3(0.01f), WORLD_UP);
+
+			// every entity whose center is in the frustum has to be kept
+			glm::vec3 min(INFINITY), max(-INFINITY);
+			for (const auto& mesh : wheatley->GetMeshes())
+			{
+				for (const auto& v : mesh->GetVertices())
+				{
+					min = glm::min(min, v.Position);
+					max = glm::max(max, v.Position);
+				}
+			}
+			const glm::vec4 center((min + max) * 0.5f, 1.0f);
+
+			std::vector<uint32_t> visible;
+			std::vector<uint8_t> kept(store.Size());
+			for (unsigned v = 0; v < 16; ++v)
+			{
+				store.Cull(visible, views[v]);
+				std::fill(kept.begin(), kept.end(), 0);
+				for (const uint32_t i : visible) kept[i] = 1;
+				for (uint32_t i = 0; i < store.Size(); ++i)
+				{
+					const glm::vec4 clip = views[v] * store.GetModelMatrixAt(i) * center;
+					const bool inside = std::abs(clip.x) < clip.w && std::abs(clip.y) < clip.w && std::abs(clip.z) < clip.w;
+					if (inside && !kept[i]) throw std::runtime_error("EntityStore: entity in the view was culled");
+				}
+			}
+
+			suite.Run("EntityStore::Cull", std::to_string(store.Size()) + " entities", (double) store.Size(), [&](unsigned i)
+			{
+				store.Cull(visible, views[i & (INPUTS - 1)]);
+				return (float) visible.size();
+			});
+
+			// frame of the game, movers and transforms followed by culling of the main view and every portal level
+			const unsigned VIEWS = 1 + 2 * PORTAL_MAX_ITERATIONS;
+			std::vector<std::vector<uint32_t>> serial(VIEWS), culled(VIEWS);
+			store.UpdateMovers(0.25f);
+			store.UpdateTransforms();
+			for (unsigned v = 0; v < VIEWS; ++v) store.Cull(serial[v], views[v], EntityStore::QUEUED);
+
+			std::vector<unsigned> threadCounts = { 1, 4 };
+			const unsigned all = std::max(1u, std::thread::hardware_concurrency());
+			if (all != 1 && all != 4) threadCounts.push_back(all);
+
+			for (const unsigned threads : threadCounts)
+			{
+				JobSystem jobs(threads);
+				const auto frame = [&](float time)
+				{
+					const unsigned movers = jobs.Add([&] { store.UpdateMovers(time); });
+					const unsigned transforms = jobs.Add([&] { store.UpdateTransforms(); }, { movers });
+					for (unsigned v = 0; v < VIEWS; ++v)
+					{
+						jobs.Add([&, v] { store.Cull(culled[v], views[v], EntityStore::QUEUED); }, { transforms });
+					}
+					jobs.Run();
+				};
+
+				frame(0.25f);
+				if (culled != serial) throw std::runtime_error("JobSystem: frame graph culled different entities than the serial frame");
+
+				suite.Run("JobSystem frame graph", std::to_string(VIEWS) + " views " + std::to_string(threads) + " threads",
+					(double) store.Size(), [&](unsigned i)
+				{
+					frame(i * 0.013f);
+					return (float) culled[0].size();
+				});
+			}
+
+			// commands of every view, each mesh of each visible entity, as the frame jobs record them
+			std::vector<CommandList> commands(VIEWS);
+			size_t draws = 0;
+			const auto record = [&]
+			{
+				draws = 0;
+				for (unsigned v = 0; v < VIEWS; ++v)
+				{
+					commands[v].Clear();
+					for (const uint32_t e : serial[v])
+					{
+						for (const auto& mesh : store.GetModelAt(e).GetMeshes()) commands[v].Draw(0, *mesh, store.GetModelMatrixAt(e));
+					}
+					draws += commands[v].DrawCount();
+				}
+			};
+			record();
+			suite.Run("CommandList::Draw", std::to_string(draws) + " draws " + std::to_string(VIEWS) + " views", (double) draws, [&](unsigned)
+			{
+				record();
+				return (float) commands[0].Commands().size();
+			});
+		}
+	}
+
+	int main(int argc, char** argv)
+	{
+		std::string filter, csv;
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--csv" && i + 1 < argc) csv = argv[++i];
+			else filter = arg;
+		}
+
+		// fixed seed, every run measures the same inputs
+		std::mt19937 rng(12345);
+		BenchmarkSuite suite(filter);
+
+		BenchmarkIntersections(suite, rng);
+		BenchmarkTriangleBlocks(suite, rng);
+		BenchmarkFloor(suite, rng);
+		BenchmarkScene(suite, rng);
+		BenchmarkRayBatches(suite, rng);
+		BenchmarkSplines(suite, rng);
+		BenchmarkPortals(suite, rng);
+		BenchmarkObjects(suite, rng);
+
+		std::cout << std::endl;
+		suite.Print(std::cout);
+
+		if (!csv.empty() && !suite.WriteCsv(csv))
+		{
+			std::cerr << "Cannot open " << csv << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		return kvasnric::main(argc, argv);
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << err.what() << std::endl;
+		return 1;
+	}
+}
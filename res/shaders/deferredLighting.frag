@@ -0,0 +1,110 @@
+#version 430
+
+// scalars are packed into the fourth components, see LightClusters
+struct SpotLight {
+	vec4 position;	// w range
+	vec4 direction;	// w inner cut off
+	vec4 diffuse;	// w outer cut off
+	vec4 specular;
+};
+
+struct DirectionalLight{
+	vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+	float intensity;
+};
+
+uniform sampler2D u_Position;
+uniform sampler2D u_Normal;
+uniform sampler2D u_Albedo;
+uniform sampler2D u_Specular;
+uniform sampler2D u_Ambient;
+uniform sampler2D u_View;
+uniform samplerCube u_CubeMap;
+
+layout( std430, binding = 1 ) readonly buffer SpotLights { SpotLight spots[]; };
+
+uniform int u_SpotLights;
+uniform vec3 u_SkyColor;
+
+out vec4 fragmentColor;
+
+// light is summed linearly, the sRGB framebuffer encodes the result once
+
+void main(){
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 normalShininess = texelFetch(u_Normal, pixel, 0);
+
+	// nothing was rendered into this pixel, keep the background
+	if( dot(normalShininess.xyz, normalShininess.xyz) < 0.5 ) discard;
+
+	vec4 positionVisibility = texelFetch(u_Position, pixel, 0);
+	vec4 albedoOcclusion = texelFetch(u_Albedo, pixel, 0);
+
+	vec3 fragmentPosition = positionVisibility.xyz;
+	vec3 normal = normalShininess.xyz;
+	float shininess = normalShininess.w;
+	vec3 diffuse = albedoOcclusion.rgb;
+	vec3 specular = texelFetch(u_Specular, pixel, 0).rgb;
+	vec3 ambient = texelFetch(u_Ambient, pixel, 0).rgb;
+	vec3 view = texelFetch(u_View, pixel, 0).xyz;
+
+	vec3 color = vec3(0.0);
+
+	for( int i = 0; i < u_SpotLights; ++i ){
+		SpotLight spot = spots[ i ];
+
+		vec3 light = vec3(0.0);
+		vec3 toLight = spot.position.xyz - fragmentPosition;
+		float dist = length( toLight );
+
+		vec3 L = toLight / dist;
+		float theta = dot(L, normalize(-spot.direction.xyz));
+
+		if( theta > spot.diffuse.w && dist < spot.position.w ){
+			vec3 R = reflect( -L, normal );
+			float transition = spot.direction.w - spot.diffuse.w;
+			float intensity = smoothstep( 0.0, 1.0, ( theta - spot.diffuse.w ) / transition );
+
+			light += ambient * 0.01;
+			light += intensity * diffuse * max( 0.0, dot( normal, L ) );
+			light += specular * spot.specular.rgb * pow( max( 0.0, dot( R, view ) ), shininess );
+			light *= spot.diffuse.rgb;
+
+			color += light;
+		}
+	}
+
+	DirectionalLight direct;
+	direct.direction = vec3( 0.0, 0.0, -1.0);
+	direct.ambient = vec3(0.2);
+	direct.diffuse = vec3(0.9, 0.8, 0.5);
+	direct.specular = vec3(0.2);
+	direct.intensity = 1.0;
+
+	vec3 light = vec3(0.0);
+	vec3 L = normalize(-direct.direction);
+	vec3 R = reflect(-L, normal);
+
+	light += ambient * direct.ambient;
+	light += diffuse * max( 0.0, dot( normal, L ) ) * direct.intensity;
+	light += specular * direct.specular * pow( max( 0.0, dot( R, view ) ), shininess );
+	light *= direct.diffuse;
+
+	color += light;
+
+	R = reflect(-view, normal);
+	float RdotV = max( 0.0, dot( -R, view ) );
+	vec3 cubeColor = texture(u_CubeMap, R).rgb;
+	float shine = pow( RdotV , shininess );
+	vec3 mixEnv = specular * shine;
+	mixEnv += ambient * 0.15;
+	mixEnv *= cubeColor;
+
+	// point lights are added later by light volumes with the same weight as the color here
+	vec3 finalColor = mix(color, mixEnv, 0.4) * albedoOcclusion.a;
+
+	fragmentColor = vec4(mix(u_SkyColor, finalColor, positionVisibility.w), 1.0);
+}
\ No newline at end of file
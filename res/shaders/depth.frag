@@ -0,0 +1,5 @@
+#version 430
+
+// only depth is written, color writes are masked during the pre-pass
+void main() {
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 430
+
+layout( location = 0 ) in vec3 in_Pos;
+
+uniform mat4 u_Projection;
+uniform mat4 u_View;
+uniform mat4 u_Model;
+
+// has to match entity.vert bit for bit, the shading pass compares depth with GL_EQUAL
+invariant gl_Position;
+
+void main() {
+	vec4 vertPos = u_Model * vec4(in_Pos, 1.0);
+	vec4 relativeToCamera = u_View * vertPos;
+	gl_Position = u_Projection * relativeToCamera;
+}
\ No newline at end of file
@@ -1,8 +1,8 @@
 #version 430
 
+// material features are compiled in by #define HAS_* preamble, see EntityShader
 struct Texture {
 	sampler2D source;
-	bool enabled;
 };
 
 struct Material {
@@ -12,21 +12,19 @@ struct Material {
     float shininess;
 };
 
+// scalars are packed into the fourth components, see LightClusters
 struct PointLight {
-	vec3 position;
-	vec3 diffuse;
-	vec3 specular;
-	vec3 ambient;
-	vec2 attenuation;
-	float intensity;
+	vec4 position;	// w radius
+	vec4 diffuse;	// w intensity
+	vec4 specular;	// w linear attenuation
+	vec4 ambient;	// w quadratic attenuation
 };
 
 struct SpotLight {
-	vec3 position;
-	vec3 direction;
-	vec3 diffuse;
-	vec3 specular;
-	vec2 cutOff;
+	vec4 position;	// w range
+	vec4 direction;	// w inner cut off
+	vec4 diffuse;	// w outer cut off
+	vec4 specular;
 };
 
 struct DirectionalLight{
@@ -45,44 +43,71 @@ struct FragUniforms{
 	Texture t_Roughness;
 	Texture t_Occlusion;
 	Texture t_Opacity;
-	PointLight point[10];
-	SpotLight spot[10];
 	DirectionalLight sun;
-	int pointLights;
-	int spotLights;
 	samplerCube cubeMap;
 	vec3 skyColor;
+	vec2 tileSize;		// size of a cluster tile in pixels
+	vec2 depthSlicing;	// near plane, slices per logarithmic depth
 };
 
+layout( std430, binding = 0 ) readonly buffer PointLights { PointLight points[]; };
+layout( std430, binding = 1 ) readonly buffer SpotLights { SpotLight spots[]; };
+// offset into the light indices, point light count, spot light count
+layout( std430, binding = 2 ) readonly buffer Clusters { uvec4 clusters[]; };
+layout( std430, binding = 3 ) readonly buffer LightIndices { uint lightIndices[]; };
+
+// cluster grid, the same as in LightClusters
+const ivec3 grid = ivec3(16, 9, 24);
+
 in VS_OUT {
 	vec3 FragmentPos;
 	vec3 View;
 	vec2 TexCoord;
 	mat3 TBN;
 	float Visibility;
+	float ViewDepth;
 } fs;
 
 uniform FragUniforms fu;
 
 out vec4 fragmentColor;
 
-const vec3 gamma = vec3(2.2);
-const vec3 gammaInv = vec3(0.454545454545454545454545454545454545);
+// colors are sampled from sRGB textures already linear and light is summed linearly,
+// the sRGB framebuffer encodes the result once
 
 DirectionalLight Sun;
 
 vec3 GetNormal(){
-	if( fu.t_Normal.enabled ){
-		vec3 normal = texture( fu.t_Normal.source, fs.TexCoord ).rgb * 2.0 - 1.0;
-		return normalize( fs.TBN * normal );
-	}
-
+#ifdef HAS_NORMAL
+	vec3 normal = texture( fu.t_Normal.source, fs.TexCoord ).rgb * 2.0 - 1.0;
+	return normalize( fs.TBN * normal );
+#else
 	return normalize( fs.TBN[2] );
+#endif
+}
+
+// fades the light out before its range so it can be culled without a visible edge
+float RangeWindow( float dist, float range ){
+	float ratio = dist / range;
+	float window = clamp( 1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0 );
+	return window * window;
+}
+
+uvec4 GetCluster(){
+	ivec2 tile = ivec2( gl_FragCoord.xy / fu.tileSize );
+	int slice = int( log( max( fs.ViewDepth, fu.depthSlicing.x ) / fu.depthSlicing.x ) * fu.depthSlicing.y );
+	ivec3 cell = clamp( ivec3( tile, slice ), ivec3(0), grid - 1 );
+
+	return clusters[ ( cell.z * grid.y + cell.y ) * grid.x + cell.x ];
 }
 
 vec4 ProcessLight(){
 	vec3 fragmentPosition = fs.FragmentPos;
-	vec3 specular = fu.t_Specular.enabled ? texture( fu.t_Specular.source, fs.TexCoord ).rgb : fu.material.specular;
+#ifdef HAS_SPECULAR
+	vec3 specular = texture( fu.t_Specular.source, fs.TexCoord ).rgb;
+#else
+	vec3 specular = fu.material.specular;
+#endif
 	vec3 ambient = fu.material.ambient;
 	vec3 diffuse = fu.material.diffuse;
 	float shininess = fu.material.shininess;
@@ -91,63 +116,69 @@ vec4 ProcessLight(){
 
 	vec3 view = normalize( fs.View );
 
-	if( fu.t_Diffuse.enabled ){
-		diffuse = pow(texture(fu.t_Diffuse.source, fs.TexCoord).rgb, gamma); 
-		ambient = diffuse;
-	}
+#ifdef HAS_DIFFUSE
+	diffuse = texture(fu.t_Diffuse.source, fs.TexCoord).rgb;
+	ambient = diffuse;
+#endif
 
-	if( fu.t_Roughness.enabled ){
-		float rough = texture( fu.t_Roughness.source, fs.TexCoord ).g;
-		float k = 1.999 / ( rough * rough );
-		shininess = k;
-		specular *= k;
-	}
+#ifdef HAS_ROUGHNESS
+	float rough = texture( fu.t_Roughness.source, fs.TexCoord ).g;
+	float k = 1.999 / ( rough * rough );
+	shininess = k;
+	specular *= k;
+#endif
 
 	vec3 color = vec3(0.0);
 
+	// only lights reaching the cluster of this fragment are iterated
+	uvec4 cluster = GetCluster();
+	uint pointEnd = cluster.x + cluster.y;
+	uint spotEnd = pointEnd + cluster.z;
+
 	// Calculating point lights
-	for( int i = 0; i < fu.pointLights; ++i){
-		const PointLight point = fu.point[ i ];
+	for( uint i = cluster.x; i < pointEnd; ++i){
+		const PointLight point = points[ lightIndices[ i ] ];
 
 		vec3 light = vec3(0.0);
 
-		const vec3 toLight = point.position - fragmentPosition;
+		const vec3 toLight = point.position.xyz - fragmentPosition;
 		const float dist = length( toLight );
-		const float attenuation = 1.0 / ( 1.0 + point.attenuation.x * dist + point.attenuation.y * dist * dist );
+		if( dist > point.position.w ) continue;
+
+		const float attenuation = RangeWindow( dist, point.position.w ) / ( 1.0 + point.specular.w * dist + point.ambient.w * dist * dist );
 
 		const vec3 L = toLight / dist; // normalize
 		const vec3 R = reflect( -L, normal );
 
-		light += ambient * point.ambient;
-		light += diffuse * max( 0.0, dot( normal, L ) ) * point.intensity;
-		light += specular * point.specular * pow( max( 0.0, dot( R, view ) ), shininess );
-		light *= attenuation * point.diffuse;
-		//light *= attenuation;
+		light += ambient * point.ambient.rgb;
+		light += diffuse * max( 0.0, dot( normal, L ) ) * point.diffuse.w;
+		light += specular * point.specular.rgb * pow( max( 0.0, dot( R, view ) ), shininess );
+		light *= attenuation * point.diffuse.rgb;
 
-		color += pow(light, gammaInv);
+		color += light;
 	}
 
-	for( int i = 0; i < fu.spotLights; ++i ){
-		SpotLight spot = fu.spot[ i ];
+	for( uint i = pointEnd; i < spotEnd; ++i ){
+		SpotLight spot = spots[ lightIndices[ i ] ];
 
 		vec3 light = vec3(0.0);
-		vec3 toLight = spot.position - fragmentPosition;
+		vec3 toLight = spot.position.xyz - fragmentPosition;
 		float dist = length( toLight );
 
 		vec3 L = toLight / dist;
-		float theta = dot(L, normalize(-spot.direction));
+		float theta = dot(L, normalize(-spot.direction.xyz));
 
-		if( theta > spot.cutOff.y ){
+		if( theta > spot.diffuse.w && dist < spot.position.w ){
 			vec3 R = reflect( -L, normal );
-			float transition = spot.cutOff.x - spot.cutOff.y;
-			float intensity = smoothstep( 0.0, 1.0, ( theta - spot.cutOff.y ) / transition );
+			float transition = spot.direction.w - spot.diffuse.w;
+			float intensity = smoothstep( 0.0, 1.0, ( theta - spot.diffuse.w ) / transition );
 
 			light += ambient * 0.01;
 			light += intensity * diffuse * max( 0.0, dot( normal, L ) );
-			light += specular * spot.specular * pow( max( 0.0, dot( R, view ) ), shininess );
-			light *= spot.diffuse;
+			light += specular * spot.specular.rgb * pow( max( 0.0, dot( R, view ) ), shininess );
+			light *= spot.diffuse.rgb;
 
-			color += pow(light, gammaInv);
+			color += light;
 		}
 	}
 
@@ -163,21 +194,24 @@ vec4 ProcessLight(){
 	light += specular * direct.specular * pow( max( 0.0, dot( R, view ) ), shininess );
 	light *= direct.diffuse;
 
-	color += pow(light, gammaInv);
+	color += light;
 
 	R = reflect(-view, normal);
 	float RdotV = max( 0.0, dot( -R, view ) );
-	vec3 cubeColor = pow(texture(fu.cubeMap, R).rgb, gamma);
+	vec3 cubeColor = texture(fu.cubeMap, R).rgb;
 	float shine = pow( RdotV , shininess );
 	vec3 mixEnv = specular * shine;
 	mixEnv += ambient * 0.15;
 	mixEnv *= cubeColor;
-	mixEnv = pow( mixEnv, gammaInv );
 
 	vec4 finalColor = vec4(mix(color, mixEnv, 0.4), 1.0);
 
-	if( fu.t_Occlusion.enabled ) finalColor.rgb *= texture( fu.t_Occlusion.source, fs.TexCoord ).rgb;
-	if( fu.t_Opacity.enabled ) finalColor.a *= texture( fu.t_Opacity.source, fs.TexCoord ).r;
+#ifdef HAS_OCCLUSION
+	finalColor.rgb *= texture( fu.t_Occlusion.source, fs.TexCoord ).rgb;
+#endif
+#ifdef HAS_OPACITY
+	finalColor.a *= texture( fu.t_Opacity.source, fs.TexCoord ).r;
+#endif
 
 	return finalColor;
 }
@@ -11,6 +11,7 @@ out VS_OUT {
 	vec2 TexCoord;
 	mat3 TBN;
 	float Visibility;
+	float ViewDepth;
 } fs;
 
 struct VertUniforms {
@@ -18,11 +19,13 @@ struct VertUniforms {
 	mat4 View;
 	mat4 Model;
 	vec3 ViewPosition;
-	bool Fog;
 };
 
 uniform VertUniforms vu;
 
+// depth pre-pass computes the same position in depth.vert, the shading pass tests it for equality
+invariant gl_Position;
+
 const float density = 0.05;
 const float gradient = 2.5;
 
@@ -41,10 +44,11 @@ void main() {
 	fs.FragmentPos = vertPos.xyz;
 	fs.TexCoord = in_TexCoord;
 	fs.View = normalize( vu.ViewPosition - vertPos.xyz );
+	fs.ViewDepth = -relativeToCamera.z;
 
 	fs.Visibility = 1.0f;
-	if( vu.Fog ){
-		float dist = length(relativeToCamera.xyz);
-		fs.Visibility = clamp(exp(-pow(dist*density, gradient)), 0.0, 1.0);
-	}
+#ifdef FOG
+	float dist = length(relativeToCamera.xyz);
+	fs.Visibility = clamp(exp(-pow(dist*density, gradient)), 0.0, 1.0);
+#endif
 }
\ No newline at end of file
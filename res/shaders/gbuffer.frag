@@ -0,0 +1,87 @@
+#version 430
+
+// material features are compiled in by #define HAS_* preamble, see EntityShader
+struct Texture {
+	sampler2D source;
+};
+
+struct Material {
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+    float shininess;
+};
+
+struct FragUniforms{
+	Material material;
+	Texture t_Diffuse;
+	Texture t_Specular;
+	Texture t_Normal;
+	Texture t_Roughness;
+	Texture t_Occlusion;
+};
+
+in VS_OUT {
+	vec3 FragmentPos;
+	vec3 View;
+	vec2 TexCoord;
+	mat3 TBN;
+	float Visibility;
+	float ViewDepth;
+} fs;
+
+uniform FragUniforms fu;
+
+// index of the portal iteration the geometry is rendered in
+uniform float u_Level;
+
+layout( location = 0 ) out vec4 gPosition;
+layout( location = 1 ) out vec4 gNormal;
+layout( location = 2 ) out vec4 gAlbedo;
+layout( location = 3 ) out vec4 gSpecular;
+layout( location = 4 ) out vec4 gAmbient;
+layout( location = 5 ) out vec4 gView;
+
+vec3 GetNormal(){
+#ifdef HAS_NORMAL
+	vec3 normal = texture( fu.t_Normal.source, fs.TexCoord ).rgb * 2.0 - 1.0;
+	return normalize( fs.TBN * normal );
+#else
+	return normalize( fs.TBN[2] );
+#endif
+}
+
+void main(){
+#ifdef HAS_SPECULAR
+	vec3 specular = texture( fu.t_Specular.source, fs.TexCoord ).rgb;
+#else
+	vec3 specular = fu.material.specular;
+#endif
+	vec3 ambient = fu.material.ambient;
+	vec3 diffuse = fu.material.diffuse;
+	float shininess = fu.material.shininess;
+	float occlusion = 1.0;
+
+#ifdef HAS_DIFFUSE
+	diffuse = texture(fu.t_Diffuse.source, fs.TexCoord).rgb;
+	ambient = diffuse;
+#endif
+
+#ifdef HAS_ROUGHNESS
+	float rough = texture( fu.t_Roughness.source, fs.TexCoord ).g;
+	float k = 1.999 / ( rough * rough );
+	shininess = k;
+	specular *= k;
+#endif
+
+#ifdef HAS_OCCLUSION
+	occlusion = texture( fu.t_Occlusion.source, fs.TexCoord ).r;
+#endif
+
+	gPosition = vec4(fs.FragmentPos, fs.Visibility);
+	gNormal = vec4(GetNormal(), shininess);
+	gAlbedo = vec4(diffuse, occlusion);
+	gSpecular = vec4(specular, 1.0);
+	gAmbient = vec4(ambient, 1.0);
+	gView = vec4(normalize(fs.View), u_Level);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#version 330
+
+struct PointLight {
+	vec3 position;
+	vec3 diffuse;
+	vec3 specular;
+	vec3 ambient;
+	vec2 attenuation;
+	float intensity;
+};
+
+uniform sampler2D u_Position;
+uniform sampler2D u_Normal;
+uniform sampler2D u_Albedo;
+uniform sampler2D u_Specular;
+uniform sampler2D u_Ambient;
+uniform sampler2D u_View;
+
+uniform PointLight u_Light;
+uniform float u_Radius;
+uniform float u_Level;
+
+out vec4 fragmentColor;
+
+// the same fade out as in entity.frag
+float RangeWindow( float dist, float range ){
+	float ratio = dist / range;
+	float window = clamp( 1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0 );
+	return window * window;
+}
+
+void main(){
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 viewLevel = texelFetch(u_View, pixel, 0);
+	vec4 normalShininess = texelFetch(u_Normal, pixel, 0);
+
+	// volume is rasterized with the view of one portal iteration only
+	if( viewLevel.w != u_Level || dot(normalShininess.xyz, normalShininess.xyz) < 0.5 ) discard;
+
+	vec4 positionVisibility = texelFetch(u_Position, pixel, 0);
+	vec3 toLight = u_Light.position - positionVisibility.xyz;
+	float dist = length( toLight );
+	if( dist > u_Radius ) discard;
+
+	vec4 albedoOcclusion = texelFetch(u_Albedo, pixel, 0);
+	vec3 normal = normalShininess.xyz;
+	vec3 diffuse = albedoOcclusion.rgb;
+	vec3 specular = texelFetch(u_Specular, pixel, 0).rgb;
+	vec3 ambient = texelFetch(u_Ambient, pixel, 0).rgb;
+
+	float attenuation = RangeWindow( dist, u_Radius ) / ( 1.0 + u_Light.attenuation.x * dist + u_Light.attenuation.y * dist * dist );
+
+	vec3 L = toLight / dist;
+	vec3 R = reflect( -L, normal );
+
+	vec3 light = vec3(0.0);
+	light += ambient * u_Light.ambient;
+	light += diffuse * max( 0.0, dot( normal, L ) ) * u_Light.intensity;
+	light += specular * u_Light.specular * pow( max( 0.0, dot( R, viewLevel.xyz ) ), normalShininess.w );
+	light *= attenuation * u_Light.diffuse;
+
+	// same weight as the lights in the forward shader after mixing with environment, occlusion and fog
+	fragmentColor = vec4(light * 0.6 * albedoOcclusion.a * positionVisibility.w, 1.0);
+}
\ No newline at end of file
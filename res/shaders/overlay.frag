@@ -0,0 +1,34 @@
+#version 330
+
+out vec4 fragmentColor;
+
+// character codes of the text, one texel per character
+uniform usampler2D u_Text;
+// 3x5 glyphs of ascii 32 to 95, five rows of three bits from the top
+uniform int u_Font[64];
+// top left corner of the text in window pixels
+uniform vec2 u_Origin;
+// window pixels per glyph pixel
+uniform int u_Scale;
+// columns and rows of the text
+uniform vec2 u_Size;
+
+void main(){
+	// glyph pixel coordinates from the top left corner, every character cell has a one pixel gap
+	vec2 offset = vec2(gl_FragCoord.x - u_Origin.x, u_Origin.y - gl_FragCoord.y);
+	if(offset.x < 0.0 || offset.y < 0.0) discard;
+
+	ivec2 px = ivec2(offset) / u_Scale;
+	ivec2 cell = px / ivec2(4, 6);
+	if(cell.x >= int(u_Size.x) || cell.y >= int(u_Size.y)) discard;
+
+	ivec2 glyphPx = px - cell * ivec2(4, 6);
+	int c = int(texelFetch(u_Text, cell, 0).r);
+
+	bool lit = false;
+	if(glyphPx.x < 3 && glyphPx.y < 5 && c >= 32 && c < 96){
+		lit = ((u_Font[c - 32] >> ((4 - glyphPx.y) * 3 + 2 - glyphPx.x)) & 1) != 0;
+	}
+
+	fragmentColor = lit ? vec4(1.0) : vec4(0.0, 0.0, 0.0, 0.6);
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 330
+
+out vec4 fragmentColor;
+
+in vec4 v_TextureClip;
+
+// view through the portal rendered from the same camera is sampled in screen space,
+// view of another camera where the portal appeared on its screen
+uniform sampler2D u_View;
+uniform vec2 u_Resolution;
+uniform bool u_ScreenSpace;
+
+void main(){
+	vec2 uv = u_ScreenSpace ? gl_FragCoord.xy / u_Resolution : v_TextureClip.xy / v_TextureClip.w * 0.5 + 0.5;
+	fragmentColor = texture(u_View, uv);
+}
\ No newline at end of file
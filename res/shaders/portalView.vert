@@ -0,0 +1,14 @@
+#version 330
+
+layout(location=0) in vec3 in_Pos;
+
+uniform mat4 u_PVM;
+// where the portal the view was rendered through lies on the screen of its camera
+uniform mat4 u_TexturePVM;
+
+out vec4 v_TextureClip;
+
+void main() {
+	gl_Position = u_PVM * vec4(in_Pos, 1.0);
+	v_TextureClip = u_TexturePVM * vec4(in_Pos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330
+
+in vec2 TexCoord;
+
+out vec4 fragmentColor;
+
+uniform sampler2D u_Screen;
+
+void main(){
+	fragmentColor = vec4(texture(u_Screen, TexCoord).rgb, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330
+
+out vec2 TexCoord;
+
+void main() {
+	// one triangle covering the whole screen, clockwise so it survives the front face culling
+	vec2 pos = vec2(gl_VertexID & 2, (gl_VertexID << 1) & 2);
+	TexCoord = pos;
+	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BenchmarkReport.cpp
+ * \author     Richard Kvasnica
+ * \brief      Benchmark report class definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "BenchmarkReport.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace kvasnric
+{
+	void BenchmarkReport::Write(const std::string& path) const
+	{
+		std::ofstream os(path, std::ios::out | std::ios::trunc);
+		if (!os.is_open())
+			throw std::runtime_error("Cannot write benchmark results to " + path);
+
+		char line[160];
+		os << "{\n\t\"phases\": [";
+
+		// frames of a phase follow each other
+		for (size_t begin = 0; begin < m_Frames.size();)
+		{
+			size_t end = begin;
+			while (end < m_Frames.size() && m_Frames[end].Levels == m_Frames[begin].Levels) ++end;
+
+			os << (begin == 0 ? "\n" : ",\n") << "\t\t{ \"levels\": " << m_Frames[begin].Levels << ", \"frames\": " << end - begin << ", ";
+			WriteSummary(os, std::vector<Frame>(m_Frames.begin() + begin, m_Frames.begin() + end));
+			os << " }";
+			begin = end;
+		}
+
+		os << "\n\t],\n\t\"total\": { \"frames\": " << m_Frames.size() << ", ";
+		WriteSummary(os, m_Frames);
+		os << " },\n\t\"frames\": [";
+
+		for (size_t i = 0; i < m_Frames.size(); ++i)
+		{
+			const auto& f = m_Frames[i];
+			std::snprintf(line, sizeof(line),
+				"%s\n\t\t{ \"levels\": %d, \"blue\": %d, \"orange\": %d, \"cpu_ms\": %.4f, \"gpu_ms\": %.4f, \"draws\": %u }",
+				i == 0 ? "" : ",", f.Levels, f.Blue, f.Orange, f.Cpu, f.Gpu, f.Draws);
+			os << line;
+		}
+		os << "\n\t]\n}\n";
+	}
+
+	void BenchmarkReport::WriteSummary(std::ostream& os, const std::vector<Frame>& frames)
+	{
+		std::vector<float> cpu, gpu, draws;
+		for (const auto& f : frames)
+		{
+			cpu.push_back(f.Cpu);
+			gpu.push_back(f.Gpu);
+			draws.push_back((float) f.Draws);
+		}
+
+		WriteStatistics(os, "cpu_ms", cpu);
+		os << ", ";
+		WriteStatistics(os, "gpu_ms", gpu);
+		os << ", ";
+		WriteStatistics(os, "draws", draws);
+	}
+
+	void BenchmarkReport::WriteStatistics(std::ostream& os, const char* name, std::vector<float> values)
+	{
+		float min = 0.0f, avg = 0.0f, p99 = 0.0f;
+		if (!values.empty())
+		{
+			std::sort(values.begin(), values.end());
+			min = values.front();
+			for (const float v : values) avg += v;
+			avg /= values.size();
+			p99 = values[std::min(values.size() - 1, (size_t) (0.99f * values.size()))];
+		}
+
+		char text[128];
+		std::snprintf(text, sizeof(text), "\"%s\": { \"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f }", name, min, avg, p99);
+		os << text;
+	}
+}
@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BenchmarkReport.hpp
+ * \author     Richard Kvasnica
+ * \brief      Benchmark report class declaration
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kvasnric
+{
+	// Collects timings of the benchmark frames and writes them with their summaries as json
+	class BenchmarkReport
+	{
+	public:
+		// measurements of one rendered frame
+		struct Frame
+		{
+			// recursion level limit of the phase and levels of each portal rendered in the frame
+			int Levels;
+			int Blue;
+			int Orange;
+			float Cpu;
+			float Gpu;
+			unsigned Draws;
+		};
+
+		/**
+		 * Appends a frame, frames of one phase are expected to share the recursion level limit
+		 */
+		inline void Add(const Frame& frame) { m_Frames.push_back(frame); }
+
+		/**
+		 * Writes min, average and 99th percentile of every phase and of all frames, followed by the frames themselves
+		 * @param path path of the json file
+		 */
+		void Write(const std::string& path) const;
+	private:
+		/**
+		 * Writes min, average and 99th percentile of cpu time, gpu time and draw calls of the frames
+		 */
+		static void WriteSummary(std::ostream& os, const std::vector<Frame>& frames);
+		static void WriteStatistics(std::ostream& os, const char* name, std::vector<float> values);
+
+		std::vector<Frame> m_Frames;
+	};
+}
@@ -13,7 +13,10 @@
 #include <pgr.h>
 #include <IO/Keyboard.hpp>
 #include <IO/Mouse.hpp>
+#include <Renderer/FrameSync.hpp>
+#include <Renderer/ProgramCache.hpp>
 
+#include <chrono>
 #include <iostream>
 
 namespace kvasnric
@@ -25,7 +28,6 @@ namespace kvasnric
 
 	// Inits static class members of glut wrapper
 	OpenGLApplication* GLUTWrapper::s_App = nullptr;
-	int GLUTWrapper::s_RefreshTimeMs = 33;
 	bool GLUTWrapper::s_WindowActive = false;
 	bool GLUTWrapper::s_Repeat = true;
 	int GLUTWrapper::s_CenterX = 0;
@@ -37,7 +39,7 @@ namespace kvasnric
 	const int OGL_VER_MINOR = 1;
 
 
-	void GLUTWrapper::Init(int argc, char** argv, OpenGLApplication* app)
+	void GLUTWrapper::CreateContext(int argc, char** argv, OpenGLApplication* app, unsigned displayMode)
 	{
 		if (!app)
 			throw std::runtime_error("Cannot initialize context with nonexistent application.");
@@ -48,7 +50,7 @@ namespace kvasnric
 		glutInitContextVersion(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR);
 		glutInitContextFlags(GLUT_FORWARD_COMPATIBLE);
 
-		glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH | GLUT_MULTISAMPLE | GLUT_STENCIL);
+		glutInitDisplayMode(displayMode);
 		glutInitWindowSize(s_App->Width(), s_App->Height());
 
 		glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
@@ -61,6 +63,11 @@ namespace kvasnric
 		s_App->Init();
 		s_App->LoadResources();
 		s_App->Setup();
+	}
+
+	void GLUTWrapper::Init(int argc, char** argv, OpenGLApplication* app)
+	{
+		CreateContext(argc, argv, app, GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH | GLUT_MULTISAMPLE | GLUT_STENCIL | GLUT_SRGB);
 
 		glutSetCursor(GLUT_CURSOR_CROSSHAIR);
 		glutFullScreenToggle();
@@ -71,7 +78,7 @@ namespace kvasnric
 		glutWarpPointer(s_CenterX, s_CenterY);
 		Mouse::SetOriginPosition(s_CenterX, s_CenterY);
 
-		s_App->SetCurrentTime(glutGet(GLUT_ELAPSED_TIME));
+		s_App->ResetClock(Now());
 		// Assign all callbacks to glut 
 		glutDisplayFunc(GLUTWrapper::OnDisplay);
 		glutReshapeFunc(GLUTWrapper::OnReshape);
@@ -79,7 +86,7 @@ namespace kvasnric
 		glutKeyboardUpFunc(GLUTWrapper::OnKeyUp);
 		glutSpecialFunc(GLUTWrapper::OnSpecialKey);
 		glutSpecialUpFunc(GLUTWrapper::OnSpecialKeyUp);
-		glutTimerFunc(s_RefreshTimeMs, GLUTWrapper::OnTimer, 0);
+		glutIdleFunc(GLUTWrapper::OnIdle);
 		glutMotionFunc(GLUTWrapper::OnActiveMouseMotion);
 		glutMouseFunc(GLUTWrapper::OnMouse);
 		glutPassiveMotionFunc(GLUTWrapper::OnMouseMotion);
@@ -87,21 +94,43 @@ namespace kvasnric
 		glutEntryFunc(GLUTWrapper::OnWindowFocus);
 	}
 
+	void GLUTWrapper::InitHeadless(int argc, char** argv, OpenGLApplication* app)
+	{
+		// the application renders into its own framebuffer, the window only holds the context
+		CreateContext(argc, argv, app, GLUT_RGBA | GLUT_DEPTH | GLUT_STENCIL);
+		glutHideWindow();
+
+		// no reshape callback comes without the main loop
+		s_App->ResizeWindow(s_App->Width(), s_App->Height());
+	}
+
 	void GLUTWrapper::Run()
 	{
 		glutMainLoop();
 		Destroy();
 	}
 
+	void GLUTWrapper::RunBenchmark(const std::string& output)
+	{
+		s_App->Benchmark(output);
+		Destroy();
+	}
+
 
 	void GLUTWrapper::Destroy()
 	{
+		// resources are deleted while no frame uses them
+		FrameSync::Flush();
+		// variants compiled while running are kept for the next launch too
+		ProgramCache::Shutdown();
 		delete s_App;
 	}
 
-	void GLUTWrapper::SetRefreshTime(int time)
+	double GLUTWrapper::Now()
 	{
-		s_RefreshTimeMs = time;
+		// GLUT_ELAPSED_TIME has only millisecond resolution, a 144 Hz frame is about 7 ms long
+		using namespace std::chrono;
+		return duration<double>(steady_clock::now().time_since_epoch()).count();
 	}
 
 
@@ -114,8 +143,10 @@ namespace kvasnric
 
 	void GLUTWrapper::OnDisplay()
 	{
+		FrameSync::BeginFrame();
 		s_App->Render();
 		glutSwapBuffers();
+		FrameSync::EndFrame();
 	}
 
 	void GLUTWrapper::OnKey(unsigned char key, int x, int y)
@@ -159,7 +190,7 @@ namespace kvasnric
 		}
 	}
 
-	void GLUTWrapper::OnTimer(int id)
+	void GLUTWrapper::OnIdle()
 	{
 		// if the window is not closing and app is supposed to run 
 		if (s_Repeat && s_App->IsRunning())
@@ -167,15 +198,14 @@ namespace kvasnric
 			// if my cursor is not focus on games window
 			if( s_WindowActive )
 			{
-				// get glut time and update the apps timer
-				const int time = glutGet(GLUT_ELAPSED_TIME);
-				s_App->Timer(id, time);
+				// the GPU may still render the previous frames, the input is read once it caught up enough
+				// so it reaches the screen at most FRAMES_IN_FLIGHT frames later
+				FrameSync::BeginFrame();
+				s_App->Timer(Now());
 				glutPostRedisplay();
 				glutWarpPointer(s_CenterX, s_CenterY);
 				glutSetCursor(GLUT_CURSOR_CROSSHAIR);
 			}
-			
-			glutTimerFunc(s_RefreshTimeMs, GLUTWrapper::OnTimer, ++id);
 		}
 		else
 		{
@@ -217,7 +247,7 @@ namespace kvasnric
 
 	void GLUTWrapper::OnClose()
 	{
-		// if the window is about the close cancel the timer
+		// if the window is about the close stop the main loop
 		s_Repeat = false;
 	}
 
@@ -227,7 +257,7 @@ namespace kvasnric
 		s_WindowActive = state;
 		glutWarpPointer(s_CenterX, s_CenterY);
 		Mouse::SetOriginPosition(s_CenterX, s_CenterY);
-		s_App->SetCurrentTime(glutGet(GLUT_ELAPSED_TIME));
+		s_App->ResetClock(Now());
 	}
 
 }
\ No newline at end of file
@@ -26,11 +26,26 @@ namespace kvasnric
 		 */
 		static void Init(int argc, char** argv, OpenGLApplication* app);
 
+		/**
+		 * Initializes glut and opengl context with a hidden window that receives no input, used by the benchmark.
+		 * Without a GPU the context can be created by Mesa llvmpipe.
+		 * @param argc terminal argument count
+		 * @param argv terminal argument values
+		 * @param app pointer to existing openglapplication
+		 */
+		static void InitHeadless(int argc, char** argv, OpenGLApplication* app);
+
 		/**
 		 * Calls GLUTMainLoop and destroys the application when the loop ends
 		 */
 		static void Run();
 
+		/**
+		 * Runs the benchmark of the application instead of the main loop and destroys the application
+		 * @param output path of the written results
+		 */
+		static void RunBenchmark(const std::string& output);
+
 		/**
 		 * Terminates with error by calling function of pgr framework to die with error.
 		 */
@@ -42,12 +57,16 @@ namespace kvasnric
 		static void Destroy();
 
 		/**
-		 * Sets timer refresh time. The interval between timer updates.
-		 * @param time time in milliseconds
+		 * @returns time since an arbitrary point in seconds with sub millisecond precision
 		 */
-		static void SetRefreshTime(int time);
+		static double Now();
 	private:
-		
+		/**
+		 * Creates the window with opengl context and lets the application load its resources
+		 * @param displayMode glut display mode flags of the window
+		 */
+		static void CreateContext(int argc, char** argv, OpenGLApplication* app, unsigned displayMode);
+
 		/**
 		 * Calls render function of an OpenGLApplication instance and swaps buffers.
 		 */
@@ -80,11 +99,11 @@ namespace kvasnric
 		static void OnReshape(int width, int height);
 
 		/**
-		 * Periodical callback that calls timer method of OpenGLApplication.
+		 * Idle callback that calls timer method of OpenGLApplication and requests a new frame.
 		 * Checks if an app is still running.
 		 * Teleports cursor back to the center of the screen
 		 */
-		static void OnTimer(int id);
+		static void OnIdle();
 
 		/**
 		 * Registers mouse motion to mouse class.
@@ -110,7 +129,6 @@ namespace kvasnric
 
 		static OpenGLApplication* s_App;
 
-		static int s_RefreshTimeMs;
 		static bool s_Repeat;
 		static bool s_WindowActive;
 		static int s_CenterX;
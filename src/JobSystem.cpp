@@ -0,0 +1,233 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       JobSystem.cpp
+ * \author     Richard Kvasnica
+ * \brief      Work stealing scheduler of job graphs definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace kvasnric
+{
+	// no job has this id
+	static const unsigned NONE = 0xffffffffu;
+
+	JobSystem::JobSystem(unsigned threads)
+		: m_Remaining(0), m_Awaited(NONE), m_Queued(0), m_Stop(false)
+	{
+		if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+		for (unsigned i = 0; i < threads; ++i) m_Deques.emplace_back(new Deque());
+
+		// the thread calling Run owns the first deque
+		for (unsigned i = 1; i < threads; ++i) m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+		m_Wake.notify_all();
+
+		for (auto& worker : m_Workers) worker.join();
+	}
+
+	unsigned JobSystem::Add(std::function<void()> work, std::initializer_list<unsigned> dependencies)
+	{
+		m_Jobs.push_back({ std::move(work), {}, 0 });
+		const unsigned id = (unsigned) m_Jobs.size() - 1;
+
+		for (const unsigned dependency : dependencies) Depend(id, dependency);
+		return id;
+	}
+
+	void JobSystem::Depend(unsigned job, unsigned dependency)
+	{
+		// a job can only wait for the ones added before it, so the graph never has a cycle
+		if (job >= m_Jobs.size() || dependency >= job) throw std::runtime_error("Job can depend only on a job added before it");
+
+		m_Jobs[dependency].Dependents.push_back(job);
+		++m_Jobs[job].Dependencies;
+	}
+
+	void JobSystem::Push(unsigned self, unsigned job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Deques[self]->Mutex);
+			m_Deques[self]->Jobs.push_back(job);
+		}
+		++m_Queued;
+
+		// sleeping thread checks the counter under the lock, so the notification cannot slip between its check and its wait
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Wake.notify_one();
+	}
+
+	bool JobSystem::Take(unsigned self, unsigned& job)
+	{
+		const unsigned count = (unsigned) m_Deques.size();
+		for (unsigned i = 0; i < count; ++i)
+		{
+			Deque& deque = *m_Deques[(self + i) % count];
+			std::lock_guard<std::mutex> lock(deque.Mutex);
+			if (deque.Jobs.empty()) continue;
+
+			// own deque is used like a stack, the freshest job has its data in the cache, thieves take the oldest one
+			if (i == 0)
+			{
+				job = deque.Jobs.back();
+				deque.Jobs.pop_back();
+			}
+			else
+			{
+				job = deque.Jobs.front();
+				deque.Jobs.pop_front();
+			}
+			--m_Queued;
+			return true;
+		}
+		return false;
+	}
+
+	void JobSystem::Execute(unsigned self, unsigned job)
+	{
+		m_Jobs[job].Work();
+
+		for (const unsigned dependent : m_Jobs[job].Dependents)
+		{
+			if (--m_Pending[dependent] == 0) Push(self, dependent);
+		}
+
+		m_Done[job] = true;
+		if (--m_Remaining == 0 || job == m_Awaited)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Wake.notify_all();
+		}
+	}
+
+	void JobSystem::WorkerLoop(unsigned self)
+	{
+		for (;;)
+		{
+			unsigned job;
+			if (Take(self, job))
+			{
+				Execute(self, job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [&] { return m_Stop || m_Queued > 0; });
+			if (m_Stop) return;
+		}
+	}
+
+	void JobSystem::Run()
+	{
+		Start();
+		Finish();
+	}
+
+	void JobSystem::Start()
+	{
+		if (m_Jobs.empty()) return;
+
+		const unsigned count = (unsigned) m_Jobs.size();
+		m_Pending.reset(new std::atomic<unsigned>[count]);
+		m_Done.reset(new std::atomic<bool>[count]);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			m_Pending[i] = m_Jobs[i].Dependencies;
+			m_Done[i] = false;
+		}
+		m_Remaining = count;
+
+		// jobs without dependencies are dealt to all deques, the rest is pushed as they get unblocked
+		unsigned next = 0;
+		for (unsigned i = 0; i < count; ++i)
+		{
+			if (m_Jobs[i].Dependencies == 0) Push(next++ % ThreadCount(), i);
+		}
+	}
+
+	void JobSystem::Wait(unsigned job)
+	{
+		if (job >= m_Jobs.size() || !m_Done) throw std::runtime_error("Job can be waited for only in a started graph");
+
+		// the job is published before its flag is checked, a thread finishing it in between sees it and wakes this one
+		m_Awaited = job;
+		while (!m_Done[job])
+		{
+			unsigned next;
+			if (Take(0, next))
+			{
+				Execute(0, next);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [&] { return m_Queued > 0 || m_Done[job]; });
+		}
+		m_Awaited = NONE;
+	}
+
+	void JobSystem::Finish()
+	{
+		if (m_Jobs.empty()) return;
+
+		while (m_Remaining > 0)
+		{
+			unsigned job;
+			if (Take(0, job))
+			{
+				Execute(0, job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [&] { return m_Queued > 0 || m_Remaining == 0; });
+		}
+
+		// no thread touches the jobs once the last one finished
+		m_Jobs.clear();
+		m_Pending.reset();
+		m_Done.reset();
+	}
+
+	void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+	{
+		if (count == 0) return;
+		grain = std::max<size_t>(grain, 1);
+
+		// waking the workers costs more than a single chunk
+		if (ThreadCount() == 1 || count <= grain)
+		{
+			body(0, count);
+			return;
+		}
+
+		if (!m_Jobs.empty()) throw std::runtime_error("Parallel loop cannot run while a graph is being built");
+
+		// chunks are picked by advancing the counter, so a slow chunk does not hold back the rest of its thread's share
+		std::atomic<size_t> next(0);
+		const size_t chunks = (count + grain - 1) / grain;
+		for (size_t i = 0; i < std::min<size_t>(chunks, ThreadCount()); ++i)
+		{
+			Add([&]
+			{
+				for (size_t begin = next.fetch_add(grain); begin < count; begin = next.fetch_add(grain))
+				{
+					body(begin, std::min(begin + grain, count));
+				}
+			});
+		}
+		Run();
+	}
+}
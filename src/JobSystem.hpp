@@ -0,0 +1,140 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       JobSystem.hpp
+ * \author     Richard Kvasnica
+ * \brief      Work stealing scheduler of job graphs declaration
+ *
+ * Work of a frame is described as a graph of jobs, every job counts the jobs it still waits for.
+ * Every thread has its own deque of ready jobs, it takes the newest one from its back and when it
+ * runs dry it steals the oldest one from the front of another deque. A finished job pushes the
+ * jobs it unblocked to the deque of its thread, so dependent work tends to stay on one core.
+ * Parallel loops, like batches of rays, run on the same threads.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kvasnric
+{
+	class JobSystem
+	{
+	public:
+		/**
+		 * Starts the workers, they sleep until a graph is run
+		 * @param threads number of threads running the jobs including the calling one, zero takes all hardware threads
+		 */
+		explicit JobSystem(unsigned threads = 0);
+
+		/**
+		 * Wakes the workers up and joins them
+		 */
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		/**
+		 * Adds a job to the graph run by the next Run or Start, not while a started graph is running
+		 * @param work function run by one of the threads, it must not throw
+		 * @param dependencies ids of the jobs which have to finish before this one starts
+		 * @returns id of the job, valid until the end of the next Run
+		 */
+		unsigned Add(std::function<void()> work, std::initializer_list<unsigned> dependencies = {});
+
+		/**
+		 * Makes the job wait for another one, both have to be added already
+		 */
+		void Depend(unsigned job, unsigned dependency);
+
+		/**
+		 * Runs the graph and returns when all of its jobs are done, the calling thread runs jobs too.
+		 * The graph is empty again afterwards.
+		 */
+		void Run();
+
+		/**
+		 * Starts the graph and returns right away, the workers run its jobs while the calling thread does other work.
+		 * The calling thread helps only inside Wait and Finish, so with a single thread nothing runs before them.
+		 */
+		void Start();
+
+		/**
+		 * Runs jobs of the started graph on the calling thread until the given one is done
+		 * @param job id of a job of the started graph
+		 */
+		void Wait(unsigned job);
+
+		/**
+		 * Returns when all jobs of the started graph are done, the graph is empty again afterwards
+		 */
+		void Finish();
+
+		/**
+		 * Runs the body over [0, count) in chunks of grain items and returns when all of them are done. The loop is
+		 * a graph of its own, one job per thread takes chunks until none is left. Called from the thread calling Run
+		 * while no graph is being built, the body must not throw.
+		 * @param grain number of items one call of the body gets, the last chunk may be smaller
+		 * @param body function called with the begin and end of a chunk
+		 */
+		void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+		/**
+		 * @returns number of threads running the jobs including the calling one
+		 */
+		inline unsigned ThreadCount() const { return (unsigned) m_Deques.size(); }
+	private:
+		struct Job
+		{
+			std::function<void()> Work;
+			// jobs waiting for this one
+			std::vector<unsigned> Dependents;
+			unsigned Dependencies;
+		};
+
+		struct Deque
+		{
+			std::mutex Mutex;
+			std::deque<unsigned> Jobs;
+		};
+
+		void WorkerLoop(unsigned self);
+
+		/**
+		 * Pops a job of the own deque, steals one from the others when it is empty
+		 * @returns bool whether a job was found
+		 */
+		bool Take(unsigned self, unsigned& job);
+
+		void Push(unsigned self, unsigned job);
+		void Execute(unsigned self, unsigned job);
+
+		std::vector<std::thread> m_Workers;
+		// deque of the calling thread is the first one
+		std::vector<std::unique_ptr<Deque>> m_Deques;
+
+		// graph being built or run
+		std::vector<Job> m_Jobs;
+		std::unique_ptr<std::atomic<unsigned>[]> m_Pending;
+		std::unique_ptr<std::atomic<bool>[]> m_Done;
+		std::atomic<unsigned> m_Remaining;
+		// job the calling thread waits for, its end wakes it up like the end of the graph
+		std::atomic<unsigned> m_Awaited;
+
+		// jobs pushed and not taken yet, threads sleep while there are none
+		std::atomic<int> m_Queued;
+		std::mutex m_Mutex;
+		std::condition_variable m_Wake;
+		bool m_Stop;
+	};
+}
@@ -51,7 +51,7 @@ namespace kvasnric
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		SetUniformMat3(u_CursorMatrix, m_CursorMatrix);
-		glDrawArrays(GL_TRIANGLES, 0, m_Count);
+		RenderArrays(m_Count);
 		
 		glEnable(GL_DEPTH_TEST);
 		glDisable(GL_BLEND);
@@ -12,11 +12,13 @@
 
 #include "pgr.h"
 
+#include <stdexcept>
+
 namespace kvasnric
 {
 	OpenGLApplication::OpenGLApplication(int width, int height, const char* title)
-		: Window(width, height, title), m_CurrentTimeMs(0), m_CurrentTime(0)
-		, m_TimeDelta(0), m_Run( true )
+		: Window(width, height, title), m_CurrentTime(0), m_TimeDelta(SIMULATION_STEP)
+		, m_Alpha(1.0f), m_Run( true ), m_LastTime(0.0), m_Accumulator(0.0)
 	{
 	}
 
@@ -25,6 +27,8 @@ namespace kvasnric
 		EnableCulling();
 		SetDepthTest(true);
 		SetMultiSampling(true);
+		SetSrgbFramebuffer(true);
+		SetVSync(true);
 		SetClearColor(0.5f, 0.4f, 0.8f, 1.0f);
 		CheckErrors();
 	}
@@ -34,6 +38,22 @@ namespace kvasnric
 		option ? glEnable(GL_MULTISAMPLE) : glDisable(GL_MULTISAMPLE);
 	}
 
+	void OpenGLApplication::SetSrgbFramebuffer(bool option)
+	{
+		option ? glEnable(GL_FRAMEBUFFER_SRGB) : glDisable(GL_FRAMEBUFFER_SRGB);
+	}
+
+	void OpenGLApplication::SetVSync(bool option)
+	{
+		typedef int (CODEGEN_FUNCPTR *SwapIntervalProc)(int);
+#ifdef _WIN32
+		static const auto swapInterval = (SwapIntervalProc) glutGetProcAddress("wglSwapIntervalEXT");
+#else
+		static const auto swapInterval = (SwapIntervalProc) glutGetProcAddress("glXSwapIntervalMESA");
+#endif
+		if (swapInterval != nullptr) swapInterval(option ? 1 : 0);
+	}
+
 	void OpenGLApplication::SetDepthTest(bool option)
 	{
 		option ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
@@ -77,22 +97,37 @@ namespace kvasnric
 		ResizeUpdate();
 	}
 
-	void OpenGLApplication::Timer(int id, int time)
+	void OpenGLApplication::Timer(double time)
 	{
-		const float tmp = (float) time / 1000.0f;
-		m_TimeDelta = tmp - m_CurrentTime;
-		m_CurrentTime = tmp;
-		m_CurrentTimeMs = time;
-		
-		TimerUpdate();
+		// a long stall (loading, dragging the window) is dropped instead of simulated in a burst
+		m_Accumulator = glm::min(m_Accumulator + time - m_LastTime, (double) (SIMULATION_MAX_STEPS * SIMULATION_STEP));
+		m_LastTime = time;
+
+		FrameUpdate();
+
+		m_TimeDelta = SIMULATION_STEP;
+		while (m_Accumulator >= SIMULATION_STEP)
+		{
+			SaveSimulationState();
+			m_CurrentTime += SIMULATION_STEP;
+			TimerUpdate();
+			m_Accumulator -= SIMULATION_STEP;
+		}
+
+		m_Alpha = (float) (m_Accumulator / SIMULATION_STEP);
 	}
 
-	void OpenGLApplication::SetCurrentTime(int time)
+	void OpenGLApplication::ResetClock(double time)
 	{
-		m_CurrentTime = (float)time / 1000.0f;
-		m_CurrentTimeMs = time;
+		m_LastTime = time;
+		m_Accumulator = 0.0;
 	}
 	
+	void OpenGLApplication::Benchmark(const std::string& /*output*/)
+	{
+		throw std::runtime_error("Application does not implement a benchmark.");
+	}
+
 	void OpenGLApplication::ReactOnKey()
 	{
 	}
@@ -101,10 +136,18 @@ namespace kvasnric
 	{
 	}
 
+	void OpenGLApplication::FrameUpdate()
+	{
+	}
+
 	void OpenGLApplication::TimerUpdate()
 	{
 	}
 
+	void OpenGLApplication::SaveSimulationState()
+	{
+	}
+
 	void OpenGLApplication::ResizeUpdate()
 	{
 	}
@@ -55,6 +55,13 @@ namespace kvasnric
 		 */
 		virtual void Render() = 0;
 
+		/**
+		 * Renders a scripted sequence of frames without user input and writes their timings.
+		 * Throws in abstract, an application has to implement its own benchmark.
+		 * @param output path of the written results
+		 */
+		virtual void Benchmark(const std::string& output);
+
 		/**
 		 * Resize window callback
 		 * @param width window width
@@ -63,16 +70,27 @@ namespace kvasnric
 		virtual void ResizeWindow(int width, int height);
 
 		/**
-		 * Timer callback used to refresh class properties. Calls TimerUpdate()
-		 * @param id timerfunc id
-		 * @param time current time in milliseconds 
+		 * Main loop callback. Calls FrameUpdate() once and TimerUpdate() for every fixed simulation step
+		 * the elapsed time covers, then sets the blend factor of the last two steps for rendering.
+		 * @param time current time in seconds
+		 */
+		virtual void Timer(double time);
+
+		/**
+		 * Called by Timer method once per frame. Used for input that is not simulated, e.g. mouse look.
 		 */
-		virtual void Timer(int id, int time);
+		virtual void FrameUpdate();
 
 		/**
-		 * Called by Timer method. Used to update application properties.
+		 * Called by Timer method every simulation step. Used to update application properties.
+		 * m_TimeDelta is always SIMULATION_STEP.
 		 */
 		virtual void TimerUpdate();
+
+		/**
+		 * Called by Timer method before every simulation step. Used to keep the state that is blended in rendering.
+		 */
+		virtual void SaveSimulationState();
 		/**
 		 * Implement a reaction to mouse click. Does nothing in abstract.
 		 */
@@ -94,7 +112,11 @@ namespace kvasnric
 		 */
 		inline bool IsRunning() const { return m_Run; }
 
-		void SetCurrentTime(int time);
+		/**
+		 * Restarts measuring elapsed time from the given time without simulating the time in between
+		 * @param time current time in seconds
+		 */
+		void ResetClock(double time);
 	protected:
 		/**
 		 * Implements a reaction to resize callback. Does nothing in abstract.
@@ -107,6 +129,19 @@ namespace kvasnric
 		 */
 		static void SetMultiSampling(bool option);
 
+		/**
+		 * Sets whether linear colors written into sRGB framebuffers and textures are encoded to sRGB
+		 * @param option used to enabling/disabling
+		 */
+		static void SetSrgbFramebuffer(bool option);
+
+		/**
+		 * Sets whether buffer swaps wait for the vertical blank. Without it frames are rendered as fast as possible.
+		 * Does nothing when the driver does not expose the swap control extension.
+		 * @param option used to enabling/disabling
+		 */
+		static void SetVSync(bool option);
+
 		/**
 		 * Sets rendering base clear color
 		 * @param r red component
@@ -152,11 +187,21 @@ namespace kvasnric
 		 */
 		void SetViewport(int width, int height);
 
+		/**
+		 * @returns time between the last two simulation steps the rendered frame shows
+		 */
+		inline float RenderTime() const { return m_CurrentTime - (1.0f - m_Alpha) * SIMULATION_STEP; }
+
 		Resources m_Res;
-		int m_CurrentTimeMs;
+		// simulated time in seconds, advances only by simulation steps
 		float m_CurrentTime;
 		float m_TimeDelta;
+		// blend factor between the previous and the current simulation step
+		float m_Alpha;
 		bool m_Run;
+	private:
+		double m_LastTime;
+		double m_Accumulator;
 	};
 
 }
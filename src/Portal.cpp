@@ -14,15 +14,20 @@
 namespace kvasnric
 {
 	Portal::Portal(std::shared_ptr<Texture2D> texture, const glm::vec3& position, const glm::vec3& direction)
-		: m_VAO(nullptr), m_Indices(0), m_Texture(std::move(texture)), m_Position(position), m_Direction({ 0.0f, 0.0f, 1.0f })
+		: Portal(position, direction)
+	{
+		m_Texture = std::move(texture);
+		InitPortalMesh();
+	}
+
+	Portal::Portal(const glm::vec3& position, const glm::vec3& direction)
+		: m_VAO(nullptr), m_Indices(0), m_Texture(nullptr), m_Position(position), m_Direction({ 0.0f, 0.0f, 1.0f })
 		, m_RotationMatrix(UNIT_MATRIX), m_ModelMatrix(UNIT_MATRIX), m_ModelInverse(UNIT_MATRIX)
 		, m_TeleportationMatrix(UNIT_MATRIX), m_TeleportationInverse(UNIT_MATRIX)
 	{
 		const float angle = PlaneDirection(glm::normalize(direction));
 		m_Direction = direction;
 		m_RotationMatrix = glm::rotate(UNIT_MATRIX, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-		InitPortalMesh();
 	}
 
 	void Portal::Bind() const
@@ -100,6 +105,46 @@ namespace kvasnric
 		return glm::abs(pos.x) < 0.5f && glm::abs(pos.y) < 0.9f && pos.z < 0.001f;
 	}
 
+	float Portal::ScreenArea(const glm::mat4& pv, float width, float height) const
+	{
+		// bounding rectangle of the portal elipse in the portal coordinates, counter clockwise when looking at the front
+		const glm::vec4 corners[4] = {
+			{ -0.612371f, -0.9f, -0.01f, 1.0f },
+			{ 0.612371f, -0.9f, -0.01f, 1.0f },
+			{ 0.612371f, 0.9f, -0.01f, 1.0f },
+			{ -0.612371f, 0.9f, -0.01f, 1.0f }
+		};
+
+		const glm::mat4 pvm = pv * m_ModelMatrix;
+		glm::vec2 ndc[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			const glm::vec4 clip = pvm * corners[i];
+
+			// the portal crosses the camera plane, it may cover the whole screen
+			if (clip.w < 0.000001f) return width * height;
+			ndc[i] = glm::vec2(clip) / clip.w;
+		}
+
+		// signed area of the projected rectangle tells whether we are looking at the front side
+		float signedArea = 0.0f;
+		for (int i = 0; i < 4; ++i)
+		{
+			const glm::vec2& a = ndc[i];
+			const glm::vec2& b = ndc[(i + 1) & 3];
+			signedArea += a.x * b.y - b.x * a.y;
+		}
+		if (signedArea <= 0.0f) return 0.0f;
+
+		// clamp the bounding box to the viewport
+		glm::vec2 min = glm::min(glm::min(ndc[0], ndc[1]), glm::min(ndc[2], ndc[3]));
+		glm::vec2 max = glm::max(glm::max(ndc[0], ndc[1]), glm::max(ndc[2], ndc[3]));
+		min = glm::clamp(min, glm::vec2(-1.0f), glm::vec2(1.0f));
+		max = glm::clamp(max, glm::vec2(-1.0f), glm::vec2(1.0f));
+
+		return (max.x - min.x) * 0.5f * width * (max.y - min.y) * 0.5f * height;
+	}
+
 	void Portal::InitPortalMesh()
 	{
 		const int vertsCnt = 46 * 3;
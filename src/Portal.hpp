@@ -25,6 +25,14 @@ namespace kvasnric
 		 * @param direction in which direction is portal facing
 		 */
 		Portal(std::shared_ptr<Texture2D> texture, const glm::vec3& position, const glm::vec3& direction);
+
+		/**
+		 * Constructs portal without its texture and mesh, so no opengl context is needed.
+		 * Only the transformations and collisions can be used, Bind and GetVAO cannot.
+		 * @param position position of the portal
+		 * @param direction in which direction is portal facing
+		 */
+		Portal(const glm::vec3& position, const glm::vec3& direction);
 		void Bind() const;
 
 		/**
@@ -44,6 +52,15 @@ namespace kvasnric
 		 */
 		bool IsColliding(const glm::vec3 & x) const;
 
+		/**
+		 * Estimates how many pixels the portal covers on the screen. Portal seen from behind covers nothing.
+		 * @param pv projection view matrix the portal is seen through
+		 * @param width viewport width in pixels
+		 * @param height viewport height in pixels
+		 * @returns area of the portal's screen bounding box clamped to the viewport in pixels
+		 */
+		float ScreenArea(const glm::mat4& pv, float width, float height) const;
+
 		/**
 		 * Change the position and direction of the portal
 		 */
@@ -10,24 +10,44 @@
 
 #include <iostream>
 #include <cstdio>
+#include <random>
+#include <glm/gtc/color_space.hpp>
 #include <IO/Keyboard.hpp>
 #include <IO/Mouse.hpp>
+#include <Renderer/FrameSync.hpp>
+#include <Renderer/ProgramCache.hpp>
+#include <Renderer/RenderStats.hpp>
+#include <BenchmarkReport.hpp>
 
 namespace kvasnric
 {
 	PortalTestRoom::PortalTestRoom()
-		: OpenGLApplication( 1600, 900, "PortalTestRoom" ), m_PortalWalls( nullptr ), m_Iterations(1), m_Menu(nullptr)
+		: OpenGLApplication( 1600, 900, "PortalTestRoom" ), m_Views(VIEW_SLOTS), m_Jobs(new JobSystem())
+		, m_PortalWalls( nullptr ), m_PreviousCamera(nullptr), m_DepthCap(PORTAL_MAX_ITERATIONS), m_BlueDepth(0), m_OrangeDepth(0), m_Benchmark(false)
+		, m_PortalMode(PORTAL_MODE::STENCIL), m_ViewFrame(0), m_LastFrame(std::chrono::steady_clock::now())
+		, m_Deferred(false), m_GBuffer(nullptr), m_DepthPrePass(false), m_VSync(true), m_Profiler(nullptr)
+		, m_Overlay(nullptr), m_OverlayRefresh(std::chrono::steady_clock::now()), m_Menu(nullptr)
 	{
 	}
 
 	void PortalTestRoom::LoadResources()
 	{
+		// driver compiles the shaders while the textures are decoded
+		Resources::PrefetchShaders();
+		m_Res.LoadCubeMap("gothic_alley");
+		const auto menu = m_Res.GetTexture("menu.png", Texture2D::DIFFUSE);
+		// cursor only occupies the specular slot, its texels are colors
+		const auto cursor = m_Res.GetTexture("cursor.png", Texture2D::SPECULAR, true);
+
 		m_Res.LoadEntityShader();
+		m_Res.LoadLightClusters(Width(), Height());
 		m_Res.LoadCubeMapShader();
-		m_Res.LoadCubeMap("gothic_alley");
 		m_Res.LoadPortals();
 		m_Res.LoadStencilStampTester();
-		m_Menu.reset(new Menu(m_Res.GetTexture("menu.png", Texture2D::DIFFUSE), m_Res.GetTexture("cursor.png", Texture2D::SPECULAR), Width(), Height()));
+		m_Res.LoadDeferred();
+		m_Menu.reset(new Menu(menu, cursor, Width(), Height()));
+		m_Overlay.reset(new ProfilerOverlay());
+		ProgramCache::Save();
 		CheckErrors();
 	}
 
@@ -35,19 +55,34 @@ namespace kvasnric
 	{
 		SetupCameras();
 		SetupLights();
+		SetupProfiler();
 
-		const glm::vec3 skycolor = glm::vec3(0.8f);
+		// sky is picked as an sRGB color, clearing and shading work with linear colors
+		const glm::vec3 skycolor = glm::convertSRGBToLinear(glm::vec3(0.8f));
 
 		SetClearColor(skycolor.r, skycolor.g, skycolor.b, 1.0f);
 		m_Res.Entity().UploadSkyColor(skycolor);
+		m_Res.DeferredLighting().Bind();
+		m_Res.DeferredLighting().UploadSkyColor(skycolor);
 		
 		SetupModels();
+		// materials are known now, their variants compile while the rest is set up
+		m_Res.PrefetchVariants();
+		m_Res.PrefetchVariants(*m_PortalWalls);
 		
 		m_Blue.reset(new Portal(m_Res.GetTexture("portal_blue.png", Texture::DIFFUSE), { 0.0f,1.0f,-15.0f }, { 0.0f, 0.0f, 1.0f }));
 		m_Orange.reset(new Portal(m_Res.GetTexture("portal_orange.png", Texture::DIFFUSE), { 0.0f,1.0f,-15.0f }, { 0.0f, 0.0f, -1.0f }));
+
+		for (unsigned i = 0; i < 2; ++i)
+		{
+			m_BlueView[i].reset(new FrameBuffer(Width(), Height()));
+			m_OrangeView[i].reset(new FrameBuffer(Width(), Height()));
+		}
+
+		m_GBuffer.reset(new GBuffer(Width(), Height()));
 	}
 
-	void PortalTestRoom::SetupLights() const
+	void PortalTestRoom::SetupLights()
 	{
 		PointLight l1(glm::vec3(-2.0f, 3.0f, -6.0f), glm::vec3(1.0f, 0.9f, 0.2f), 0.7f, 0.01f, 0.35f, 0.44f, 0.6f);
 		PointLight l2(glm::vec3(2.0f, 3.0f, -6.0f), glm::vec3(0.1f, 0.2f, 1.0f), 0.65f, 0.02f, 0.35f, 0.44f, 0.7f);
@@ -59,7 +94,6 @@ namespace kvasnric
 		SpotLight s3(glm::vec3(-5.0f, 4.0f, -13.0f), glm::vec3(0.0f, 4.5f, -15.0f), glm::vec3(0.9f, 0.2f, 0.1f), 0.4f, 15.f, 30.f, true);
 		SpotLight s4(glm::vec3(5.0f, 4.0f, -13.0f), glm::vec3(0.0f, 4.5f, -15.0f), glm::vec3(0.1f, 0.4f, 0.9f), 0.4f, 15.f, 30.f, true);
 
-		m_Res.Entity().Bind();
 		m_Res.Entity().UploadPointLight(l1);
 		m_Res.Entity().UploadPointLight(l2);
 		m_Res.Entity().UploadPointLight(l3);
@@ -70,26 +104,45 @@ namespace kvasnric
 		m_Res.Entity().UploadSpotLight(s4);
 	}
 
+	void PortalTestRoom::SpawnLights(unsigned count)
+	{
+		static std::mt19937 generator(7);
+
+		// bounds of the test room floor and ceiling
+		std::uniform_real_distribution<float> x(-5.5f, 14.5f);
+		std::uniform_real_distribution<float> y(0.5f, 5.0f);
+		std::uniform_real_distribution<float> z(-23.5f, 0.5f);
+		std::uniform_real_distribution<float> color(0.1f, 1.0f);
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			PointLight light(glm::vec3(x(generator), y(generator), z(generator)),
+				glm::vec3(color(generator), color(generator), color(generator)), 0.5f, 0.01f, 0.7f, 1.8f, 0.6f);
+			light.SetRange(SPAWNED_LIGHT_RANGE);
+			m_Res.Entity().UploadPointLight(light);
+		}
+	}
+
 	void PortalTestRoom::SetupModels()
 	{
-		m_Objects.emplace_back(m_Res["wheatley.obj"], glm::vec3{ 0.0f, 0.35f, -5.0f });
+		m_Objects.push_back(m_Entities.Create(m_Res["wheatley.obj"], glm::vec3{ 0.0f, 0.35f, -5.0f }));
 
-		m_Objects.emplace_back(m_Res["gothic.obj"], glm::vec3(1.0f, 0.0f, -5.0f));
-		m_Objects.emplace_back(m_Res["gothic.obj"], glm::vec3(1.0f, 0.91f, -5.0f));
-		m_Objects.back().Scale({ 0.6f, 0.6f, 0.6f });
+		m_Objects.push_back(m_Entities.Create(m_Res["gothic.obj"], glm::vec3(1.0f, 0.0f, -5.0f)));
+		m_Objects.push_back(m_Entities.Create(m_Res["gothic.obj"], glm::vec3(1.0f, 0.91f, -5.0f)));
+		m_Entities.Scale(m_Objects.back(), { 0.6f, 0.6f, 0.6f });
 
-		m_Objects.emplace_back(m_Res["gothic.obj"], glm::vec3(-1.0f, 0.0f, -5.0f));
-		m_Objects.emplace_back(m_Res["gothic.obj"], glm::vec3(-1.0f, 0.91f, -5.0f));
-		m_Objects.back().Scale({ 0.6f, 0.6f, 0.6f });
+		m_Objects.push_back(m_Entities.Create(m_Res["gothic.obj"], glm::vec3(-1.0f, 0.0f, -5.0f)));
+		m_Objects.push_back(m_Entities.Create(m_Res["gothic.obj"], glm::vec3(-1.0f, 0.91f, -5.0f)));
+		m_Entities.Scale(m_Objects.back(), { 0.6f, 0.6f, 0.6f });
 
-		m_Objects.emplace_back(m_Res["backpack.obj"], glm::vec3(-4.0f, 2.0f, -5.0f));
-		m_Objects.back().RotationYAxis(-90.0f);
+		m_Objects.push_back(m_Entities.Create(m_Res["backpack.obj"], glm::vec3(-4.0f, 2.0f, -5.0f)));
+		m_Entities.RotationYAxis(m_Objects.back(), -90.0f);
 
-		m_Objects.emplace_back(m_Res["aperture_sign.obj"], glm::vec3(4.0f, 2.0f, -15.0f));
-		m_Objects.back().Scale(glm::vec3(0.01f, 0.01f, 0.01f));
+		m_Objects.push_back(m_Entities.Create(m_Res["aperture_sign.obj"], glm::vec3(4.0f, 2.0f, -15.0f)));
+		m_Entities.Scale(m_Objects.back(), glm::vec3(0.01f, 0.01f, 0.01f));
 
-		m_Objects.emplace_back(m_Res["earth.obj"], glm::vec3(0.0f, 2.0f, -10.0f));
-		m_Objects.back().GetModel().GetMeshes()[0]->Export();
+		m_Objects.push_back(m_Entities.Create(m_Res["earth.obj"], glm::vec3(0.0f, 2.0f, -10.0f)));
+		m_Entities.GetModel(m_Objects.back()).GetMeshes()[0]->Export();
 		
 		std::vector<glm::vec3> points = {
 			{-4.768676f, 5.708214f, -4.713191f},
@@ -107,12 +160,18 @@ namespace kvasnric
 		};
 
 		const auto s = std::make_shared<Spline>(std::move(points));
-		m_Wheatley.reset(new MovingObject(m_Res["wheatley.obj"], s));
-
-		m_RoomWalls.reset(new GameObject(m_Res["scene_walls.obj"], ZERO_VECTOR));
-		m_RoomFloor.reset(new GameObject(m_Res["scene_floor.obj"], ZERO_VECTOR));
-		m_BloomLabel.reset(new GameObject(m_Res["scene_test_label.obj"], ZERO_VECTOR));
-		m_Transparent.reset(new GameObject(m_Res["cube3.obj"], { 5.0f, 2.0f, -8.0f }));
+		m_Wheatley = m_Entities.Create(m_Res["wheatley.obj"], ZERO_VECTOR);
+		m_Entities.AttachMover(m_Wheatley, s);
+
+		// walls, floor and the transparent cube are drawn by their own passes, not by the queued one
+		m_RoomWalls = m_Entities.Create(m_Res["scene_walls.obj"], ZERO_VECTOR, UNIT_MATRIX, 0);
+		// floor is looked up every simulation step to keep the camera on it
+		const auto floor = m_Res["scene_floor.obj"];
+		floor->BuildBVH();
+		m_FloorGrid.reset(new HeightGrid(*floor));
+		m_RoomFloor = m_Entities.Create(floor, ZERO_VECTOR, UNIT_MATRIX, 0);
+		m_BloomLabel = m_Entities.Create(m_Res["scene_test_label.obj"], ZERO_VECTOR);
+		m_Transparent = m_Entities.Create(m_Res["cube3.obj"], { 5.0f, 2.0f, -8.0f }, UNIT_MATRIX, 0);
 
 		m_PortalWalls.reset(new PortalWalls(
 			m_Res.GetTexture("concrete_diff.jpg", Texture::DIFFUSE),
@@ -121,6 +180,24 @@ namespace kvasnric
 			m_Res.GetTexture("concrete_rough.jpg", Texture::ROUGHNESS),
 			m_Res.GetTexture("concrete_AO.jpg", Texture::OCCLUSION)
 		));
+
+		// every model rays can hit gets its hierarchy once, objects sharing a model share it too
+		for (const auto* name : { "wheatley.obj", "gothic.obj", "backpack.obj", "aperture_sign.obj", "earth.obj", "scene_walls.obj", "cube3.obj" })
+		{
+			m_Res[name]->BuildBVH();
+		}
+
+		// props can be attached to any entity by passing it as the parent
+		m_Entities.UpdateMovers(m_CurrentTime);
+		m_Entities.UpdateTransforms();
+
+		for (const auto obj : m_Objects) m_Raycast.Add(m_Entities, obj, SceneRaycast::SOLID | SceneRaycast::PICKABLE);
+		m_Raycast.Add(m_Entities, m_Wheatley, SceneRaycast::SOLID | SceneRaycast::PICKABLE);
+		m_Raycast.Add(m_Entities, m_Transparent, SceneRaycast::SOLID);
+		m_Raycast.Add(m_Entities, m_RoomWalls, SceneRaycast::SOLID);
+		m_Raycast.Add(m_Entities, m_RoomFloor, SceneRaycast::SOLID | SceneRaycast::FLOOR);
+		m_Raycast.Add(*m_PortalWalls, UNIT_MATRIX, SceneRaycast::SOLID | SceneRaycast::PORTAL_CONDUCTIVE);
+		m_Raycast.Build();
 	}
 
 	void PortalTestRoom::SetupCameras()
@@ -159,192 +236,652 @@ namespace kvasnric
 	}
 	
 	
-	void PortalTestRoom::RenderScene() const
+	void PortalTestRoom::RenderScene(int stampId) const
 	{
 		// render all the object that do not care about the the order of rendering
-		const auto& entity = m_Res.Entity();
-		entity.Bind();
-		entity.RenderGameObject(*m_BloomLabel);
+		// commands of the entities inside the view are recorded grouped by their shader variant, the deeper levels may still be recording
+		const PreparedView& view = m_Views[ViewSlot(stampId)];
+		m_Jobs->Wait(view.Recorded);
+		Opaque().Replay(view.Commands);
+	}
 
-		entity.RenderGameObject(*m_Wheatley);
-		
-		for (auto & obj : m_Objects)
+	int PortalTestRoom::ViewSlot(int stampId)
+	{
+		// stamp ids of the blue portal start at 1 and of the orange one at 10
+		if (stampId < 10) return stampId;
+		return PORTAL_MAX_ITERATIONS + stampId - 9;
+	}
+
+	int PortalTestRoom::PrepareLevels(const Portal& p, int firstStamp)
+	{
+		const int depth = RecursionDepth(p);
+		// portal textures render only the first level, the deeper ones reuse the last frame
+		const int rendered = m_PortalMode == PORTAL_MODE::TEXTURE ? glm::min(depth, 1) : depth;
+
+		glm::mat4 levelView = m_View;
+		for (int level = 0; level < PORTAL_MAX_ITERATIONS; ++level)
+		{
+			// the same chain of products as the recursion, so the culled view matches the rendered one
+			levelView = levelView * p.GetTeleportation();
+			PreparedView& view = m_Views[ViewSlot(firstStamp + level)];
+			view.View = levelView;
+			view.Active = level < rendered;
+		}
+		return depth;
+	}
+
+	void PortalTestRoom::PrepareFrame()
+	{
+		const float time = RenderTime();
+		const unsigned movers = m_Jobs->Add([this, time] { m_Entities.UpdateMovers(time); });
+		const unsigned transforms = m_Jobs->Add([this] { m_Entities.UpdateTransforms(); }, { movers });
+
+		// mounted camera follows the blended objects
+		const unsigned camera = m_Jobs->Add([this]
 		{
-			entity.RenderGameObject(obj);
+			BeginInterpolation();
+			m_View = m_ActiveCamera->GetViewMatrix();
+			m_Views[0].View = m_View;
+			m_Views[0].Active = true;
+		}, { transforms });
+
+		// levels of the two portals do not depend on each other
+		const unsigned blue = m_Jobs->Add([this] { m_BlueDepth = PrepareLevels(*m_Blue, 1); }, { camera });
+		const unsigned orange = m_Jobs->Add([this] { m_OrangeDepth = PrepareLevels(*m_Orange, 10); }, { camera });
+
+		// every level is culled and recorded on its own, the store is not changed until the frame ends
+		for (int slot = 0; slot < VIEW_SLOTS; ++slot)
+		{
+			const unsigned levels = slot == 0 ? camera : slot <= PORTAL_MAX_ITERATIONS ? blue : orange;
+			const unsigned cull = m_Jobs->Add([this, slot]
+			{
+				PreparedView& view = m_Views[slot];
+				if (view.Active) m_Entities.Cull(view.Visible, m_Projection * view.View, EntityStore::QUEUED);
+			}, { levels });
+
+			m_Views[slot].Recorded = m_Jobs->Add([this, slot]
+			{
+				PreparedView& view = m_Views[slot];
+				if (!view.Active) return;
+				EntityShader::Prepare(view.Draws, m_Entities, view.Visible);
+				EntityShader::Record(view.Commands, view.Draws);
+			}, { cull });
 		}
+
+		// passes need the views and depths right away, the lists are waited for one by one as they are replayed
+		m_Jobs->Start();
+		m_Jobs->Wait(blue);
+		m_Jobs->Wait(orange);
 	}
 	
 	void PortalTestRoom::RenderInsidePortal(const Portal& p, const glm::mat4& view, const glm::mat4& projection,
-		int stampId, int it) const
+		int stampId, int it, int depth, PASS pass)
 	{
-		const auto& s = m_Res.Entity();
-
 		/**
 		 * teleportation matrix is applied from the right side of the view matrix so it will affect models from world coordinates first,
 		 * but we want to compute lights first in the world coordinates
 		 */
 		const glm::mat4 portalView = view * p.GetTeleportation();
 		const glm::vec3 position = p.Teleport(glm::vec4(m_ActiveCamera->GetPosition(), 1.0f));
-		if( it == 1 )
+
+		if (pass == PASS::GEOMETRY)
 		{
-			StencilStamp::CompareToStamp(stampId);
-			s.Bind();
-			s.UploadViewInfo(position, portalView, projection);
-			s.RenderPortalWalls(*m_PortalWalls);
-			s.RenderGameObject(*m_RoomWalls);
-			s.RenderGameObject(*m_RoomFloor);
-			
-			RenderScene();
+			// again firstly render a portal elipse into the stencil buffer and increase the stampId
+			if (it > 1)
+			{
+				m_Profiler->Begin(STAMPS);
+				RenderStats::SetView(stampId + 1);
+				m_Res.Stencil().StampElements(p.GetVAO(), p.IndicesCount(), projection*portalView*p.GetModelMatrix(), stampId + 1);
+				m_Profiler->End();
+			}
+
+			// the innermost iteration renders its scene only inside its own stamp, the others also over the nested portal
+			RenderOpaqueLevel(position, portalView, projection, stampId, it == 1);
+		}
+
+		// recursively call another portal rendering
+		if (it > 1) RenderInsidePortal(p, portalView, projection, stampId + 1, it - 1, depth, pass);
+
+		if (pass == PASS::GEOMETRY) return;
+
+		RenderStats::SetView(stampId);
+		StencilStamp::CheckInStamp(stampId);
+
+		m_Profiler->Begin(PORTAL_TEXTURES);
+		m_Res.PortalTexture().Render(p, RenderTime(), portalView, projection);
+
+		if (depth == 1) StencilStamp::CompareToStamp(stampId);
+
+		m_Profiler->Begin(TRANSPARENT_OBJECT);
+		auto& s = m_Res.Entity();
+		s.UploadViewInfo(position, portalView, projection, ViewSlot(stampId));
+		s.RenderTransparentEntity(m_Entities, m_Transparent);
+		m_Profiler->End();
+	}
+
+	int PortalTestRoom::RecursionDepth(const Portal& p) const
+	{
+		int depth = 0;
+		glm::mat4 levelView = m_View;
+
+		// level n is seen through the portal transformed n-1 times by the teleportation matrix
+		while (depth < m_DepthCap)
+		{
+			// the first level fills the stamp whenever any part of the portal is seen, only the nested ones may be too small.
+			// Benchmark renders every level up to the limit of its phase.
+			const float area = p.ScreenArea(m_Projection * levelView, (float)Width(), (float)Height());
+			if (area <= 0.0f || (depth > 0 && !m_Benchmark && area < PORTAL_MIN_SCREEN_AREA)) break;
+			levelView = levelView * p.GetTeleportation();
+			++depth;
 		}
+		return depth;
+	}
+
+	void PortalTestRoom::UpdateDepthCap()
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const float frameMs = std::chrono::duration<float, std::milli>(now - m_LastFrame).count();
+		m_LastFrame = now;
+
+		// hysteresis so the cap does not oscillate every frame
+		if (frameMs > PORTAL_FRAME_BUDGET_MS) m_DepthCap = glm::max(1, m_DepthCap - 1);
+		else if (frameMs < 0.75f * PORTAL_FRAME_BUDGET_MS) m_DepthCap = glm::min(PORTAL_MAX_ITERATIONS, m_DepthCap + 1);
+	}
+
+	void PortalTestRoom::Render()
+	{
+		m_Profiler->BeginFrame();
+		RenderStats::BeginFrame();
+		Clear();
+		if (!m_Benchmark) UpdateDepthCap();
+		PrepareFrame();
+
+		if (m_PortalMode == PORTAL_MODE::TEXTURE) RenderWithPortalTextures();
+		else if (IsDeferred()) RenderDeferred();
 		else
 		{
-			// again firstly render a portal elipse into the stencil buffer and increase the stampId
-			m_Res.Stencil().StampElements(p.GetVAO(), p.IndicesCount(), projection*portalView*p.GetModelMatrix(), stampId + 1);
-			
-			s.Bind();
-			// render every wall and floor comparing to the stampId
-			StencilStamp::CompareToStamp(stampId);
-			s.UploadViewInfo(position, portalView, projection);
-			s.RenderPortalWalls(*m_PortalWalls);
-			s.RenderGameObject(*m_RoomWalls);
-			s.RenderGameObject(*m_RoomFloor);
+			RenderWithStencil(PASS::GEOMETRY);
+			RenderWithStencil(PASS::FORWARD);
+		}
 
-			// render scene over the portal
-			StencilStamp::CheckInStamp(stampId);
-			RenderScene();
+		// levels which were not replayed are recorded too, the entities move again in EndInterpolation
+		m_Jobs->Finish();
 
-			// recursively call another portal rendering
-			RenderInsidePortal(p, portalView, projection, stampId + 1, it - 1);
+		// if is menu active render the menu
+		if (m_Menu->IsActive())
+		{
+			m_Profiler->Begin(MENU);
+			m_Menu->Render();
+			m_Profiler->End();
 		}
 
-		StencilStamp::CheckInStamp(stampId);
-		
-		m_Res.PortalTexture().Render(p, m_CurrentTime, portalView, projection);
+		if (m_Overlay->IsActive()) RenderOverlay();
 
-		if (m_Iterations == 1) StencilStamp::CompareToStamp(stampId);
-		
-		s.Bind();
-		s.UploadViewInfo(position, portalView, projection);
-		s.RenderTransparentGameObject(*m_Transparent);
+		EndInterpolation();
+		RenderStats::EndFrame();
+		m_Profiler->EndFrame();
 	}
 
-	void PortalTestRoom::Render()
+	void PortalTestRoom::Benchmark(const std::string& output)
+	{
+		// portals on the opposite walls see each other, every phase limits the recursion to its number of levels
+		struct Phase
+		{
+			int Levels;
+			glm::vec3 Origin;
+			glm::vec3 Blue;
+			glm::vec3 Orange;
+		};
+
+		const Phase phases[] = {
+			{ 1, { 0.0f, 1.5f, -8.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f } },
+			{ 2, { 0.0f, 1.5f, -8.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f } },
+			{ PORTAL_MAX_ITERATIONS, { 0.0f, 1.5f, -8.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f } }
+		};
+
+		// a hidden window owns no pixels, everything meant for the screen is rendered offscreen
+		FrameBuffer screen(Width(), Height());
+		FrameBuffer::SetScreen(&screen);
+
+		m_Benchmark = true;
+		m_ActiveCamera = m_Predefined.get();
+		m_Profiler->SetWaitForResults(true);
+		m_Profiler->Flush();
+		m_Profiler->StartRecording();
+
+		// simulated time advances by the same step every frame, so every run renders the same frames
+		double time = 0.0;
+		ResetClock(time);
+
+		std::vector<BenchmarkReport::Frame> frames;
+		for (const auto& phase : phases)
+		{
+			if (!ShootPortal(*m_Blue, phase.Origin, phase.Blue) || !ShootPortal(*m_Orange, phase.Origin, phase.Orange))
+				std::cerr << "Benchmark portal missed the portal walls, the previous placement is kept." << std::endl;
+
+			m_DepthCap = phase.Levels;
+			m_Predefined->Start(m_CurrentTime);
+
+			for (unsigned i = 0; i < BENCHMARK_FRAMES_PER_PHASE; ++i)
+			{
+				time += BENCHMARK_FRAME_TIME;
+				FrameSync::BeginFrame();
+				Timer(time);
+
+				Render();
+				FrameSync::EndFrame();
+				frames.push_back({ phase.Levels, m_BlueDepth, m_OrangeDepth, 0.0f, 0.0f, RenderStats::Total(RenderStats::DRAW_CALLS) });
+			}
+		}
+
+		m_Profiler->Flush();
+		FrameBuffer::SetScreen(nullptr);
+
+		// the profiler reads the frames back in the order they were rendered
+		BenchmarkReport report;
+		const auto& times = m_Profiler->Recorded();
+		for (size_t i = 0; i < frames.size() && i < times.size(); ++i)
+		{
+			frames[i].Cpu = times[i].Cpu;
+			frames[i].Gpu = times[i].Gpu;
+			report.Add(frames[i]);
+		}
+
+		report.Write(output);
+		std::cout << "Benchmark of " << frames.size() << " frames written to " << output << std::endl;
+		m_Profiler->Print(std::cout);
+		FrameSync::Print(std::cout);
+	}
+
+	void PortalTestRoom::RenderOverlay()
+	{
+		m_Profiler->Begin(OVERLAY);
+
+		const auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<float>(now - m_OverlayRefresh).count() > PROFILER_OVERLAY_REFRESH)
+		{
+			m_Overlay->Update(*m_Profiler);
+			m_OverlayRefresh = now;
+		}
+
+		StencilStamp::DisableTest();
+		m_Overlay->Render(Height());
+		StencilStamp::EnableTest();
+
+		m_Profiler->End();
+	}
+
+	void PortalTestRoom::SetupProfiler()
+	{
+		m_Profiler.reset(new GpuProfiler());
+
+		const char* names[] = { "stencil stamps", "main scene", "cubemap", "portal textures", "transparent", "lighting", "menu", "overlay" };
+		for (const auto name : names) m_Profiler->AddSection(name);
+
+		for (const auto portal : { "blue ", "orange " })
+		{
+			for (int level = 1; level <= PORTAL_MAX_ITERATIONS; ++level) m_Profiler->AddSection(portal + std::to_string(level));
+		}
+	}
+
+	unsigned PortalTestRoom::LevelSection(int stampId)
+	{
+		// stamp ids of the blue portal start at 1 and of the orange one at 10
+		if (stampId == 0) return SCENE;
+		return stampId < 10 ? LEVELS + stampId - 1 : LEVELS + PORTAL_MAX_ITERATIONS + stampId - 10;
+	}
+
+	void PortalTestRoom::BeginInterpolation()
+	{
+		const float time = RenderTime();
+		if (m_ActiveCamera == m_Predefined.get()) m_Predefined->Update(time);
+		// mounted camera follows the blended object
+		else if (m_ActiveCamera == m_MountedCamera.get()) m_MountedCamera->UpdateCameraSpace();
+
+		m_SimulatedEye = m_ActiveCamera->GetPosition();
+
+		// a camera switch or a jump through the portal is shown right away
+		if (m_ActiveCamera == m_Camera.get() && m_PreviousCamera == m_ActiveCamera
+			&& glm::distance(m_PreviousEye, m_SimulatedEye) < INTERPOLATION_SNAP_DISTANCE)
+		{
+			m_Camera->Teleport(glm::mix(m_PreviousEye, m_SimulatedEye, m_Alpha));
+		}
+	}
+
+	void PortalTestRoom::EndInterpolation()
+	{
+		const unsigned movers = m_Jobs->Add([this] { m_Entities.UpdateMovers(m_CurrentTime); });
+		m_Jobs->Add([this] { m_Entities.UpdateTransforms(); }, { movers });
+		m_Jobs->Add([this]
+		{
+			if (m_ActiveCamera == m_Predefined.get()) m_Predefined->Update(m_CurrentTime);
+			else if (m_ActiveCamera == m_Camera.get()) m_Camera->Teleport(m_SimulatedEye);
+		});
+		m_Jobs->Run();
+	}
+
+	void PortalTestRoom::RenderPortalView(const Portal& p, const FrameBuffer& target, const FrameBuffer& previous, int depth, int stampId) const
 	{
+		target.Bind();
 		Clear();
-		m_View = m_ActiveCamera->GetViewMatrix();
 
-		// render portal into stencil first
-		const glm::mat4 pv = m_ActiveCamera->GetProjectionMatrix((float)Width(), (float)Height(), 0.01f, 500.0f) * m_View;
-		m_Res.Stencil().StampElementsFirst(m_Blue->GetVAO(), m_Blue->IndicesCount(), pv*m_Blue->GetModelMatrix(), 1);
-		m_Res.Stencil().StampElementsFirst(m_Orange->GetVAO(), m_Orange->IndicesCount(), pv*m_Orange->GetModelMatrix(), 10);
-		
-		const auto& s = m_Res.Entity();
-		s.Bind();
+		const glm::mat4 portalView = m_View * p.GetTeleportation();
+		const glm::vec3 position = p.Teleport(glm::vec4(m_ActiveCamera->GetPosition(), 1.0f));
+
+		auto& s = m_Res.Entity();
+		s.UploadViewInfo(position, portalView, m_Projection, ViewSlot(stampId));
+		s.RenderPortalWalls(*m_PortalWalls);
+		s.RenderEntity(m_Entities, m_RoomWalls);
+		s.RenderEntity(m_Entities, m_RoomFloor);
+		RenderScene(stampId);
+
+		// the nested portal shows what this portal showed on the screen in the last frame
+		if (depth > 1) m_Res.PortalView().Render(p, previous, m_Projection * portalView, m_Projection * m_View);
+
+		if (!s.IsFogEnabled()) m_Res.CubemapShader().Render(m_Res.Cubemap(), portalView, m_Projection);
+
+		m_Res.PortalTexture().Render(p, RenderTime(), portalView, m_Projection);
+
+		s.UploadViewInfo(position, portalView, m_Projection, ViewSlot(stampId));
+		s.RenderTransparentEntity(m_Entities, m_Transparent);
+
+		FrameBuffer::Unbind();
+	}
+
+	void PortalTestRoom::RenderWithPortalTextures()
+	{
+		const int blueDepth = m_BlueDepth;
+		const int orangeDepth = m_OrangeDepth;
+
+		// swap current and previous portal views
+		m_ViewFrame ^= 1;
+		const auto& blue = *m_BlueView[m_ViewFrame];
+		const auto& orange = *m_OrangeView[m_ViewFrame];
+
+		// portal views are not masked, depth test alone decides what is visible
+		StencilStamp::DisableTest();
 		m_Res.Cubemap().Bind();
+		// whole offscreen view counts as the first level of the portal
+		m_Profiler->Begin(LevelSection(1));
+		RenderStats::SetView(1);
+		if (blueDepth > 0) RenderPortalView(*m_Blue, blue, *m_BlueView[m_ViewFrame ^ 1], blueDepth, 1);
+		m_Profiler->Begin(LevelSection(10));
+		RenderStats::SetView(10);
+		if (orangeDepth > 0) RenderPortalView(*m_Orange, orange, *m_OrangeView[m_ViewFrame ^ 1], orangeDepth, 10);
+		SetViewport(Width(), Height());
+
+		m_Profiler->Begin(SCENE);
+		RenderStats::SetView(0);
+		auto& s = m_Res.Entity();
 		s.UploadViewInfo(m_ActiveCamera->GetPosition(), m_View, m_Projection);
-		StencilStamp::CompareToStamp(0);
-		// if im under the ground update stencil buffer by the ground render
-		if(m_ActiveCamera->GetPosition().y < 0.0f) StencilStamp::StampWithShader(0);
-		// render floor
-		s.RenderGameObject(*m_RoomFloor);
-		StencilStamp::CompareToStamp(0);
-
-		// render all walls by the stencil comparison, so nothing will override what is inside the portal
+		s.RenderEntity(m_Entities, m_RoomFloor);
 		s.RenderPortalWalls(*m_PortalWalls);
-		s.RenderGameObject(*m_RoomWalls);
+		s.RenderEntity(m_Entities, m_RoomWalls);
+		RenderScene(0);
 
-		// render the entire scene over the portal
-		StencilStamp::CheckInStamp(0);
-		RenderScene();
+		// fill the portal elipses with the offscreen views
+		const glm::mat4 pv = m_Projection * m_View;
+		if (blueDepth > 0) m_Res.PortalView().Render(*m_Blue, blue, pv);
+		if (orangeDepth > 0) m_Res.PortalView().Render(*m_Orange, orange, pv);
+
+		m_Profiler->Begin(CUBEMAP);
+		if (!s.IsFogEnabled()) m_Res.CubemapShader().Render(m_Res.Cubemap(), m_View, m_Projection);
+
+		m_Profiler->Begin(PORTAL_TEXTURES);
+		m_Res.PortalTexture().Render(*m_Blue, RenderTime(), m_View, m_Projection);
+		m_Res.PortalTexture().Render(*m_Orange, RenderTime(), m_View, m_Projection);
+
+		m_Profiler->Begin(TRANSPARENT_OBJECT);
+		s.UploadViewInfo(m_ActiveCamera->GetPosition(), m_View, m_Projection);
+		s.RenderTransparentEntity(m_Entities, m_Transparent);
+		m_Profiler->End();
+
+		StencilStamp::EnableTest();
+	}
+
+	void PortalTestRoom::RenderWithStencil(PASS pass)
+	{
+		auto& s = m_Res.Entity();
+
+		if (pass == PASS::GEOMETRY)
+		{
+			// render portal into stencil first
+			m_Profiler->Begin(STAMPS);
+			const glm::mat4 pv = m_ActiveCamera->GetProjectionMatrix((float)Width(), (float)Height(), 0.01f, 500.0f) * m_View;
+			// a portal without any rendered level is not stamped, its pixels would show no scene
+			RenderStats::SetView(1);
+			if (m_BlueDepth > 0) m_Res.Stencil().StampElementsFirst(m_Blue->GetVAO(), m_Blue->IndicesCount(), pv*m_Blue->GetModelMatrix(), 1);
+			RenderStats::SetView(10);
+			if (m_OrangeDepth > 0) m_Res.Stencil().StampElementsFirst(m_Orange->GetVAO(), m_Orange->IndicesCount(), pv*m_Orange->GetModelMatrix(), 10);
+			m_Profiler->End();
+
+			m_Res.Cubemap().Bind();
+			RenderOpaqueLevel(m_ActiveCamera->GetPosition(), m_View, m_Projection, 0, false);
+		}
 
-		// recursively render blue and orange portal
-		RenderInsidePortal(*m_Blue, m_View, m_Projection, 1, m_Iterations);
-		RenderInsidePortal(*m_Orange, m_View, m_Projection, 10, m_Iterations);
+		// recursively render blue and orange portal, skip the portal entirely if it is not visible
+		const int blueDepth = m_BlueDepth;
+		const int orangeDepth = m_OrangeDepth;
+		if (blueDepth > 0) RenderInsidePortal(*m_Blue, m_View, m_Projection, 1, blueDepth, blueDepth, pass);
+		if (orangeDepth > 0) RenderInsidePortal(*m_Orange, m_View, m_Projection, 10, orangeDepth, orangeDepth, pass);
+
+		if (pass == PASS::GEOMETRY) return;
 
 		// render skybox only to to the scene and first iterations of portal view
 		if (!s.IsFogEnabled())
 		{
+			m_Profiler->Begin(CUBEMAP);
+			RenderStats::SetView(10);
 			StencilStamp::CompareToStamp(10);
 			const auto & cm = m_Res.CubemapShader();
 			cm.Render(m_Res.Cubemap(), m_View*m_Orange->GetTeleportation(), m_Projection);
+			RenderStats::SetView(1);
 			StencilStamp::CompareToStamp(1);
 
 			cm.Render(m_Res.Cubemap(), m_View*m_Blue->GetTeleportation(), m_Projection);
+			RenderStats::SetView(0);
 			StencilStamp::CompareToStamp(0);
 			cm.Render(m_Res.Cubemap(), m_View, m_Projection);
 		}
 
+		// the rest is drawn over all views at once and counted to the main view
+		RenderStats::SetView(0);
+
 		// render transparent dynamic portal texture 
+		m_Profiler->Begin(PORTAL_TEXTURES);
 		StencilStamp::CheckInStamp(0);
 		
-		m_Res.PortalTexture().Render(*m_Blue, m_CurrentTime, m_View, m_Projection);
-		m_Res.PortalTexture().Render(*m_Orange, m_CurrentTime, m_View, m_Projection);
+		m_Res.PortalTexture().Render(*m_Blue, RenderTime(), m_View, m_Projection);
+		m_Res.PortalTexture().Render(*m_Orange, RenderTime(), m_View, m_Projection);
 
 		// finally render transparent object
-		s.Bind();
+		m_Profiler->Begin(TRANSPARENT_OBJECT);
 		s.UploadViewInfo(m_ActiveCamera->GetPosition(), m_View, m_Projection);
-		s.RenderTransparentGameObject(*m_Transparent);
+		s.RenderTransparentEntity(m_Entities, m_Transparent);
+		m_Profiler->End();
+	}
 
-		// if is menu active render the menu
-		if (m_Menu->IsActive()) m_Menu->Render();
+	void PortalTestRoom::RenderDeferred()
+	{
+		m_Levels.clear();
+		m_GBuffer->Bind();
+		m_GBuffer->Clear();
+
+		// surfaces of the scene and of every portal iteration are written inside their stencil masks
+		RenderWithStencil(PASS::GEOMETRY);
+
+		// every visible pixel is lit exactly once no matter which iteration it belongs to
+		m_GBuffer->BindLightTarget();
+		StencilStamp::DisableTest();
+		SetDepthTest(false);
+
+		m_Profiler->Begin(LIGHTING);
+		RenderStats::SetView(0);
+		m_Res.Cubemap().Bind();
+		m_Res.DeferredLighting().Render(*m_GBuffer, m_Res.Lights());
+
+		// volume of every point light is drawn with the view of each iteration, pixels of the other iterations are rejected
+		auto& volume = m_Res.LightVolume();
+		for (const auto& light : m_Res.Lights().GetPointLights())
+		{
+			volume.UploadPointLight(light, *m_GBuffer);
+			for (const auto& level : m_Levels)
+			{
+				RenderStats::SetView((unsigned) level.Level);
+				volume.Render(m_Projection * level.View, level.Level);
+			}
+		}
+
+		m_Profiler->End();
+		RenderStats::SetView(0);
+		SetDepthTest(true);
+		StencilStamp::EnableTest();
+
+		// skybox, portal textures and transparent objects are rendered forward over the lit image
+		RenderWithStencil(PASS::FORWARD);
+
+		GBuffer::Unbind();
+		SetViewport(Width(), Height());
+
+		m_Profiler->Begin(LIGHTING);
+		SetDepthTest(false);
+		m_Res.Screen().Render(*m_GBuffer);
+		SetDepthTest(true);
+		m_Profiler->End();
 	}
 
-	void PortalTestRoom::TimerUpdate()
+	void PortalTestRoom::RenderOpaqueLevel(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection,
+		int stampId, bool innermost)
+	{
+		auto& o = Opaque();
+
+		m_Profiler->Begin(LevelSection(stampId));
+		RenderStats::SetView(stampId);
+		BeginLevel(stampId, view);
+		o.UploadViewInfo(position, view, projection, ViewSlot(stampId));
+
+		// the level is rendered twice with the pre-pass, first only depth and then shaded where the depth is equal
+		for (int i = m_DepthPrePass ? 0 : 1; i < 2; ++i)
+		{
+			if (m_DepthPrePass)
+			{
+				o.SetDepthOnly(i == 0);
+				i == 0 ? DepthShader::BeginPrePass() : DepthShader::BeginEqualPass();
+			}
+
+			StencilStamp::CompareToStamp(stampId);
+			// if im under the ground update stencil buffer by the ground render
+			if (stampId == 0 && m_ActiveCamera->GetPosition().y < 0.0f) StencilStamp::StampWithShader(0);
+			// render floor
+			o.RenderEntity(m_Entities, m_RoomFloor);
+			StencilStamp::CompareToStamp(stampId);
+
+			// render all walls by the stencil comparison, so nothing will override what is inside the portal
+			o.RenderPortalWalls(*m_PortalWalls);
+			o.RenderEntity(m_Entities, m_RoomWalls);
+
+			// render the entire scene over the portal
+			innermost ? StencilStamp::CompareToStamp(stampId) : StencilStamp::CheckInStamp(stampId);
+			RenderScene(stampId);
+		}
+
+		if (m_DepthPrePass) DepthShader::EndEqualPass();
+		m_Profiler->End();
+	}
+
+	void PortalTestRoom::BeginLevel(int level, const glm::mat4& view)
 	{
-		// update the cursor or camera based on current relative mouse movement
+		if (!IsDeferred()) return;
+
+		m_Levels.push_back({ (float) level, view });
+		m_Res.Geometry().UploadLevel((float) level);
+	}
+
+	EntityShader& PortalTestRoom::Opaque() const
+	{
+		return IsDeferred() ? m_Res.Geometry() : m_Res.Entity();
+	}
+
+	void PortalTestRoom::ToggleFog()
+	{
+		// surfaces written by the geometry pass have to be fogged the same way as the forward ones
+		m_Res.Entity().ToggleFog();
+		m_Res.Geometry().ToggleFog();
+	}
+
+	void PortalTestRoom::FrameUpdate()
+	{
+		// update the cursor or camera based on current relative mouse movement,
+		// the cursor is centered again every frame so the motion is consumed once
 		if (m_Menu->IsActive()) m_Menu->UpdateCursor(Mouse::GetRelativeMotion());
 		else m_ActiveCamera->MouseMovement(Mouse::GetRelativeMotion());
+	}
+
+	void PortalTestRoom::SaveSimulationState()
+	{
+		m_PreviousCamera = m_ActiveCamera;
+		m_PreviousEye = m_ActiveCamera->GetPosition();
+	}
 
+	void PortalTestRoom::TimerUpdate()
+	{
+		// walking camera collides only with the portals and the floor, objects and the predefined camera are independent of it
 		if (m_Camera.get() == m_ActiveCamera && !m_Menu->IsActive())
-		{	
-			auto previous = m_Camera->GetPosition();
-			m_Camera->UpdatePosition(m_TimeDelta,
-				Keyboard::IsLeftShiftPressed() ? MOVEMENT_SPEED * 2.0f : MOVEMENT_SPEED, previous.y,
-				Keyboard::IsPressed(Keyboard::W),
-				Keyboard::IsPressed(Keyboard::A),
-				Keyboard::IsPressed(Keyboard::D),
-				Keyboard::IsPressed(Keyboard::S)
-			);
-			// calculate new camera position and check whether the new position collides with portal
-			HandlePortalCollision(previous);
-
-			// then check the floor collision
-			HandleFloorCollision(previous);
+		{
+			m_Jobs->Add([this]
+			{
+				auto previous = m_Camera->GetPosition();
+				m_Camera->UpdatePosition(m_TimeDelta,
+					Keyboard::IsLeftShiftPressed() ? MOVEMENT_SPEED * 2.0f : MOVEMENT_SPEED, previous.y,
+					Keyboard::IsPressed(Keyboard::W),
+					Keyboard::IsPressed(Keyboard::A),
+					Keyboard::IsPressed(Keyboard::D),
+					Keyboard::IsPressed(Keyboard::S)
+				);
+				// calculate new camera position and check whether the new position collides with portal
+				HandlePortalCollision(previous);
+
+				// then check the floor collision
+				HandleFloorCollision(previous);
+			});
 		}
 
-		m_Wheatley->Update(m_CurrentTime);
+		const unsigned movers = m_Jobs->Add([this] { m_Entities.UpdateMovers(m_CurrentTime); });
+		const unsigned transforms = m_Jobs->Add([this] { m_Entities.UpdateTransforms(); }, { movers });
+		m_Jobs->Add([this] { m_Raycast.Refit(); }, { transforms });
 
 		if (m_ActiveCamera == m_Predefined.get())
 		{
-			m_Predefined->Update(m_CurrentTime);
+			m_Jobs->Add([this] { m_Predefined->Update(m_CurrentTime); });
 		}
+		m_Jobs->Run();
 	}
 	
 	void PortalTestRoom::HandleFloorCollision(const glm::vec3& previous)
 	{
 		const auto & newPos = m_Camera->GetPosition();
 
-		for (const auto & mesh : m_RoomFloor->GetModel().GetMeshes())
+		// the same as a ray straight down from the camera, the grid tests only the triangles of one cell
+		float floorHeight;
+		if (m_FloorGrid->Height(floorHeight, newPos))
 		{
-			glm::vec3 position, dummy;
-			if (mesh->FindIntersection(position, dummy, newPos, { 0.0f, -1.0f, 0.0f }))
-			{
-				// if the intersection is found calculate free fall by the time delta
-				float y = previous.y;
+			const glm::vec3 position(newPos.x, floorHeight, newPos.z);
 
-				y = m_Velocity * m_TimeDelta + y - 10 * m_TimeDelta * m_TimeDelta;
-				m_Velocity = m_Velocity - 10 * m_TimeDelta;
+			// if the floor is found calculate free fall by the time delta
+			float y = previous.y;
 
-				const float height = position.y + CAMERA_HEIGHT;
-				if (y < height ) {
-					y = height;
-					m_Velocity = 0.0f;
-				}
-				
-				m_LastOkLocation = position;
-				m_Camera->Teleport({ newPos.x, y, newPos.z });
-				return;
+			y = m_Velocity * m_TimeDelta + y - 10 * m_TimeDelta * m_TimeDelta;
+			m_Velocity = m_Velocity - 10 * m_TimeDelta;
+
+			const float height = position.y + CAMERA_HEIGHT;
+			if (y < height ) {
+				y = height;
+				m_Velocity = 0.0f;
 			}
+			
+			m_LastOkLocation = position;
+			m_Camera->Teleport({ newPos.x, y, newPos.z });
+			return;
 		}
 		// if no collision was found teleport the camera to the last ok location
 		float y = previous.y;
@@ -385,19 +922,13 @@ namespace kvasnric
 
 	void PortalTestRoom::MountCameraOnObject()
 	{
-		ClearDepth();
-		const auto pv = m_Projection * m_View;
-		const unsigned begin = 128;
-		for (unsigned i = 0; i < m_Objects.size(); ++i)
-		{
-			const auto & obj = m_Objects[i];
-			m_Res.Stencil().StampModel(obj.GetModel(), pv*obj.GetModelMatrix(), begin + i);
-		}
+		// view ray through the middle of the screen, only pickable objects are tested like the stamped ones used to be
+		SceneRaycast::Hit hit;
+		const glm::vec3 position = m_ActiveCamera->GetPosition();
+		if (!m_Raycast.Raycast(hit, position, m_ActiveCamera->GetViewDirection(), SceneRaycast::PICKABLE)) return;
 
-		const unsigned id = StencilStamp::ReadStencilPixelValue(Width() >> 1, Height() >> 1);
-
-		if (id < begin || !m_Objects[id - begin].IsInProximity(m_ActiveCamera->GetPosition(), 5.0f)) return;
-		m_MountedCamera.reset(new MountedCamera(&m_Objects[id - begin]));
+		if (!m_Entities.IsAlive(hit.Owner) || !m_Entities.IsInProximity(hit.Owner, position, 5.0f)) return;
+		m_MountedCamera.reset(new MountedCamera(m_Entities, hit.Owner));
 		m_ActiveCamera = m_MountedCamera.get();
 	}
 
@@ -410,7 +941,7 @@ namespace kvasnric
 			switch (m_Menu->Click())
 			{
 			case Menu::TOGGLE_FOG:
-				m_Res.Entity().ToggleFog();
+				ToggleFog();
 				break;
 			case Menu::STATIC_1:
 				m_ActiveCamera = m_Static1.get();
@@ -419,7 +950,7 @@ namespace kvasnric
 				m_ActiveCamera = m_Static2.get();
 				break;
 			case Menu::WHEATLEY:
-				m_MountedCamera.reset(new MountedCamera(m_Wheatley.get()));
+				m_MountedCamera.reset(new MountedCamera(m_Entities, m_Wheatley));
 				m_ActiveCamera = m_MountedCamera.get();
 				break;
 			case Menu::EXIT_MENU:
@@ -434,31 +965,38 @@ namespace kvasnric
 		
 		if(m_ActiveCamera == m_Camera.get())
 		{
-			glm::vec3 portalLocation(0);
-			glm::vec3 normal(0);
-			
 			Portal * update = Mouse::IsLeft() ? m_Blue.get() : Mouse::IsRight() ? m_Orange.get() : nullptr;
 
 			// check if the clicking does an intersection with portal walls, then update the portals accordingly.
-			if(update != nullptr && m_PortalWalls->GetMeshes()[0]->FindIntersection( portalLocation, normal, m_Camera->GetPosition(), m_Camera->GetViewDirection()))
-			{
-				update->ModifyPortal(portalLocation, normal);
-				const float angle = m_Blue->SetTeleporation(*m_Orange);
-				m_Orange->SetTeleporation(*m_Blue);
-
-				// set the number of iterations based on the angle between portals. In 45 degrees there is no way we could see third portal iteration.
-				// if the angle is the same that mean we are able to see no recursive iteration
-				if (angle < 0.000001f) m_Iterations = 1;
-				else if (sin(angle) < 0.000001f) m_Iterations = 6;
-				else m_Iterations = 2;
-			}
+			if (update != nullptr) ShootPortal(*update, m_Camera->GetPosition(), m_Camera->GetViewDirection());
 		}
 	}
 
+	bool PortalTestRoom::ShootPortal(Portal& p, const glm::vec3& origin, const glm::vec3& direction)
+	{
+		SceneRaycast::Hit hit;
+		if (!m_Raycast.Raycast(hit, origin, direction, SceneRaycast::PORTAL_CONDUCTIVE)) return false;
+
+		// number of recursion levels is chosen every frame in Render by the screen area of the nested portals
+		p.ModifyPortal(hit.Position, hit.Normal);
+		m_Blue->SetTeleporation(*m_Orange);
+		m_Orange->SetTeleporation(*m_Blue);
+		return true;
+	}
+
 	void PortalTestRoom::ResizeUpdate()
 	{
 		m_Projection = m_ActiveCamera->GetProjectionMatrix((float) Width(), (float) Height(), 0.05f, 500.0f);
 		m_Menu->Resize(Width(), Height());
+
+		for (unsigned i = 0; i < 2; ++i)
+		{
+			if (m_BlueView[i]) m_BlueView[i]->Resize(Width(), Height());
+			if (m_OrangeView[i]) m_OrangeView[i]->Resize(Width(), Height());
+		}
+
+		if (m_GBuffer) m_GBuffer->Resize(Width(), Height());
+		m_Res.Lights().Resize(Width(), Height());
 	}
 
 	void PortalTestRoom::ReactOnKey()
@@ -466,7 +1004,7 @@ namespace kvasnric
 		if (!m_Menu->IsActive())
 		{
 			if (Keyboard::IsPressed(Keyboard::F)) {
-				m_Res.Entity().ToggleFog();
+				ToggleFog();
 			}
 
 			if (m_ActiveCamera == m_Camera.get() && Keyboard::IsPressed(Keyboard::SPACE))
@@ -480,6 +1018,56 @@ namespace kvasnric
 				m_ActiveCamera = m_Camera.get();
 			}
 
+			if (Keyboard::IsPressed(Keyboard::P))
+			{
+				m_PortalMode = m_PortalMode == PORTAL_MODE::STENCIL ? PORTAL_MODE::TEXTURE : PORTAL_MODE::STENCIL;
+			}
+
+			if (Keyboard::IsPressed(Keyboard::G))
+			{
+				m_Deferred = !m_Deferred;
+			}
+
+			if (Keyboard::IsPressed(Keyboard::L))
+			{
+				SpawnLights(LIGHT_SPAWN_COUNT);
+			}
+
+			if (Keyboard::IsPressed(Keyboard::Z))
+			{
+				m_DepthPrePass = !m_DepthPrePass;
+			}
+
+			if (Keyboard::IsPressed(Keyboard::T))
+			{
+				std::cout << "Frame profile, depth pre-pass " << (m_DepthPrePass ? "on" : "off") << ":" << std::endl;
+				m_Profiler->Print(std::cout);
+				std::cout << "Render statistics of the last frame:" << std::endl;
+				RenderStats::Print(std::cout);
+			}
+
+			if (Keyboard::IsPressed(Keyboard::N))
+			{
+				RenderStats::SetDumpInterval(RenderStats::DumpInterval() == 0 ? RENDER_STATS_DUMP_FRAMES : 0);
+			}
+
+			if (Keyboard::IsPressed(Keyboard::H))
+			{
+				m_Overlay->ToggleActive();
+			}
+
+			if (Keyboard::IsPressed(Keyboard::C))
+			{
+				if (m_Profiler->IsWritingCsv()) m_Profiler->StopCsv();
+				else if (!m_Profiler->StartCsv(PROFILER_CSV_PATH)) std::cerr << "Cannot open " << PROFILER_CSV_PATH << std::endl;
+			}
+
+			if (Keyboard::IsPressed(Keyboard::Y))
+			{
+				m_VSync = !m_VSync;
+				SetVSync(m_VSync);
+			}
+
 			if (Keyboard::IsPressed(Keyboard::M))
 			{
 				if (m_ActiveCamera != m_MountedCamera.get()) MountCameraOnObject();
@@ -524,7 +1112,7 @@ namespace kvasnric
 
 			if (Keyboard::IsPressed(Keyboard::F3))
 			{
-				m_MountedCamera.reset(new MountedCamera(m_Wheatley.get()));
+				m_MountedCamera.reset(new MountedCamera(m_Entities, m_Wheatley));
 				m_ActiveCamera = m_MountedCamera.get();
 				return;
 			}
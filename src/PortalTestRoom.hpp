@@ -9,17 +9,25 @@
 #pragma once
 
 #include <OpenGLApplication.hpp>
+#include <JobSystem.hpp>
 
-#include <Scene/GameObject.hpp>
-#include <Scene/MovingObject.hpp>
+#include <Scene/EntityStore.hpp>
+#include <Scene/HeightGrid.hpp>
+#include <Scene/SceneRaycast.hpp>
 #include <Scene/Camera/FirstPersonCamera.hpp>
 #include <Scene/Camera/MountedCamera.hpp>
 #include <Scene/Camera/PredefinedCamera.hpp>
 
 #include <Scene/PortalWalls.hpp>
 #include <Portal.hpp>
+#include <Renderer/FrameBuffer.hpp>
+#include <Renderer/GBuffer.hpp>
+#include <Renderer/GpuProfiler.hpp>
 
 #include <Menu.hpp>
+#include <ProfilerOverlay.hpp>
+
+#include <chrono>
 
 namespace kvasnric
 {
@@ -27,12 +35,43 @@ namespace kvasnric
 	class PortalTestRoom final : public OpenGLApplication
 	{
 	public:
+		// how the view through the portals is rendered
+		enum class PORTAL_MODE
+		{
+			STENCIL,
+			TEXTURE
+		};
+
+		// profiled parts of the frame, ids of the profiler sections. Levels of the blue portal follow LEVELS, then the orange ones
+		enum PROFILE : unsigned
+		{
+			STAMPS = GpuProfiler::FRAME + 1,
+			SCENE,
+			CUBEMAP,
+			PORTAL_TEXTURES,
+			TRANSPARENT_OBJECT,
+			LIGHTING,
+			MENU,
+			OVERLAY,
+			LEVELS
+		};
+
+		// which part of the scene is rendered by the stencil recursion
+		enum class PASS
+		{
+			GEOMETRY,	// opaque surfaces and portal stamps
+			FORWARD		// skybox, portal textures and transparent objects
+		};
+
 		PortalTestRoom();
 
 		// overriden callbacks from the parent class. Is called by GLUTWrapper
 		void Setup() override;
 		void Render() override;
+		void Benchmark(const std::string& output) override;
+		void FrameUpdate() override;
 		void TimerUpdate() override;
+		void SaveSimulationState() override;
 		void MouseClick() override;
 		void ResizeUpdate() override;
 		void ReactOnKey() override;
@@ -40,15 +79,137 @@ namespace kvasnric
 		void LoadResources() override;
 	private:
 		/**
-		 * Renders every "safe" object in the scene.
-		 * 
+		 * Renders every "safe" object in the scene which is inside the view frustum of the level.
+		 * Only replays the commands recorded by PrepareFrame, waits for them when their job still runs.
+		 * @param stampId stencil value of the level, zero for the scene outside the portals
+		 */
+		void RenderScene(int stampId) const;
+
+		/**
+		 * Runs everything the frame needs before its first draw call as a job graph on all cores.
+		 * Moves and transforms the entities, places the camera, chooses the portal levels
+		 * and culls the objects of every level and records their commands. OpenGL calls stay on this thread.
+		 * Returns once the views are chosen, the levels are culled and recorded while the frame is submitted
+		 * and the graph has to be finished before the entities change again.
+		 */
+		void PrepareFrame();
+
+		/**
+		 * Sets views of the levels of the portal and marks the levels rendered in this frame
+		 * @param firstStamp stamp id of the first level of the portal
+		 * @returns number of levels chosen by RecursionDepth
+		 */
+		int PrepareLevels(const Portal& p, int firstStamp);
+
+		/**
+		 * @param stampId stencil value of the level, zero for the scene outside the portals
+		 * @returns index of the level in the prepared views
+		 */
+		static int ViewSlot(int stampId);
+
+		/**
+		 * Renders the portals by masking them in the stencil buffer and recursively re-rendering the scene
+		 * for every iteration inside the mask. Geometry pass has to precede the forward pass.
+		 * @param pass part of the scene to be rendered
+		 */
+		void RenderWithStencil(PASS pass);
+
+		/**
+		 * Fills the geometry buffer through the stencil recursion, lights every visible pixel once
+		 * and blends the forward rendered objects over the result before showing it.
 		 */
-		void RenderScene() const;
+		void RenderDeferred();
+
+		/**
+		 * Renders the first iteration of both portals into offscreen targets and fills the portal elipses
+		 * with them. Caps the portal cost at roughly two scene passes.
+		 */
+		void RenderWithPortalTextures();
+
+		/**
+		 * Renders the view through the portal into an offscreen target. Deeper iterations are approximated
+		 * by drawing the nested portal filled with the previous frame image of the same portal.
+		 * @param target framebuffer the view is rendered into
+		 * @param previous framebuffer holding the view of the portal from the previous frame
+		 * @param depth number of iterations chosen for this portal in the current frame
+		 * @param stampId stamp id of the first level of the portal
+		 */
+		void RenderPortalView(const Portal& p, const FrameBuffer& target, const FrameBuffer& previous, int depth, int stampId) const;
 
 		/**
 		 * Recursively rendering a scene inside a portal. Limited by the number of iterations
+		 * @param depth number of iterations chosen for this portal in the current frame
+		 * @param pass part of the scene to be rendered
+		 */
+		void RenderInsidePortal(const Portal& p, const glm::mat4& view, const glm::mat4& projection, int stampId, int it, int depth, PASS pass);
+
+		/**
+		 * Renders floor, walls and scene of one view level inside its stencil mask. With the depth pre-pass
+		 * the level is rendered depth only first, so the shading runs once per visible pixel.
+		 * @param stampId stencil value of the level, zero for the scene outside the portals
+		 * @param innermost whether the scene is limited to the level stamp, outer levels render it over the nested portal too
+		 */
+		void RenderOpaqueLevel(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection, int stampId, bool innermost);
+
+		/**
+		 * Moves the active camera to the blend of the last two simulation steps the frame shows, the moving
+		 * objects are blended by PrepareFrame before. Restored by EndInterpolation so the simulation
+		 * continues from the stepped state.
+		 */
+		void BeginInterpolation();
+		void EndInterpolation();
+
+		/**
+		 * Registers the sections of PROFILE and of every portal level in the profiler
+		 */
+		void SetupProfiler();
+
+		/**
+		 * @param stampId stencil value of the level, zero for the scene outside the portals
+		 * @returns profiler section of the opaque surfaces of the level
 		 */
-		void RenderInsidePortal(const Portal& p, const glm::mat4& view, const glm::mat4& projection, int stampId, int it) const;
+		static unsigned LevelSection(int stampId);
+
+		/**
+		 * Draws the profiler overlay, its text is refreshed every PROFILER_OVERLAY_REFRESH seconds
+		 */
+		void RenderOverlay();
+
+		/**
+		 * Marks following geometry with the portal iteration and remembers its view for the light volumes.
+		 * Does nothing when rendering forward.
+		 * @param level stamp id of the iteration, zero for the scene outside the portals
+		 */
+		void BeginLevel(int level, const glm::mat4& view);
+
+		/**
+		 * @returns shader rendering opaque surfaces in the current rendering path
+		 */
+		EntityShader& Opaque() const;
+
+		/**
+		 * @returns whether this frame is shaded by the deferred renderer
+		 */
+		inline bool IsDeferred() const { return m_Deferred && m_PortalMode == PORTAL_MODE::STENCIL; }
+
+		/**
+		 * Toggles the fog in every shader rendering the scene
+		 */
+		void ToggleFog();
+
+		/**
+		 * Chooses the number of recursion levels of the portal by projecting the nested portal
+		 * through the teleportation chain until it covers less than PORTAL_MIN_SCREEN_AREA pixels.
+		 * The first level is rendered whenever the portal is visible, however small it is.
+		 * @returns number of levels to render, zero when the portal is not visible at all
+		 */
+		int RecursionDepth(const Portal& p) const;
+
+		/**
+		 * Lowers the recursion cap when the last frame did not fit into the frame time budget
+		 * and raises it back when there is enough time left.
+		 */
+		void UpdateDepthCap();
 
 		/**
 		 * Calls Meshes ability to detect intersection with the floor and return it.
@@ -56,6 +217,12 @@ namespace kvasnric
 		 */
 		void HandleFloorCollision(const glm::vec3& previous);
 
+		/**
+		 * Places the portal where the ray hits the portal walls and updates the teleportation of both portals
+		 * @returns whether the ray hit the portal walls
+		 */
+		bool ShootPortal(Portal& p, const glm::vec3& origin, const glm::vec3& direction);
+
 		/**
 		 * Detection of camera view vector with portal wall mesh.
 		 * Intersection is used for updating the portal
@@ -63,26 +230,57 @@ namespace kvasnric
 		void HandlePortalCollision(glm::vec3& pos) const;
 
 		/**
-		 * Draws picking objects into stencil buffer. Reads the value from the stencil buffer and
-		 * locks camera on this object.
+		 * Casts the view ray of the active camera into the pickable objects and
+		 * locks camera on the closest one if it is near enough.
 		 */
 		void MountCameraOnObject();
 
 		// divides scene setup into groups
-		void SetupLights() const;
+		void SetupLights();
+
+		/**
+		 * Adds small point lights at random places of the room to test light culling
+		 * @param count number of added lights
+		 */
+		void SpawnLights(unsigned count);
 		void SetupModels();
 		void SetupCameras();
 		
-		std::vector<GameObject> m_Objects;
-		std::unique_ptr<GameObject> m_Transparent;
+		// every object of the room, moved and transformed every simulation step
+		EntityStore m_Entities;
+
+		// culled objects of one view level and their recorded commands, filled by the frame jobs
+		struct PreparedView
+		{
+			glm::mat4 View;
+			bool Active;
+			std::vector<uint32_t> Visible;
+			EntityShader::DrawList Draws;
+			CommandList Commands;
+			// job recording the commands in the running frame graph
+			unsigned Recorded;
+		};
+
+		// main view, then the levels of the blue portal and the levels of the orange one
+		static const int VIEW_SLOTS = 1 + 2 * PORTAL_MAX_ITERATIONS;
+		std::vector<PreparedView> m_Views;
+		std::unique_ptr<JobSystem> m_Jobs;
+
+		std::vector<Entity> m_Objects;
+		Entity m_Transparent;
 		
-		std::unique_ptr<GameObject> m_RoomWalls;
-		std::unique_ptr<GameObject> m_RoomFloor;
-		std::unique_ptr<GameObject> m_BloomLabel;
+		Entity m_RoomWalls;
+		Entity m_RoomFloor;
+		// floor triangles sorted into cells for the collision of the camera
+		std::unique_ptr<HeightGrid> m_FloorGrid;
+		Entity m_BloomLabel;
 		
-		std::unique_ptr<MovingObject> m_Wheatley;
+		Entity m_Wheatley;
 		
 		std::unique_ptr<PortalWalls> m_PortalWalls;
+
+		// ray queries against all objects, refitted every simulation step
+		SceneRaycast m_Raycast;
 		
 		std::unique_ptr<FirstPersonCamera> m_Camera;
 		std::unique_ptr<MountedCamera> m_MountedCamera;
@@ -91,6 +289,11 @@ namespace kvasnric
 		std::unique_ptr<Camera> m_Static2;
 		
 		Camera* m_ActiveCamera;
+		// camera and its position before the last simulation step
+		const Camera* m_PreviousCamera;
+		glm::vec3 m_PreviousEye;
+		// simulated position of the camera while the interpolated one is rendered
+		glm::vec3 m_SimulatedEye;
 		
 		glm::mat4 m_Projection;
 		glm::mat4 m_View;
@@ -100,7 +303,37 @@ namespace kvasnric
 		
 		std::unique_ptr<Portal> m_Blue;
 		std::unique_ptr<Portal> m_Orange;
-		int m_Iterations;
+		int m_DepthCap;
+		// levels of each portal rendered in this frame
+		int m_BlueDepth;
+		int m_OrangeDepth;
+		// benchmark limits the recursion depth itself, the cap is not adapted to the frame time and small nested portals are not skipped
+		bool m_Benchmark;
+
+		PORTAL_MODE m_PortalMode;
+		// current and previous frame views through the portals
+		std::unique_ptr<FrameBuffer> m_BlueView[2];
+		std::unique_ptr<FrameBuffer> m_OrangeView[2];
+		unsigned m_ViewFrame;
+		std::chrono::steady_clock::time_point m_LastFrame;
+
+		// view of one portal iteration written into the geometry buffer
+		struct ViewLevel
+		{
+			float Level;
+			glm::mat4 View;
+		};
+
+		bool m_Deferred;
+		std::unique_ptr<GBuffer> m_GBuffer;
+		std::vector<ViewLevel> m_Levels;
+
+		bool m_DepthPrePass;
+		bool m_VSync;
+
+		std::unique_ptr<GpuProfiler> m_Profiler;
+		std::unique_ptr<ProfilerOverlay> m_Overlay;
+		std::chrono::steady_clock::time_point m_OverlayRefresh;
 
 		std::unique_ptr<Menu> m_Menu;
 	};
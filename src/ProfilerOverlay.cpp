@@ -0,0 +1,120 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ProfilerOverlay.cpp
+ * \author     Richard Kvasnica
+ * \brief      Profiler overlay class definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "ProfilerOverlay.hpp"
+
+#include <gl_core_4_4.h>
+#include <Scene/Texture.hpp>
+#include <Renderer/FrameSync.hpp>
+#include <Renderer/RenderStats.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+namespace kvasnric
+{
+	// 3x5 pixel glyphs of ascii characters 32 to 95, five rows of three bits from the top, the left pixel is the highest bit
+	static const int FONT[64] = {
+		0x0000, 0x2482, 0x5A00, 0x5F7D, 0x3C9E, 0x52A5, 0x2AAB, 0x2400,
+		0x1491, 0x4494, 0x0AA8, 0x05D0, 0x0014, 0x01C0, 0x0002, 0x12A4,
+		0x7B6F, 0x2C97, 0x73E7, 0x72CF, 0x5BC9, 0x79CF, 0x79EF, 0x7252,
+		0x7BEF, 0x7BCF, 0x0410, 0x0414, 0x1511, 0x0E38, 0x4454, 0x72C2,
+		0x7BE7, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,
+		0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,
+		0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,
+		0x5AAD, 0x5A92, 0x72A7, 0x3493, 0x4889, 0x6496, 0x2A00, 0x0007,
+	};
+
+	ProfilerOverlay::ProfilerOverlay()
+		: ShaderProgram(ReadShaderFromFile("res/shaders/screen.vert"), ReadShaderFromFile("res/shaders/overlay.frag"))
+		, u_Text(-1), u_Font(-1), u_Origin(-1), u_Scale(-1), u_Size(-1), m_Texture(0), m_Characters{}, m_Rows(0)
+		, m_Active(false), m_Empty(new VertexArray())
+	{
+		AssignLocation(u_Text);
+		AssignLocation(u_Font);
+		AssignLocation(u_Origin);
+		AssignLocation(u_Scale);
+		AssignLocation(u_Size);
+
+		SetUniform1i(u_Text, Texture::DIFFUSE);
+		SetUniform1iv(u_Font, FONT, 64);
+		SetUniform1i(u_Scale, 2);
+
+		glGenTextures(1, &m_Texture);
+		glBindTexture(GL_TEXTURE_2D, m_Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, COLUMNS, ROWS, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, m_Characters);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	ProfilerOverlay::~ProfilerOverlay()
+	{
+		glDeleteTextures(1, &m_Texture);
+	}
+
+	void ProfilerOverlay::Update(const GpuProfiler& profiler)
+	{
+		char line[COLUMNS + 1];
+		const auto frame = profiler.GetStatistics(GpuProfiler::FRAME);
+
+		m_Rows = 0;
+		std::snprintf(line, sizeof(line), "FPS %.1f  DROPPED %u%s", frame.CpuAverage > 0.0f ? 1000.0f / frame.CpuAverage : 0.0f,
+			profiler.Dropped(), profiler.IsWritingCsv() ? "  CSV" : "");
+		WriteLine(m_Rows++, line);
+
+		// from reading the input of a frame until the GPU finished it
+		const auto sync = FrameSync::GetStatistics();
+		std::snprintf(line, sizeof(line), "LATENCY %.1f P99 %.1f  GPU WAIT %.2f", sync.LatencyAverage, sync.LatencyP99, sync.WaitAverage);
+		WriteLine(m_Rows++, line);
+		WriteLine(m_Rows++, "SECTION          GPU AVG    P99 CPU AVG    P99");
+
+		for (unsigned i = 0; i < profiler.SectionCount() && m_Rows < ROWS; ++i)
+		{
+			const auto s = profiler.GetStatistics(i);
+			std::snprintf(line, sizeof(line), "%-16.16s %7.2f %6.2f %7.2f %6.2f",
+				profiler.Name(i).c_str(), s.GpuAverage, s.GpuP99, s.CpuAverage, s.CpuP99);
+			WriteLine(m_Rows++, line);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, m_Texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, COLUMNS, m_Rows, GL_RED_INTEGER, GL_UNSIGNED_BYTE, m_Characters);
+	}
+
+	void ProfilerOverlay::WriteLine(unsigned row, const char* text)
+	{
+		// the font has no lowercase glyphs
+		unsigned i = 0;
+		for (; i < COLUMNS && text[i] != '\0'; ++i)
+		{
+			const char c = text[i];
+			m_Characters[row][i] = (unsigned char) (c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c);
+		}
+		std::memset(m_Characters[row] + i, ' ', COLUMNS - i);
+	}
+
+	void ProfilerOverlay::Render(int height) const
+	{
+		Bind();
+
+		glActiveTexture(GL_TEXTURE0 + Texture::DIFFUSE);
+		glBindTexture(GL_TEXTURE_2D, m_Texture);
+		RenderStats::Count(RenderStats::TEXTURE_BINDS);
+		m_Empty->Bind();
+
+		// text starts a few pixels from the top left corner
+		SetUniform2f(u_Origin, glm::vec2(8.0f, height - 8.0f));
+		SetUniform2f(u_Size, glm::vec2(COLUMNS, m_Rows));
+
+		glDisable(GL_DEPTH_TEST);
+		EnableBlending();
+		RenderFullScreenTriangle();
+		DisableBlending();
+		glEnable(GL_DEPTH_TEST);
+	}
+}
@@ -0,0 +1,62 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ProfilerOverlay.hpp
+ * \author     Richard Kvasnica
+ * \brief      Profiler overlay class declaration
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <Renderer/ShaderProgram.hpp>
+#include <Renderer/GpuProfiler.hpp>
+
+namespace kvasnric
+{
+	/**
+	 * Shows the profiler statistics as a text table in the top left corner of the screen.
+	 * Text is kept in a texture of character codes and drawn with a 3x5 pixel font defined in the constructor.
+	 */
+	class ProfilerOverlay final : public ShaderProgram
+	{
+	public:
+		ProfilerOverlay();
+		~ProfilerOverlay() override;
+
+		/**
+		 * Formats statistics of every profiler section into the text texture
+		 */
+		void Update(const GpuProfiler& profiler);
+
+		/**
+		 * Renders the text over the currently rendered scene
+		 * @param height window height, the text is anchored to the top left corner
+		 */
+		void Render(int height) const;
+
+		inline bool IsActive() const { return m_Active; }
+		inline void ToggleActive() { m_Active = !m_Active; }
+	private:
+		/**
+		 * Writes one line of text into the character buffer, the rest of the line is cleared
+		 */
+		void WriteLine(unsigned row, const char* text);
+
+		static const unsigned COLUMNS = 52;
+		static const unsigned ROWS = 24;
+
+		int u_Text;
+		int u_Font;
+		int u_Origin;
+		int u_Scale;
+		int u_Size;
+
+		unsigned m_Texture;
+		unsigned char m_Characters[ROWS][COLUMNS];
+		unsigned m_Rows;
+		bool m_Active;
+
+		// vertices are generated in the shader, core profile still needs a vao bound
+		std::unique_ptr<VertexArray> m_Empty;
+	};
+}
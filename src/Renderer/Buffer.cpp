@@ -2,16 +2,39 @@
 /**
  * \file       Buffer.cpp
  * \author     Richard Kvasnica
- * \brief      VBO and EBO class definitions
+ * \brief      VBO, EBO, SSBO and streamed SSBO class definitions
 */
 //----------------------------------------------------------------------------------------
 
 #include "Buffer.hpp"
+#include "FrameSync.hpp"
+#include "RenderStats.hpp"
 
 #include "gl_core_4_4.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace kvasnric
 {
+	namespace
+	{
+		// persistent mapping needs OpenGL 4.4 or ARB_buffer_storage, the loader loads the function without checking either
+		bool HasBufferStorage()
+		{
+			if (glBufferStorage == nullptr) return false;
+			if (ogl_IsVersionGEQ(4, 4)) return true;
+
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for (GLint i = 0; i < count; ++i)
+			{
+				if (std::strcmp((const char*) glGetStringi(GL_EXTENSIONS, i), "GL_ARB_buffer_storage") == 0) return true;
+			}
+			return false;
+		}
+	}
+
 	/////////////////////////////////////////////
 	// VBO
 	VertexBuffer::VertexBuffer(const void* vertices, unsigned size, DRAW type)
@@ -20,6 +43,7 @@ namespace kvasnric
 		glGenBuffers(1, &m_ID);
 		glBindBuffer(GL_ARRAY_BUFFER, m_ID);
 		glBufferData(GL_ARRAY_BUFFER, size, vertices, (GLenum) m_Type);
+		RenderStats::Count(RenderStats::BUFFER_BYTES, size);
 	}
 
 	VertexBuffer::~VertexBuffer()
@@ -45,6 +69,7 @@ namespace kvasnric
 		glGenBuffers(1, &m_ID);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, (GLenum) m_Type);
+		RenderStats::Count(RenderStats::BUFFER_BYTES, size);
 	}
 
 	ElementBuffer::~ElementBuffer()
@@ -62,4 +87,126 @@ namespace kvasnric
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 
+	//////////////////////////////////////////////
+	// SSBO
+	ShaderStorageBuffer::ShaderStorageBuffer(unsigned binding, DRAW type)
+		: m_ID(0), m_Binding(binding), m_Type(type)
+	{
+		glGenBuffers(1, &m_ID);
+	}
+
+	ShaderStorageBuffer::~ShaderStorageBuffer()
+	{
+		glDeleteBuffers(1, &m_ID);
+	}
+
+	void ShaderStorageBuffer::Upload(const void* data, unsigned size) const
+	{
+		// empty buffers cannot be bound, keep at least one vec4
+		const float empty[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ID);
+		if (size == 0) glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(empty), empty, (GLenum) m_Type);
+		else glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, (GLenum) m_Type);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_Binding, m_ID);
+		RenderStats::Count(RenderStats::BUFFER_BYTES, size);
+	}
+
+	void ShaderStorageBuffer::Bind() const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_Binding, m_ID);
+	}
+
+	//////////////////////////////////////////////
+	// Streamed SSBO
+	StreamBuffer::StreamBuffer(unsigned frameSize)
+		: m_ID(0), m_Mapped(nullptr), m_FrameSize(0), m_Alignment(1), m_Persistent(HasBufferStorage())
+		, m_Frame(FrameSync::Frame()), m_Offset(0)
+	{
+		GLint alignment = 1;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		m_Alignment = (unsigned) std::max(alignment, 1);
+
+		Allocate(frameSize);
+	}
+
+	StreamBuffer::~StreamBuffer()
+	{
+		// deleting the buffer unmaps it
+		glDeleteBuffers(1, &m_ID);
+		for (const auto& retired : m_Retired) glDeleteBuffers(1, &retired.ID);
+	}
+
+	void StreamBuffer::Allocate(unsigned frameSize)
+	{
+		if (m_ID != 0) m_Retired.push_back({ m_ID, m_Frame });
+
+		// every part starts at an offset the binding accepts
+		m_FrameSize = (frameSize + m_Alignment - 1) / m_Alignment * m_Alignment;
+		m_Offset = 0;
+
+		glGenBuffers(1, &m_ID);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ID);
+
+		if (!m_Persistent)
+		{
+			// orphaned every frame instead, the driver keeps the storage of the frames in flight
+			m_Mapped = nullptr;
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_FrameSize, nullptr, GL_STREAM_DRAW);
+			return;
+		}
+
+		// coherent mapping makes the writes visible to the commands issued after them without any flush
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr size = (GLsizeiptr) m_FrameSize * FRAMES_IN_FLIGHT;
+
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, flags);
+		m_Mapped = (unsigned char*) glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, flags);
+	}
+
+	StreamBuffer::Range StreamBuffer::Upload(unsigned binding, const void* data, unsigned size)
+	{
+		// a new frame writes from the start of its part, the frame which wrote there before is finished
+		if (m_Frame != FrameSync::Frame())
+		{
+			m_Frame = FrameSync::Frame();
+			m_Offset = 0;
+
+			const auto finished = std::remove_if(m_Retired.begin(), m_Retired.end(), [this](const Retired& retired)
+			{
+				if (retired.Frame + FRAMES_IN_FLIGHT > m_Frame) return false;
+				glDeleteBuffers(1, &retired.ID);
+				return true;
+			});
+			m_Retired.erase(finished, m_Retired.end());
+		}
+
+		// empty ranges cannot be bound, keep at least one vec4
+		const unsigned bytes = std::max(size, 16u);
+		if (m_Offset + bytes > m_FrameSize) Allocate(std::max(2 * m_FrameSize, bytes));
+
+		const unsigned offset = (m_Persistent ? FrameSync::Slot() * m_FrameSize : 0) + m_Offset;
+		if (size > 0 && m_Persistent) std::memcpy(m_Mapped + offset, data, size);
+		else if (size > 0)
+		{
+			// the first upload of the frame orphans the buffer, the later ones write where nothing was bound since then
+			const GLbitfield access = GL_MAP_WRITE_BIT
+				| (m_Offset == 0 ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ID);
+			std::memcpy(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, offset, size, access), data, size);
+			glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		}
+		const Range range = { m_ID, offset, bytes };
+		Bind(binding, range);
+
+		m_Offset += (bytes + m_Alignment - 1) / m_Alignment * m_Alignment;
+		RenderStats::Count(RenderStats::BUFFER_BYTES, size);
+		return range;
+	}
+
+	void StreamBuffer::Bind(unsigned binding, const Range& range)
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, range.Buffer, range.Offset, range.Size);
+	}
 }
\ No newline at end of file
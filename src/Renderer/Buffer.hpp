@@ -2,7 +2,7 @@
 /**
  * \file       Buffer.hpp
  * \author     Richard Kvasnica
- * \brief      VBO and EBO class declarations
+ * \brief      VBO, EBO, SSBO and streamed SSBO class declarations
  *
  * Class wrapping the functionality of OpenGL vertex buffer objects
 */
@@ -10,6 +10,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 namespace kvasnric
 {
 	// hardcoded GLenum values
@@ -83,5 +86,99 @@ namespace kvasnric
 		unsigned m_ID;
 		DRAW m_Type;
 	};
+
+	// Class wraps functionality of shader storage buffer object (SSBO) attached to a fixed binding point
+	class ShaderStorageBuffer
+	{
+	public:
+		/**
+		 * Shader storage buffer constructor. Creates empty SSBO
+		 * @param binding index of the binding point declared in the shader by layout(binding = ...)
+		 * @param type tells how the gpu should store the data
+		 */
+		ShaderStorageBuffer(unsigned binding, DRAW type);
+		~ShaderStorageBuffer();
+
+		/**
+		 * Replaces the whole content of the buffer and attaches it to its binding point
+		 * @param data pointer to the data laid out by std430 rules
+		 * @param size size of the data in bytes
+		 */
+		void Upload(const void* data, unsigned size) const;
+
+		/**
+		 * Attaches buffer to its binding point
+		 */
+		void Bind() const;
+	private:
+		unsigned m_ID;
+		unsigned m_Binding;
+		DRAW m_Type;
+	};
+
+	// Class wraps one persistently mapped storage buffer split into FRAMES_IN_FLIGHT parts. Every frame writes its uploads
+	// one after another into its own part and attaches them to the binding points by ranges, so nothing the GPU
+	// still reads is overwritten and no upload waits as long as FrameSync paces the frames.
+	// Without buffer storage the buffer holds one part and is orphaned by the first upload of every frame.
+	class StreamBuffer
+	{
+	public:
+		/**
+		 * Stream buffer constructor. Creates and maps the buffer
+		 * @param frameSize bytes one frame can upload, the stream moves into a larger buffer when a frame needs more
+		 */
+		explicit StreamBuffer(unsigned frameSize);
+		~StreamBuffer();
+
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+		// part of the stream written by one upload, it can be bound again until the frame which wrote it ends
+		struct Range
+		{
+			unsigned Buffer;
+			unsigned Offset;
+			unsigned Size;
+		};
+
+		/**
+		 * Copies the data after the previous uploads of the frame and attaches the range to the binding point
+		 * @param binding index of the binding point declared in the shader by layout(binding = ...)
+		 * @param data pointer to the data laid out by std430 rules
+		 * @param size size of the data in bytes
+		 * @returns written range
+		 */
+		Range Upload(unsigned binding, const void* data, unsigned size);
+
+		/**
+		 * Attaches a range uploaded earlier in the same frame to the binding point
+		 */
+		static void Bind(unsigned binding, const Range& range);
+	private:
+		// replaced buffer, deleted once no frame in flight reads it
+		struct Retired
+		{
+			unsigned ID;
+			uint64_t Frame;
+		};
+
+		/**
+		 * Moves the stream into a new buffer, ranges bound from the old one stay valid
+		 */
+		void Allocate(unsigned frameSize);
+
+		unsigned m_ID;
+		unsigned char* m_Mapped;
+		unsigned m_FrameSize;
+		unsigned m_Alignment;
+		// mapped persistently, otherwise mapped by every upload
+		bool m_Persistent;
+
+		// frame writing into the buffer and the end of its uploads in its part
+		uint64_t m_Frame;
+		unsigned m_Offset;
+
+		std::vector<Retired> m_Retired;
+	};
 }
 
@@ -0,0 +1,65 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CommandList.cpp
+ * \author     Richard Kvasnica
+ * \brief      Recorded render commands of one view definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "CommandList.hpp"
+
+namespace kvasnric
+{
+	CommandList::CommandList()
+		: m_Draws(0), m_Features(0), m_Mesh(nullptr), m_Model(false)
+	{
+	}
+
+	void CommandList::Clear()
+	{
+		m_Commands.clear();
+		m_Matrices.clear();
+		m_Draws = 0;
+		m_Mesh = nullptr;
+		m_Model = false;
+	}
+
+	void CommandList::Push(TYPE type, uint32_t arg)
+	{
+		Command command;
+		command.Type = type;
+		command.Arg = arg;
+		command.Instance = nullptr;
+		m_Commands.push_back(command);
+	}
+
+	void CommandList::Draw(unsigned features, const Mesh& mesh, const glm::mat4& model)
+	{
+		if (m_Commands.empty() || features != m_Features)
+		{
+			Push(TYPE::BIND_PROGRAM, features);
+			m_Features = features;
+			m_Mesh = nullptr;
+			m_Model = false;
+		}
+
+		if (&mesh != m_Mesh)
+		{
+			Push(TYPE::BIND_MESH, 0);
+			m_Commands.back().Instance = &mesh;
+			m_Mesh = &mesh;
+		}
+
+		// consecutive draws of one instance share the matrix
+		if (!m_Model || model != m_Matrices.back())
+		{
+			Push(TYPE::SET_MODEL, (uint32_t) m_Matrices.size());
+			m_Matrices.push_back(model);
+			m_Model = true;
+		}
+
+		Push(TYPE::DRAW, 0);
+		m_Commands.back().Count = mesh.GetCountOfIndices();
+		++m_Draws;
+	}
+}
@@ -0,0 +1,80 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CommandList.hpp
+ * \author     Richard Kvasnica
+ * \brief      Recorded render commands of one view declaration
+ *
+ * Commands are recorded without any OpenGL call, so the lists of different views can be built by worker
+ * threads while the main thread renders. The main thread only replays them. Storage is kept between frames,
+ * a list recorded every frame allocates only when it grows.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <Scene/Mesh.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kvasnric
+{
+	// Compact stream of state changes and draws of one view, state is recorded only when it changes
+	class CommandList final
+	{
+	public:
+		enum class TYPE : uint32_t
+		{
+			BIND_PROGRAM,	// Arg is the feature mask of the shader variant
+			BIND_MESH,		// Instance is the mesh whose vertex array and material are bound
+			SET_MODEL,		// Arg is the index of the model matrix in the list
+			DRAW			// Arg is the byte offset of the first index, Count the number of indices
+		};
+
+		struct Command
+		{
+			TYPE Type;
+			uint32_t Arg;
+			union
+			{
+				const Mesh* Instance;
+				uint32_t Count;
+			};
+		};
+
+		CommandList();
+
+		/**
+		 * Drops the recorded commands, the memory is kept for the next recording
+		 */
+		void Clear();
+
+		/**
+		 * Records draw of the whole mesh preceded by the state it needs
+		 * @param features feature mask of the shader variant
+		 * @param mesh mesh drawn, has to live until the list is replayed
+		 * @param model model matrix of the instance
+		 */
+		void Draw(unsigned features, const Mesh& mesh, const glm::mat4& model);
+
+		inline const std::vector<Command>& Commands() const { return m_Commands; }
+		inline const glm::mat4& Matrix(uint32_t index) const { return m_Matrices[index]; }
+
+		/**
+		 * @returns number of recorded draws
+		 */
+		inline size_t DrawCount() const { return m_Draws; }
+	private:
+		void Push(TYPE type, uint32_t arg);
+
+		std::vector<Command> m_Commands;
+		std::vector<glm::mat4> m_Matrices;
+		size_t m_Draws;
+
+		// state at the end of the list, uniforms belong to the program so they are set again after it changes
+		unsigned m_Features;
+		const Mesh* m_Mesh;
+		bool m_Model;
+	};
+}
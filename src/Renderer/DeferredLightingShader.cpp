@@ -0,0 +1,56 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DeferredLightingShader.cpp
+ * \author     Richard Kvasnica
+ * \brief      Child class deferred lighting shader definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "DeferredLightingShader.hpp"
+
+#include <Scene/Texture.hpp>
+
+namespace kvasnric
+{
+	DeferredLightingShader::DeferredLightingShader()
+		: ShaderProgram(ReadShaderFromFile("res/shaders/screen.vert"), ReadShaderFromFile("res/shaders/deferredLighting.frag"))
+		, u_Position(-1), u_Normal(-1), u_Albedo(-1), u_Specular(-1), u_Ambient(-1), u_View(-1)
+		, u_CubeMap(-1), u_SpotLights(-1), u_SkyColor(-1), m_Empty(new VertexArray())
+	{
+		AssignLocation(u_Position);
+		AssignLocation(u_Normal);
+		AssignLocation(u_Albedo);
+		AssignLocation(u_Specular);
+		AssignLocation(u_Ambient);
+		AssignLocation(u_View);
+		AssignLocation(u_CubeMap);
+		AssignLocation(u_SpotLights);
+		AssignLocation(u_SkyColor);
+
+		// geometry targets are bound to the slots of their attachment number
+		SetUniform1i(u_Position, GBuffer::POSITION);
+		SetUniform1i(u_Normal, GBuffer::NORMAL);
+		SetUniform1i(u_Albedo, GBuffer::ALBEDO);
+		SetUniform1i(u_Specular, GBuffer::SPECULAR);
+		SetUniform1i(u_Ambient, GBuffer::AMBIENT);
+		SetUniform1i(u_View, GBuffer::VIEW);
+		SetUniform1i(u_CubeMap, Texture::CUBEMAP);
+		SetUniform1i(u_SpotLights, 0);
+	}
+
+	void DeferredLightingShader::Render(const GBuffer& gbuffer, const LightClusters& lights) const
+	{
+		Bind();
+		SetUniform1i(u_SpotLights, (int) lights.SpotLightCount());
+
+		gbuffer.BindGeometryTextures();
+		m_Empty->Bind();
+
+		RenderFullScreenTriangle();
+	}
+
+	void DeferredLightingShader::UploadSkyColor(const glm::vec3& sky) const
+	{
+		SetUniform3f(u_SkyColor, sky);
+	}
+}
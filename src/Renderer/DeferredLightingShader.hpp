@@ -0,0 +1,51 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DeferredLightingShader.hpp
+ * \author     Richard Kvasnica
+ * \brief      Child class deferred lighting shader declaration
+ *
+ * Lights every pixel of the geometry buffer once by the sun, spot lights and the environment.
+ * Point lights are added afterwards by the light volumes.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ShaderProgram.hpp"
+#include "GBuffer.hpp"
+#include "LightClusters.hpp"
+
+namespace kvasnric
+{
+	class DeferredLightingShader final : public ShaderProgram
+	{
+	public:
+		DeferredLightingShader();
+		~DeferredLightingShader() override = default;
+
+		/**
+		 * Renders a full screen pass reading the geometry targets. Cubemap has to be bound.
+		 * @param gbuffer geometry buffer filled by the geometry pass
+		 * @param lights lights whose spot light storage buffer is read by the pass
+		 */
+		void Render(const GBuffer& gbuffer, const LightClusters& lights) const;
+
+		/**
+		 * Uploads color of a sky
+		 */
+		void UploadSkyColor(const glm::vec3& sky) const;
+	private:
+		int u_Position;
+		int u_Normal;
+		int u_Albedo;
+		int u_Specular;
+		int u_Ambient;
+		int u_View;
+		int u_CubeMap;
+		int u_SpotLights;
+		int u_SkyColor;
+
+		// vertices are generated in the shader, core profile still needs a vao bound
+		std::unique_ptr<VertexArray> m_Empty;
+	};
+}
@@ -0,0 +1,59 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DepthShader.cpp
+ * \author     Richard Kvasnica
+ * \brief      Child class depth shader definition
+ *
+ * Writes only depth of opaque meshes so the following shading pass runs once per visible pixel.
+*/
+//----------------------------------------------------------------------------------------
+
+#include "DepthShader.hpp"
+
+#include <gl_core_4_4.h>
+
+namespace kvasnric
+{
+	DepthShader::DepthShader()
+		: ShaderProgram(ReadShaderFromFile("res/shaders/depth.vert"), ReadShaderFromFile("res/shaders/depth.frag"))
+		, u_Projection(-1), u_View(-1), u_Model(-1)
+	{
+		AssignLocation(u_Projection);
+		AssignLocation(u_View);
+		AssignLocation(u_Model);
+	}
+
+	void DepthShader::UploadViewInfo(const glm::mat4& view, const glm::mat4& projection) const
+	{
+		SetUniformMat4(u_View, view);
+		SetUniformMat4(u_Projection, projection);
+	}
+
+	void DepthShader::RenderMesh(const Mesh& m, const glm::mat4& model) const
+	{
+		// material textures are not bound, only the positions
+		m.BindPositions();
+		SetUniformMat4(u_Model, model);
+		RenderElements(0, m.GetCountOfIndices());
+	}
+
+	void DepthShader::BeginPrePass()
+	{
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+
+	void DepthShader::BeginEqualPass()
+	{
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	void DepthShader::EndEqualPass()
+	{
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+}
@@ -0,0 +1,55 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DepthShader.hpp
+ * \author     Richard Kvasnica
+ * \brief      Child class depth shader declaration
+ *
+ * Writes only depth of opaque meshes so the following shading pass runs once per visible pixel.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ShaderProgram.hpp"
+#include <Scene/Mesh.hpp>
+
+namespace kvasnric
+{
+	class DepthShader final : public ShaderProgram
+	{
+	public:
+		DepthShader();
+		~DepthShader() override = default;
+
+		/**
+		 * Uploads transformation of the view, has to be the same as the one of the shading pass
+		 */
+		void UploadViewInfo(const glm::mat4& view, const glm::mat4& projection) const;
+
+		/**
+		 * Renders positions of the mesh into the depth buffer
+		 * @param m const reference to a Mesh instance
+		 * @param model model matrix of the instance
+		 */
+		void RenderMesh(const Mesh& m, const glm::mat4& model) const;
+
+		/**
+		 * Masks color writes, following draws write only depth
+		 */
+		static void BeginPrePass();
+
+		/**
+		 * Following draws pass only where their depth equals the pre-pass. Depth is not written again.
+		 */
+		static void BeginEqualPass();
+
+		/**
+		 * Restores default depth test and writes
+		 */
+		static void EndEqualPass();
+	private:
+		int u_Projection;
+		int u_View;
+		int u_Model;
+	};
+}
@@ -2,136 +2,297 @@
 /**
  * \file       EntityShader.hpp
  * \author     Richard Kvasnica
- * \brief      Child class entity shader definition
+ * \brief      Entity shader definition
 */
 //----------------------------------------------------------------------------------------
 
 #include "EntityShader.hpp"
+#include "ProgramCache.hpp"
+
+#include <algorithm>
+#include <functional>
 
 namespace kvasnric
 {
 	EntityShader::EntityShader(const std::string& vertexSrc, const std::string& fragSrc)
-		: ShaderProgram(vertexSrc, fragSrc), m_PointLightCnt( 0 ), m_SpotLightCnt( 0 ), m_Fog( false )
+		: m_VertexSrc( vertexSrc ), m_FragSrc( fragSrc ), m_State(), m_StateVersion( 1 )
+		, m_Lights( nullptr ), m_Depth( nullptr ), m_DepthOnly( false ), m_Fog( false )
 	{
-		InitUniformLocations();
-		InitTextureSamplers();
-		Unbind();
+		m_State.View = UNIT_MATRIX;
+		m_State.Projection = UNIT_MATRIX;
+
+		// the most common variant is compiled right away, so the errors in sources show up on load
+		GetVariant(Features(Material()));
+		Variant::Unbind();
 	}
 
-	void EntityShader::RenderGameObject(const GameObject& obj) const
+	void EntityShader::RenderEntity(const EntityStore& store, Entity entity)
 	{
-		// uploads model matrix first then, renders model inside gameobject
-		UploadModelMatrix(obj.GetModelMatrix());
-		RenderModel(obj.GetModel());
+		RenderModel(store.GetModel(entity), store.GetModelMatrix(entity));
 	}
 
-	void EntityShader::RenderGameObject(const GameObject& obj, const glm::mat4& transform) const
+	void EntityShader::RenderTransparentEntity(const EntityStore& store, Entity entity)
 	{
-		UploadModelMatrix(transform*obj.GetModelMatrix());
-		RenderModel(obj.GetModel());
+		RenderTransparentModel(store.GetModel(entity), store.GetModelMatrix(entity));
 	}
 
-	
-	void EntityShader::RenderTransparentGameObject(const GameObject& obj) const
+	void EntityShader::RenderTransparentModel(const Model& m, const glm::mat4& model)
 	{
+		// blending depends on the order, so the meshes keep the order of the model
+		Collect(m, model);
+		Record(m_Commands, m_Draws);
+
 		// renders object exactly twice. First time with culling to back faces and then to front faces.
-		UploadModelMatrix(obj.GetModelMatrix());
+		Variant::EnableBlending();
+		Variant::RenderBackFace();
+		Replay(m_Commands);
+		Variant::RenderFrontFace();
+		Replay(m_Commands);
+		Variant::DisableBlending();
+	}
 
-		EnableBlending();
-		RenderBackFace();
-		RenderModel(obj.GetModel());
-		RenderFrontFace();
-		RenderModel(obj.GetModel());
-		DisableBlending();
+	void EntityShader::RenderModel(const Model& m, const glm::mat4& model)
+	{
+		Collect(m, model);
+		Sort(m_Draws);
+		Record(m_Commands, m_Draws);
+		Replay(m_Commands);
 	}
 
-	void EntityShader::RenderModel(const Model& m) const
+	void EntityShader::Collect(const Model& m, const glm::mat4& model)
 	{
-		// renders each mesh in model
+		m_Draws.clear();
 		for (const auto& mesh : m.GetMeshes())
 		{
-			RenderMesh(*mesh);
+			m_Draws.push_back({ Features(mesh->GetMaterial()), mesh.get(), model });
+		}
+	}
+
+	void EntityShader::RenderPortalWalls(const PortalWalls& pw, const glm::mat4& model)
+	{
+		RenderModel(pw, model);
+	}
+
+	void EntityShader::Prepare(DrawList& list, const EntityStore& store, const std::vector<uint32_t>& visible)
+	{
+		list.clear();
+		for (const uint32_t i : visible)
+		{
+			const glm::mat4& model = store.GetModelMatrixAt(i);
+			for (const auto& mesh : store.GetModelAt(i).GetMeshes())
+			{
+				list.push_back({ Features(mesh->GetMaterial()), mesh.get(), model });
+			}
 		}
+		Sort(list);
 	}
 
-	void EntityShader::RenderMesh(const Mesh& m) const
+	void EntityShader::Sort(DrawList& list)
 	{
-		// bind mesh, upload its material properties and render
-		m.Bind();
-		UploadMaterialProperties(m.GetMaterial());
-		RenderElements(0, m.GetCountOfIndices());
+		// instances of one mesh follow each other, so its vertex array and material are bound once
+		std::sort(list.begin(), list.end(), [](const DrawItem& a, const DrawItem& b)
+		{
+			return a.Features != b.Features ? a.Features < b.Features : std::less<const Mesh*>()(a.Instance, b.Instance);
+		});
 	}
 
-	void EntityShader::RenderPortalWalls(const PortalWalls& pw, const glm::mat4& model) const
+	void EntityShader::Record(CommandList& commands, const DrawList& list)
 	{
-		UploadModelMatrix(model);
-		RenderModel(pw);
+		commands.Clear();
+		for (const auto& item : list)
+		{
+			commands.Draw(item.Features, *item.Instance, item.Model);
+		}
+	}
+
+	void EntityShader::Replay(const CommandList& commands)
+	{
+		Variant* variant = nullptr;
+		const Mesh* mesh = nullptr;
+		const glm::mat4* model = &UNIT_MATRIX;
+
+		for (const auto& command : commands.Commands())
+		{
+			switch (command.Type)
+			{
+			case CommandList::TYPE::BIND_PROGRAM:
+				if (!m_DepthOnly) variant = &BindVariant(command.Arg);
+				break;
+			case CommandList::TYPE::BIND_MESH:
+				mesh = command.Instance;
+				if (m_DepthOnly) break;
+				mesh->Bind();
+				variant->UploadMaterialProperties(mesh->GetMaterial());
+				break;
+			case CommandList::TYPE::SET_MODEL:
+				model = &commands.Matrix(command.Arg);
+				if (!m_DepthOnly) variant->UploadModelMatrix(*model);
+				break;
+			case CommandList::TYPE::DRAW:
+				// depth shader binds its own program and the positions of the mesh
+				if (m_DepthOnly) m_Depth->RenderMesh(*mesh, *model);
+				else Variant::RenderElements(command.Arg, command.Count);
+				break;
+			}
+		}
 	}
 
 	void EntityShader::ToggleFog()
 	{
-		Bind();
 		m_Fog = !m_Fog;
-		SetUniform1i(vu.Fog, m_Fog);
 	}
 	
-	void EntityShader::UploadViewInfo(const glm::vec3& pos, const glm::mat4& view, const glm::mat4& projection) const
+	void EntityShader::UploadViewInfo(const glm::vec3& pos, const glm::mat4& view, const glm::mat4& projection, unsigned slot)
 	{
-		SetUniform3f(vu.ViewPosition, pos);
-		SetUniformMat4(vu.View, view);
-		SetUniformMat4(vu.Projection, projection);
+		m_State.ViewPosition = pos;
+		m_State.View = view;
+		m_State.Projection = projection;
+
+		if (m_Lights != nullptr)
+		{
+			// every portal iteration has its own view and slot, both passes over it share the lights binned once
+			m_Lights->Update(view, projection, slot);
+			m_State.TileSize = m_Lights->TileSize();
+			m_State.DepthSlicing = m_Lights->DepthSlicing();
+		}
+		++m_StateVersion;
 	}
 
-	void EntityShader::UploadPointLight(const kvasnric::PointLight& point)
+	void EntityShader::UploadPointLight(const PointLight& point)
 	{
-		SetUniform3f(fu.point[m_PointLightCnt].position, point.GetPosition());
-		SetUniform3f(fu.point[m_PointLightCnt].diffuse, point.GetDiffuse());
-		SetUniform3f(fu.point[m_PointLightCnt].specular, point.GetSpecular());
-		SetUniform3f(fu.point[m_PointLightCnt].ambient, point.GetAmbient());
-		SetUniform1f(fu.point[m_PointLightCnt].intensity, point.GetIntensity());
-		SetUniform2f(fu.point[m_PointLightCnt].attenuation, point.GetAttenuation());
+		if (m_Lights != nullptr) m_Lights->AddPointLight(point);
+	}
 
-		SetUniform1i(fu.pointLights, ++m_PointLightCnt);
+	void EntityShader::UploadSpotLight(const SpotLight& spot)
+	{
+		if (m_Lights != nullptr) m_Lights->AddSpotLight(spot);
 	}
 
-	void EntityShader::UploadSpotLight(const kvasnric::SpotLight& spot)
+	void EntityShader::SetDepthOnly(bool depthOnly)
 	{
-		SetUniform3f(fu.spot[m_SpotLightCnt].position, spot.GetPosition());
-		SetUniform3f(fu.spot[m_SpotLightCnt].diffuse, spot.GetDiffuse());
-		SetUniform3f(fu.spot[m_SpotLightCnt].specular, spot.GetSpecular());
-		SetUniform2f(fu.spot[m_SpotLightCnt].cutOff, spot.GetCutOff());
-		SetUniform3f(fu.spot[m_SpotLightCnt].direction, spot.GetDirection());
+		m_DepthOnly = depthOnly && m_Depth != nullptr;
+		if (!m_DepthOnly) return;
 
-		SetUniform1i(fu.spotLights, ++m_SpotLightCnt);
+		m_Depth->Bind();
+		m_Depth->UploadViewInfo(m_State.View, m_State.Projection);
 	}
 
-	void EntityShader::UploadModelMatrix(const glm::mat4& model) const
+	void EntityShader::UploadSkyColor(const glm::vec3& sky)
 	{
-		SetUniformMat4(vu.Model, model);
+		m_State.SkyColor = sky;
+		++m_StateVersion;
 	}
 
-	void EntityShader::UploadMaterialProperties(const Material& material) const
+	void EntityShader::UploadLevel(float level)
 	{
-		SetUniform3f(fu.material.diffuse, material.GetDiffuse());
-		SetUniform3f(fu.material.specular, material.GetSpecular());
-		SetUniform3f(fu.material.ambient, material.GetAmbient());
-		SetUniform1f(fu.material.shininess, material.GetShininess());
+		m_State.Level = level;
+		++m_StateVersion;
+	}
 
-		SetUniform1i(fu.t_Diffuse.enabled, material.IsDiffuseTextureActive());
-		SetUniform1i(fu.t_Specular.enabled, material.IsSpecularTextureActive());
-		SetUniform1i(fu.t_Normal.enabled, material.IsNormalTextureActive());
-		SetUniform1i(fu.t_Roughness.enabled, material.IsGlossyTextureActive());
-		SetUniform1i(fu.t_Occlusion.enabled, material.IsOcclusionTextureActive());
-		SetUniform1i(fu.t_Opacity.enabled, material.IsOpacityTextureActive());
+	unsigned EntityShader::Features(const Material& material)
+	{
+		unsigned features = 0;
+
+		if (material.IsDiffuseTextureActive()) features |= DIFFUSE;
+		if (material.IsSpecularTextureActive()) features |= SPECULAR;
+		if (material.IsNormalTextureActive()) features |= NORMAL;
+		if (material.IsGlossyTextureActive()) features |= ROUGHNESS;
+		if (material.IsOcclusionTextureActive()) features |= OCCLUSION;
+		if (material.IsOpacityTextureActive()) features |= OPACITY;
+
+		return features;
 	}
 
-	void EntityShader::UploadSkyColor(const glm::vec3& sky) const
+	void EntityShader::Prefetch(unsigned features) const
 	{
-		SetUniform3f(fu.skyColor, sky);
+		for (const unsigned fog : { 0u, (unsigned) FOG })
+		{
+			if (m_Variants.find(features | fog) != m_Variants.end()) continue;
+			ProgramCache::Prefetch(AddPreamble(m_VertexSrc, features | fog), AddPreamble(m_FragSrc, features | fog));
+		}
 	}
 
+	EntityShader::Variant& EntityShader::GetVariant(unsigned features)
+	{
+		if (m_Fog) features |= FOG;
+
+		const auto it = m_Variants.find(features);
+		if (it != m_Variants.end()) return *it->second;
+
+		auto variant = std::make_unique<Variant>(AddPreamble(m_VertexSrc, features), AddPreamble(m_FragSrc, features));
+		Variant& ret = *variant;
+		m_Variants.emplace(features, std::move(variant));
+		return ret;
+	}
+
+	EntityShader::Variant& EntityShader::BindVariant(unsigned features)
+	{
+		Variant& variant = GetVariant(features);
+		variant.Bind();
+		variant.UploadSharedState(m_State, m_StateVersion);
+		return variant;
+	}
+
+	std::string EntityShader::AddPreamble(const std::string& src, unsigned features)
+	{
+		std::string defines;
+
+		if (features & DIFFUSE) defines += "#define HAS_DIFFUSE\n";
+		if (features & SPECULAR) defines += "#define HAS_SPECULAR\n";
+		if (features & NORMAL) defines += "#define HAS_NORMAL\n";
+		if (features & ROUGHNESS) defines += "#define HAS_ROUGHNESS\n";
+		if (features & OCCLUSION) defines += "#define HAS_OCCLUSION\n";
+		if (features & OPACITY) defines += "#define HAS_OPACITY\n";
+		if (features & FOG) defines += "#define FOG\n";
+
+		// #version has to stay the first line of the source
+		const auto version = src.find("#version");
+		if (version == std::string::npos) return defines + src;
+
+		const auto lineEnd = src.find('\n', version);
+		if (lineEnd == std::string::npos) return src + "\n" + defines;
+
+		std::string ret = src;
+		ret.insert(lineEnd + 1, defines);
+		return ret;
+	}
+
+	EntityShader::Variant::Variant(const std::string& vertexSrc, const std::string& fragSrc)
+		: ShaderProgram(vertexSrc, fragSrc), m_Version( 0 )
+	{
+		InitUniformLocations();
+		InitTextureSamplers();
+	}
+
+	void EntityShader::Variant::UploadSharedState(const SharedState& state, unsigned version)
+	{
+		if (m_Version == version) return;
+
+		SetUniform3f(vu.ViewPosition, state.ViewPosition);
+		SetUniformMat4(vu.View, state.View);
+		SetUniformMat4(vu.Projection, state.Projection);
+		SetUniform3f(fu.skyColor, state.SkyColor);
+		SetUniform2f(fu.tileSize, state.TileSize);
+		SetUniform2f(fu.depthSlicing, state.DepthSlicing);
+		SetUniform1f(u_Level, state.Level);
+
+		m_Version = version;
+	}
+
+	void EntityShader::Variant::UploadModelMatrix(const glm::mat4& model) const
+	{
+		SetUniformMat4(vu.Model, model);
+	}
+
+	void EntityShader::Variant::UploadMaterialProperties(const Material& material) const
+	{
+		SetUniform3f(fu.material.diffuse, material.GetDiffuse());
+		SetUniform3f(fu.material.specular, material.GetSpecular());
+		SetUniform3f(fu.material.ambient, material.GetAmbient());
+		SetUniform1f(fu.material.shininess, material.GetShininess());
+	}
 	
-	void EntityShader::InitUniformLocations()
+	void EntityShader::Variant::InitUniformLocations()
 	{
 		AssignLocation(vu.View);
 		AssignLocation(vu.Projection);
@@ -139,89 +300,38 @@ namespace kvasnric
 
 		AssignLocation(vu.ViewPosition);
 
-		AssignLocation(vu.Fog);
-		SetUniform1i(vu.Fog, m_Fog);
-		
-		InitLights();
-
 		AssignLocation(fu.material.diffuse);
 		AssignLocation(fu.material.specular);
 		AssignLocation(fu.material.ambient);
 		AssignLocation(fu.material.shininess);
 
+		// samplers of features not compiled in are optimized out and get location -1
 		AssignLocation(fu.t_Diffuse.source);
-		AssignLocation(fu.t_Diffuse.enabled);
-
 		AssignLocation(fu.t_Specular.source);
-		AssignLocation(fu.t_Specular.enabled);
-
 		AssignLocation(fu.t_Normal.source);
-		AssignLocation(fu.t_Normal.enabled);
-
 		AssignLocation(fu.t_Roughness.source);
-		AssignLocation(fu.t_Roughness.enabled);
-
 		AssignLocation(fu.t_Occlusion.source);
-		AssignLocation(fu.t_Occlusion.enabled);
-
 		AssignLocation(fu.t_Opacity.source);
-		AssignLocation(fu.t_Opacity.enabled);
 		
 		AssignLocation(fu.cubeMap);
 		AssignLocation(fu.skyColor);
-	}
 
-	void EntityShader::InitLights()
-	{
-		AssignLocation(fu.pointLights);
-		AssignLocation(fu.spotLights);
+		AssignLocation(fu.tileSize);
+		AssignLocation(fu.depthSlicing);
 
-		for (int i = 0; i < LIGHT_SOURCES; ++i)
-		{
-			std::string name = "fu.point[" + std::to_string(i) + "]";
-			fu.point[i].position = GetUniformLocation((name + ".position").c_str());
-			fu.point[i].diffuse = GetUniformLocation((name + ".diffuse").c_str());
-			fu.point[i].specular = GetUniformLocation((name + ".specular").c_str());
-			fu.point[i].ambient = GetUniformLocation((name + ".ambient").c_str());
-			fu.point[i].intensity = GetUniformLocation((name + ".intensity").c_str());
-			fu.point[i].attenuation = GetUniformLocation((name + ".attenuation").c_str());
-		}
-
-		for (int i = 0; i < LIGHT_SOURCES; ++i)
-		{
-			std::string name = "fu.spot[" + std::to_string(i) + "]";
-			fu.spot[i].position = GetUniformLocation((name + ".position").c_str());
-			fu.spot[i].diffuse = GetUniformLocation((name + ".diffuse").c_str());
-			fu.spot[i].specular = GetUniformLocation((name + ".specular").c_str());
-			fu.spot[i].direction = GetUniformLocation((name + ".direction").c_str());
-			fu.spot[i].cutOff = GetUniformLocation((name + ".cutOff").c_str());
-		}
-
-		SetUniform1i(fu.pointLights, 0);
-		SetUniform1i(fu.spotLights, 0);
+		// only the geometry buffer variant writes the portal level
+		AssignLocation(u_Level);
 	}
 
-	void EntityShader::InitTextureSamplers() const
+	void EntityShader::Variant::InitTextureSamplers() const
 	{
 		// assign each texture type its texture slot
-		
 		SetUniform1i(fu.t_Diffuse.source, Texture2D::DIFFUSE);
-		SetUniform1i(fu.t_Diffuse.enabled, false);
-		
 		SetUniform1i(fu.t_Specular.source, Texture2D::SPECULAR);
-		SetUniform1i(fu.t_Specular.enabled, false);
-
 		SetUniform1i(fu.t_Normal.source, Texture2D::NORMAL);
-		SetUniform1i(fu.t_Normal.enabled, false);
-
 		SetUniform1i(fu.t_Roughness.source, Texture2D::ROUGHNESS);
-		SetUniform1i(fu.t_Roughness.enabled, false);
-
 		SetUniform1i(fu.t_Occlusion.source, Texture2D::OCCLUSION);
-		SetUniform1i(fu.t_Occlusion.enabled, false);
-
 		SetUniform1i(fu.t_Opacity.source, Texture2D::OPACITY);
-		SetUniform1i(fu.t_Opacity.enabled, false);
 		
 		SetUniform1i(fu.cubeMap, Texture2D::CUBEMAP);
 	}
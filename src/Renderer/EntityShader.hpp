@@ -2,105 +2,176 @@
 /**
  * \file       EntityShader.hpp
  * \author     Richard Kvasnica
- * \brief      Child class entity shader declaration
+ * \brief      Entity shader declaration
+ *
+ * Entity shader is a set of shader program variants compiled from the same sources.
+ * Every variant has only the material features it needs defined in the preamble.
 */
 //----------------------------------------------------------------------------------------
 
 #pragma once
 
 #include "ShaderProgram.hpp"
+#include "CommandList.hpp"
+#include "LightClusters.hpp"
+#include "DepthShader.hpp"
 
 #include <Scene/PortalWalls.hpp>
-#include <Scene/GameObject.hpp>
+#include <Scene/EntityStore.hpp>
 #include <Scene/Light.hpp>
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 namespace kvasnric
 {
-	// Child class of a Shader Program class. Expands functionality to basic entity shading.
-	class EntityShader final : public ShaderProgram
+	// Shades entities by shader program variants chosen from the material of each mesh.
+	class EntityShader final
 	{
 	public:
+		// features compiled into a variant. Fog is a feature of the whole scene
+		enum FEATURE : unsigned
+		{
+			DIFFUSE = 1 << 0,
+			SPECULAR = 1 << 1,
+			NORMAL = 1 << 2,
+			ROUGHNESS = 1 << 3,
+			OCCLUSION = 1 << 4,
+			OPACITY = 1 << 5,
+			FOG = 1 << 6
+		};
+
+		// one mesh waiting in the queue
+		struct DrawItem
+		{
+			unsigned Features;
+			const Mesh* Instance;
+			glm::mat4 Model;
+		};
+
+		// meshes of one view sorted by their variant, can be prepared on any thread
+		using DrawList = std::vector<DrawItem>;
+
 		/**
-		 * Constructs a new entity shader program by compiling two inputting source strings
+		 * Constructs a new entity shader. Variants are compiled when they are rendered for the first time.
 		 * @param vertexSrc glsl source code string of vertex shader
 		 * @param fragSrc glsl source code string of fragment shader
 		 */
 		EntityShader(const std::string& vertexSrc, const std::string& fragSrc);
-		~EntityShader() override = default;
+		~EntityShader() = default;
 
-		/**
-		 * Renders GameObject instance
-		 * @param obj const reference to a GameObject instance
-		 */
-		void RenderGameObject(const GameObject& obj) const;
+		// deletes possible copy/move constructors
+		EntityShader(const EntityShader&) = delete;
+		EntityShader(EntityShader&&) = delete;
+		EntityShader& operator=(const EntityShader&) = delete;
+		EntityShader& operator=(EntityShader&&) = delete;
 
 		/**
-		 * Renders GameObject instance with additional transformation
-		 * @param obj const reference to a GameObject instance
-		 * @param transform mat4 that applies additional transformation to a model matrix
+		 * Renders transparent Model instance, back faces first and then front faces
+		 * @param m const reference to a Model instance
+		 * @param model model matrix of the instance
 		 */
-		void RenderGameObject(const GameObject& obj, const glm::mat4& transform) const;
+		void RenderTransparentModel(const Model& m, const glm::mat4& model);
 
 		/**
-		 * Renders transparent GameObject instance
-		 * @param obj const reference to a GameObject instance
+		 * Renders one entity of the store
+		 * @param store entities
+		 * @param entity handle of a living entity
 		 */
-		void RenderTransparentGameObject(const GameObject& obj) const;
-		
+		void RenderEntity(const EntityStore& store, Entity entity);
+
 		/**
-		 * Renders Model instance
-		 * @param m const reference to a Model instance
+		 * Renders one transparent entity of the store
+		 * @param store entities
+		 * @param entity handle of a living entity
 		 */
-		void RenderModel(const Model& m) const;
+		void RenderTransparentEntity(const EntityStore& store, Entity entity);
 
 		/**
-		 * Renders Mesh instance
-		 * @param m const reference to a Mesh instance
+		 * Renders Model instance, meshes are grouped by their variant
+		 * @param m const reference to a Model instance
+		 * @param model model matrix of the instance
 		 */
-		void RenderMesh(const Mesh& m) const;
+		void RenderModel(const Model& m, const glm::mat4& model);
 
 		/**
 		 * Renders Hardcoded Portal Walls instance
 		 * @param pw const reference to a Hardcoded Portal Walls instance
 		 * @param model nothing should be done unless special case
 		 */
-		void RenderPortalWalls(const PortalWalls& pw, const glm::mat4& model = UNIT_MATRIX) const;
-		
+		void RenderPortalWalls(const PortalWalls& pw, const glm::mat4& model = UNIT_MATRIX);
+
 		/**
-		 * Uploads to shader info about camera view
+		 * Fills the list with meshes of the entities sorted by their variant and then by the mesh. Touches no OpenGL state,
+		 * so lists of different views can be prepared by other threads while nothing changes the store.
+		 * @param list output list, its previous content is dropped
+		 * @param store entities
+		 * @param visible indices of the entities, like the ones found by EntityStore::Cull
+		 */
+		static void Prepare(DrawList& list, const EntityStore& store, const std::vector<uint32_t>& visible);
+
+		/**
+		 * Records the prepared meshes as commands, without any OpenGL call
+		 * @param commands output list, its previous content is dropped
+		 * @param list meshes sorted by Prepare
+		 */
+		static void Record(CommandList& commands, const DrawList& list);
+
+		/**
+		 * Replays recorded commands with the current view. Depth only rendering replays only the draws.
+		 * @param commands list whose meshes are still alive
+		 */
+		void Replay(const CommandList& commands);
+
+		/**
+		 * Uploads to shader info about camera view. Assigns lights to the clusters of this view.
 		 * @param pos position of the view
 		 * @param view 4x4 transformation matrix from world coordinate system to camera
 		 * @param projection 4x4 transformation matrix from camera coordinate system to projection
+		 * @param slot view slot the light lists are kept for, the lists of the slot are reused within the frame
 		 */
-		void UploadViewInfo(const glm::vec3& pos, const glm::mat4& view, const glm::mat4& projection) const;
+		void UploadViewInfo(const glm::vec3& pos, const glm::mat4& view, const glm::mat4& projection, unsigned slot = 0);
 
 		/**
-		 * Uploads one point light into shader. Can be used max LIGHT_SOURCE times. Through uniforms.
+		 * Adds one point light into the light clusters. Number of lights is not limited.
 		 */
 		void UploadPointLight(const PointLight& point);
 
 		/**
-		 * Uploads one spot light into shader. Can be use max LIGHT_SOURCE times. Through uniforms.
+		 * Adds one spot light into the light clusters. Number of lights is not limited.
 		 */
 		void UploadSpotLight(const SpotLight& spot);
 
 		/**
-		 * Uploads model matrix into the shader through uniforms.
+		 * Sets lights shaded by this shader. Shader without lights uses only the sun.
+		 * @param lights light storage, has to outlive the shader
 		 */
-		void UploadModelMatrix(const glm::mat4& model) const;
+		inline void SetLightClusters(LightClusters* lights) { m_Lights = lights; }
 
 		/**
-		 * Uploads material properties into shader. Through uniforms.
+		 * Sets shader used by the depth pre-pass
+		 * @param depth position only shader, has to outlive the shader
 		 */
-		void UploadMaterialProperties(const Material& material) const;
+		inline void SetDepthShader(const DepthShader* depth) { m_Depth = depth; }
+
+		/**
+		 * While enabled, meshes are rendered only into the depth buffer by the depth shader with the current view
+		 */
+		void SetDepthOnly(bool depthOnly);
 
 		/**
 		 * Uploads color of a sky
 		 */
-		void UploadSkyColor(const glm::vec3 & sky) const;
-		
+		void UploadSkyColor(const glm::vec3& sky);
+
+		/**
+		 * Uploads index of the portal iteration used by the geometry buffer
+		 */
+		void UploadLevel(float level);
+
 		/**
-		 * Toggles fog and sends a bool to a shader whether it should be rendered.
+		 * Toggles fog. Fog is compiled into the variants.
 		 */
 		void ToggleFog();
 
@@ -108,97 +179,163 @@ namespace kvasnric
 		 * Returns whether the fog is enabled
 		 */
 		inline bool IsFogEnabled() const { return m_Fog; }
-	private:
 
 		/**
-		 * Accesses every uniform in entity shader and assigns its location. Used with init lights.
+		 * Returns number of variants compiled so far
 		 */
-		void InitUniformLocations();
+		inline unsigned VariantCount() const { return (unsigned) m_Variants.size(); }
 
 		/**
-		 * Accesses every light uniform in entity shader and assigns its location.
+		 * Starts compiling the variant with and without fog, so rendering it for the first time does not wait
+		 * for the whole compilation
+		 * @param features features of a material, fog not included
 		 */
-		void InitLights();
+		void Prefetch(unsigned features) const;
 
 		/**
-		 * Sends to shaders texture samplers texture slot of each texture type.
+		 * @returns features of the material, fog not included
 		 */
-		void InitTextureSamplers() const;
-		
-		short m_PointLightCnt;
-		short m_SpotLightCnt;
-		bool m_Fog;
-
-		static const int LIGHT_SOURCES = 10;
-
-		// every struct is the same as the entity shader uniforms
-
-		// struct holding material properties
-		struct MaterialLocation
+		static unsigned Features(const Material& material);
+	private:
+		// state shared by all variants. Variant uploads it when it is bound after the state changed
+		struct SharedState
 		{
-			int ambient;
-			int diffuse;
-			int specular;
-			int shininess;
+			glm::vec3 ViewPosition;
+			glm::mat4 View;
+			glm::mat4 Projection;
+			glm::vec3 SkyColor;
+			glm::vec2 TileSize;
+			glm::vec2 DepthSlicing;
+			float Level;
 		};
 
-		// struct holding point light properties
-		struct PointLight
+		// One compiled permutation of the entity shader
+		class Variant final : public ShaderProgram
 		{
-			int position;
-			int diffuse;
-			int specular;
-			int ambient;
-			int intensity;
-			int attenuation;
-		};
+		public:
+			Variant(const std::string& vertexSrc, const std::string& fragSrc);
+			~Variant() override = default;
 
-		// struct holding spot light properties
-		struct SpotLight
-		{
-			int position;
-			int direction;
-			int diffuse;
-			int specular;
-			int cutOff;
-		};
+			/**
+			 * Uploads shared state if it changed since the last upload
+			 * @param version version of the shared state
+			 */
+			void UploadSharedState(const SharedState& state, unsigned version);
 
-		// struct holding texture binded slot and bool whether texture should be used.
-		struct TextureLocation
-		{
-			int source;
-			int enabled;
-		};
+			/**
+			 * Uploads model matrix into the shader through uniforms.
+			 */
+			void UploadModelMatrix(const glm::mat4& model) const;
 
-		// struct holding all fragment shader uniforms
-		struct FragUniforms
-		{
-			MaterialLocation material;
-			TextureLocation t_Diffuse;
-			TextureLocation t_Specular;
-			TextureLocation t_Normal;
-			TextureLocation t_Roughness;
-			TextureLocation t_Occlusion;
-			TextureLocation t_Opacity;
-			PointLight point[LIGHT_SOURCES];
-			SpotLight spot[LIGHT_SOURCES];
-			int pointLights;
-			int spotLights;
-			int cubeMap;
-			int skyColor;
-		};
+			/**
+			 * Uploads material properties into shader. Through uniforms.
+			 */
+			void UploadMaterialProperties(const Material& material) const;
 
-		// struct holding all vertex shader uniforms
-		struct VertUniforms
-		{
-			int ViewPosition;
-			int Projection;
-			int View;
-			int Model;
-			int Fog;
+			using ShaderProgram::RenderElements;
+			using ShaderProgram::RenderBackFace;
+			using ShaderProgram::RenderFrontFace;
+			using ShaderProgram::EnableBlending;
+			using ShaderProgram::DisableBlending;
+		private:
+			/**
+			 * Accesses every uniform in entity shader and assigns its location.
+			 */
+			void InitUniformLocations();
+
+			/**
+			 * Sends to shaders texture samplers texture slot of each texture type.
+			 */
+			void InitTextureSamplers() const;
+
+			unsigned m_Version;
+
+			// every struct is the same as the entity shader uniforms
+
+			// struct holding material properties
+			struct MaterialLocation
+			{
+				int ambient;
+				int diffuse;
+				int specular;
+				int shininess;
+			};
+
+			// struct holding texture binded slot
+			struct TextureLocation
+			{
+				int source;
+			};
+
+			// struct holding all fragment shader uniforms
+			struct FragUniforms
+			{
+				MaterialLocation material;
+				TextureLocation t_Diffuse;
+				TextureLocation t_Specular;
+				TextureLocation t_Normal;
+				TextureLocation t_Roughness;
+				TextureLocation t_Occlusion;
+				TextureLocation t_Opacity;
+				int cubeMap;
+				int skyColor;
+				int tileSize;
+				int depthSlicing;
+			};
+
+			// struct holding all vertex shader uniforms
+			struct VertUniforms
+			{
+				int ViewPosition;
+				int Projection;
+				int View;
+				int Model;
+			};
+
+			FragUniforms fu;
+			VertUniforms vu;
+			int u_Level;
 		};
-		
-		FragUniforms fu;
-		VertUniforms vu;
+
+		/**
+		 * Returns variant of the features, compiles it when it is used for the first time
+		 */
+		Variant& GetVariant(unsigned features);
+
+		/**
+		 * Binds variant and brings its shared state up to date
+		 */
+		Variant& BindVariant(unsigned features);
+
+		/**
+		 * Inserts #define of every feature after the #version line
+		 */
+		static std::string AddPreamble(const std::string& src, unsigned features);
+
+		/**
+		 * Sorts the meshes by their variant and then by the mesh
+		 */
+		static void Sort(DrawList& list);
+
+		/**
+		 * Fills m_Draws with the meshes of the model in their order
+		 */
+		void Collect(const Model& m, const glm::mat4& model);
+
+		std::string m_VertexSrc;
+		std::string m_FragSrc;
+		std::unordered_map<unsigned, std::unique_ptr<Variant>> m_Variants;
+
+		SharedState m_State;
+		unsigned m_StateVersion;
+
+		// lists of the model rendered right away, kept so that rendering a model does not allocate
+		DrawList m_Draws;
+		CommandList m_Commands;
+
+		LightClusters* m_Lights;
+		const DepthShader* m_Depth;
+		bool m_DepthOnly;
+		bool m_Fog;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,93 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       FrameBuffer.cpp
+ * \author     Richard Kvasnica
+ * \brief      Framebuffer class definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "FrameBuffer.hpp"
+#include "RenderStats.hpp"
+
+#include <gl_core_4_4.h>
+#include <stdexcept>
+
+namespace kvasnric
+{
+	unsigned FrameBuffer::s_Screen = 0;
+
+	FrameBuffer::FrameBuffer(int width, int height)
+		: m_ID(0), m_Color(0), m_DepthStencil(0), m_Width(width), m_Height(height)
+	{
+		glGenFramebuffers(1, &m_ID);
+		glGenTextures(1, &m_Color);
+		glGenRenderbuffers(1, &m_DepthStencil);
+
+		Allocate();
+	}
+
+	FrameBuffer::~FrameBuffer()
+	{
+		glDeleteRenderbuffers(1, &m_DepthStencil);
+		glDeleteTextures(1, &m_Color);
+		glDeleteFramebuffers(1, &m_ID);
+	}
+
+	void FrameBuffer::Bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glViewport(0, 0, m_Width, m_Height);
+	}
+
+	void FrameBuffer::Unbind()
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, s_Screen);
+	}
+
+	void FrameBuffer::SetScreen(const FrameBuffer* target)
+	{
+		s_Screen = target ? target->m_ID : 0;
+		Unbind();
+	}
+
+	void FrameBuffer::BindColor(unsigned slot) const
+	{
+		glActiveTexture(GL_TEXTURE0 + slot);
+		glBindTexture(GL_TEXTURE_2D, m_Color);
+		RenderStats::Count(RenderStats::TEXTURE_BINDS);
+	}
+
+	void FrameBuffer::Resize(int width, int height)
+	{
+		if (width == m_Width && height == m_Height) return;
+
+		m_Width = width;
+		m_Height = height;
+		Allocate();
+	}
+
+	void FrameBuffer::Allocate()
+	{
+		// color attachment is sampled in screen space so no mipmaps are needed
+		glBindTexture(GL_TEXTURE_2D, m_Color);
+		// portal view is written and sampled as sRGB like the screen, so it keeps the dark tones
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindRenderbuffer(GL_RENDERBUFFER, m_DepthStencil);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_Width, m_Height);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Color, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthStencil);
+
+		const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		Unbind();
+
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+			throw std::runtime_error("Framebuffer is not complete.");
+	}
+}
@@ -0,0 +1,78 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       FrameBuffer.hpp
+ * \author     Richard Kvasnica
+ * \brief      Framebuffer class declaration
+ *
+ * Class wrapping the functionality of OpenGL framebuffer object with one color texture
+ * and one depth stencil renderbuffer.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace kvasnric
+{
+	// Offscreen render target with color texture and depth stencil attachment
+	class FrameBuffer
+	{
+	public:
+		/**
+		 * Creates framebuffer object and allocates its attachments
+		 * @param width width of the attachments in pixels
+		 * @param height height of the attachments in pixels
+		 */
+		FrameBuffer(int width, int height);
+		~FrameBuffer();
+
+		// deletes possible copy/move constructors
+		FrameBuffer(const FrameBuffer&) = delete;
+		FrameBuffer(FrameBuffer&&) = delete;
+		FrameBuffer& operator=(const FrameBuffer&) = delete;
+		FrameBuffer& operator=(FrameBuffer&&) = delete;
+
+		/**
+		 * Binds framebuffer as a render target and sets the viewport to its size
+		 */
+		void Bind() const;
+
+		/**
+		 * Binds the screen framebuffer back
+		 */
+		static void Unbind();
+
+		/**
+		 * Redirects everything rendered to the screen into the target. A hidden window owns no pixels,
+		 * so headless rendering needs a framebuffer of its own.
+		 * @param target framebuffer used instead of the window, nullptr renders into the window again
+		 */
+		static void SetScreen(const FrameBuffer* target);
+
+		/**
+		 * Binds color attachment as a texture
+		 * @param slot texture unit the color attachment is bound to
+		 */
+		void BindColor(unsigned slot) const;
+
+		/**
+		 * Reallocates attachments when the window size changes
+		 */
+		void Resize(int width, int height);
+
+		inline int Width() const { return m_Width; }
+		inline int Height() const { return m_Height; }
+	private:
+		/**
+		 * Allocates attachments and checks completeness of the framebuffer
+		 */
+		void Allocate();
+
+		unsigned m_ID;
+		unsigned m_Color;
+		unsigned m_DepthStencil;
+		int m_Width;
+		int m_Height;
+
+		static unsigned s_Screen;
+	};
+}
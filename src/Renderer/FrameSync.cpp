@@ -0,0 +1,120 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       FrameSync.cpp
+ * \author     Richard Kvasnica
+ * \brief      Static frame pacing class definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "FrameSync.hpp"
+
+#include "gl_core_4_4.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace kvasnric
+{
+	void* FrameSync::s_Fences[FRAMES_IN_FLIGHT] = {};
+	std::chrono::steady_clock::time_point FrameSync::s_Starts[FRAMES_IN_FLIGHT];
+	uint64_t FrameSync::s_Frame = 0;
+	bool FrameSync::s_Begun = false;
+	std::vector<float> FrameSync::s_Latency;
+	std::vector<float> FrameSync::s_Wait;
+	unsigned FrameSync::s_LatencyNext = 0;
+	unsigned FrameSync::s_WaitNext = 0;
+
+	// one second, a longer wait is repeated
+	static const uint64_t WAIT_TIMEOUT_NS = 1000000000ull;
+
+	/**
+	 * Stores the value into the ring buffer of the last PROFILER_HISTORY values
+	 */
+	static void Record(std::vector<float>& history, unsigned& next, float value)
+	{
+		if (history.size() < PROFILER_HISTORY) history.push_back(value);
+		else history[next] = value;
+		next = (next + 1) % PROFILER_HISTORY;
+	}
+
+	void FrameSync::BeginFrame()
+	{
+		if (s_Begun) return;
+		s_Begun = true;
+
+		const auto start = std::chrono::steady_clock::now();
+		while (!Retire(Slot(), WAIT_TIMEOUT_NS)) {}
+		Record(s_Wait, s_WaitNext, MillisecondsSince(start));
+
+		// latency of the frame is counted from here, right before its input is read
+		s_Starts[Slot()] = std::chrono::steady_clock::now();
+	}
+
+	void FrameSync::EndFrame()
+	{
+		// a frame rendered without BeginFrame must not drop the fence of its slot either
+		BeginFrame();
+
+		s_Fences[Slot()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		++s_Frame;
+		s_Begun = false;
+
+		// the oldest frame in flight may be done already, noticing it now measures its latency closer to the truth
+		Retire(Slot(), 0);
+	}
+
+	void FrameSync::Flush()
+	{
+		for (unsigned slot = 0; slot < FRAMES_IN_FLIGHT; ++slot)
+		{
+			while (!Retire(slot, WAIT_TIMEOUT_NS)) {}
+		}
+	}
+
+	bool FrameSync::Retire(unsigned slot, uint64_t timeoutNs)
+	{
+		if (s_Fences[slot] == nullptr) return true;
+
+		// flushing makes sure the fence reaches the GPU, the wait could never end otherwise
+		const GLsync fence = (GLsync) s_Fences[slot];
+		if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNs) == GL_TIMEOUT_EXPIRED) return false;
+
+		Record(s_Latency, s_LatencyNext, MillisecondsSince(s_Starts[slot]));
+		glDeleteSync(fence);
+		s_Fences[slot] = nullptr;
+		return true;
+	}
+
+	FrameSync::Statistics FrameSync::GetStatistics()
+	{
+		Statistics stats = { 0.0f, 0.0f, 0.0f };
+		if (!s_Latency.empty())
+		{
+			std::vector<float> sorted(s_Latency);
+			const size_t n = std::min(sorted.size() - 1, (size_t) (0.99f * sorted.size()));
+			std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+
+			for (const float latency : s_Latency) stats.LatencyAverage += latency;
+			stats.LatencyAverage /= s_Latency.size();
+			stats.LatencyP99 = sorted[n];
+		}
+
+		for (const float wait : s_Wait) stats.WaitAverage += wait;
+		if (!s_Wait.empty()) stats.WaitAverage /= s_Wait.size();
+		return stats;
+	}
+
+	void FrameSync::Print(std::ostream& os)
+	{
+		const auto stats = GetStatistics();
+		char line[128];
+		std::snprintf(line, sizeof(line), "Frame latency %.2f ms avg, %.2f ms p99, %u frames in flight, %.2f ms waited for the GPU per frame",
+			stats.LatencyAverage, stats.LatencyP99, FRAMES_IN_FLIGHT, stats.WaitAverage);
+		os << line << std::endl;
+	}
+
+	float FrameSync::MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
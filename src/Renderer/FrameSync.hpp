@@ -0,0 +1,90 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       FrameSync.hpp
+ * \author     Richard Kvasnica
+ * \brief      Static frame pacing class declaration
+ *
+ * Lets the CPU prepare the next frame while the GPU still renders the previous ones, at most
+ * FRAMES_IN_FLIGHT of them. Every frame is fenced, the fence of the frame rendered FRAMES_IN_FLIGHT frames
+ * ago is waited for before a new frame starts, so its streamed resources can be written again.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <constants.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace kvasnric
+{
+	// Static class pacing the frames by fences and measuring the latency from the start of a frame to its end on the GPU
+	class FrameSync
+	{
+	public:
+		// rolling statistics of the last PROFILER_HISTORY finished frames in milliseconds
+		struct Statistics
+		{
+			float LatencyAverage;
+			float LatencyP99;
+			float WaitAverage;
+		};
+
+		/**
+		 * Waits until the GPU finished the frame which used the slot of this one, has to be called before the input
+		 * of the frame is read so the latency stays bounded. Does nothing when the frame already began.
+		 */
+		static void BeginFrame();
+
+		/**
+		 * Fences every command of the frame, called after the buffers are swapped
+		 */
+		static void EndFrame();
+
+		/**
+		 * @returns number of the current frame, buffers written in it can be written again FRAMES_IN_FLIGHT frames later
+		 */
+		inline static uint64_t Frame() { return s_Frame; }
+
+		/**
+		 * @returns slot of the per-frame resources used by the current frame
+		 */
+		inline static unsigned Slot() { return (unsigned) (s_Frame % FRAMES_IN_FLIGHT); }
+
+		/**
+		 * Waits for every frame in flight, e.g. before a resource the GPU may still read is deleted
+		 */
+		static void Flush();
+
+		static Statistics GetStatistics();
+
+		/**
+		 * Prints the statistics in one line
+		 */
+		static void Print(std::ostream& os);
+	private:
+		/**
+		 * Waits for the fence of the slot up to the timeout and records the latency of its frame once it is signaled
+		 * @returns whether the slot is free
+		 */
+		static bool Retire(unsigned slot, uint64_t timeoutNs);
+
+		static float MillisecondsSince(std::chrono::steady_clock::time_point start);
+
+		// GLsync handles, kept untyped so the header does not need opengl
+		static void* s_Fences[FRAMES_IN_FLIGHT];
+		static std::chrono::steady_clock::time_point s_Starts[FRAMES_IN_FLIGHT];
+
+		static uint64_t s_Frame;
+		static bool s_Begun;
+
+		// ring buffers of the last PROFILER_HISTORY frames
+		static std::vector<float> s_Latency;
+		static std::vector<float> s_Wait;
+		static unsigned s_LatencyNext;
+		static unsigned s_WaitNext;
+	};
+}
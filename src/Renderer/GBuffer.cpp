@@ -0,0 +1,145 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       GBuffer.cpp
+ * \author     Richard Kvasnica
+ * \brief      Geometry buffer class definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "GBuffer.hpp"
+#include "FrameBuffer.hpp"
+#include "RenderStats.hpp"
+
+#include <gl_core_4_4.h>
+#include <stdexcept>
+
+namespace kvasnric
+{
+	GBuffer::GBuffer(int width, int height)
+		: m_ID(0), m_Targets{}, m_DepthStencil(0), m_Width(width), m_Height(height)
+	{
+		glGenFramebuffers(1, &m_ID);
+		glGenTextures(COUNT, m_Targets);
+		glGenRenderbuffers(1, &m_DepthStencil);
+
+		Allocate();
+	}
+
+	GBuffer::~GBuffer()
+	{
+		glDeleteRenderbuffers(1, &m_DepthStencil);
+		glDeleteTextures(COUNT, m_Targets);
+		glDeleteFramebuffers(1, &m_ID);
+	}
+
+	void GBuffer::Bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glViewport(0, 0, m_Width, m_Height);
+	}
+
+	void GBuffer::Unbind()
+	{
+		FrameBuffer::Unbind();
+	}
+
+	void GBuffer::Clear() const
+	{
+		const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float background[4];
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, background);
+
+		// draw buffer indices refer to the currently routed targets
+		BindLightTarget();
+		glClearBufferfv(GL_COLOR, 0, background);
+
+		BindGeometryTargets();
+		for (int i = 0; i < LIGHT; ++i)
+		{
+			glClearBufferfv(GL_COLOR, i, zero);
+		}
+		glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+	}
+
+	void GBuffer::BindGeometryTargets() const
+	{
+		const GLenum buffers[LIGHT] = {
+			GL_COLOR_ATTACHMENT0 + POSITION,
+			GL_COLOR_ATTACHMENT0 + NORMAL,
+			GL_COLOR_ATTACHMENT0 + ALBEDO,
+			GL_COLOR_ATTACHMENT0 + SPECULAR,
+			GL_COLOR_ATTACHMENT0 + AMBIENT,
+			GL_COLOR_ATTACHMENT0 + VIEW
+		};
+		glDrawBuffers(LIGHT, buffers);
+	}
+
+	void GBuffer::BindLightTarget() const
+	{
+		const GLenum buffer = GL_COLOR_ATTACHMENT0 + LIGHT;
+		glDrawBuffers(1, &buffer);
+	}
+
+	void GBuffer::BindGeometryTextures() const
+	{
+		for (int i = 0; i < LIGHT; ++i)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, m_Targets[i]);
+		}
+		RenderStats::Count(RenderStats::TEXTURE_BINDS, LIGHT);
+	}
+
+	void GBuffer::BindLightTexture(unsigned slot) const
+	{
+		glActiveTexture(GL_TEXTURE0 + slot);
+		glBindTexture(GL_TEXTURE_2D, m_Targets[LIGHT]);
+		RenderStats::Count(RenderStats::TEXTURE_BINDS);
+	}
+
+	void GBuffer::Resize(int width, int height)
+	{
+		if (width == m_Width && height == m_Height) return;
+
+		m_Width = width;
+		m_Height = height;
+		Allocate();
+	}
+
+	void GBuffer::Allocate()
+	{
+		// positions need the float precision, colors fit into bytes when they are stored in sRGB
+		const GLenum formats[COUNT] = {
+			GL_RGBA16F,
+			GL_RGBA16F,
+			GL_SRGB8_ALPHA8,
+			GL_RGBA16F,
+			GL_SRGB8_ALPHA8,
+			GL_RGBA16F,
+			GL_RGBA16F
+		};
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+
+		for (int i = 0; i < COUNT; ++i)
+		{
+			glBindTexture(GL_TEXTURE_2D, m_Targets[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, formats[i], m_Width, m_Height, 0, GL_RGBA, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_Targets[i], 0);
+		}
+
+		glBindRenderbuffer(GL_RENDERBUFFER, m_DepthStencil);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_Width, m_Height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthStencil);
+
+		const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		Unbind();
+
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+			throw std::runtime_error("Geometry buffer is not complete.");
+	}
+}
@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       GBuffer.hpp
+ * \author     Richard Kvasnica
+ * \brief      Geometry buffer class declaration
+ *
+ * Framebuffer holding surface attributes of every visible pixel for deferred shading
+ * together with the light accumulation target.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace kvasnric
+{
+	// Framebuffer with multiple render targets used by the deferred renderer
+	class GBuffer
+	{
+	public:
+		// color attachments. Geometry targets are bound to texture slots of the same number
+		enum TARGET
+		{
+			POSITION = 0,	// world position, fog visibility
+			NORMAL = 1,		// world normal, shininess
+			ALBEDO = 2,		// diffuse color, ambient occlusion
+			SPECULAR = 3,	// specular color
+			AMBIENT = 4,	// ambient color
+			VIEW = 5,		// direction to the camera, view level
+			LIGHT = 6,		// accumulated light
+			COUNT = 7
+		};
+
+		/**
+		 * Creates framebuffer object and allocates all attachments
+		 * @param width width of the attachments in pixels
+		 * @param height height of the attachments in pixels
+		 */
+		GBuffer(int width, int height);
+		~GBuffer();
+
+		// deletes possible copy/move constructors
+		GBuffer(const GBuffer&) = delete;
+		GBuffer(GBuffer&&) = delete;
+		GBuffer& operator=(const GBuffer&) = delete;
+		GBuffer& operator=(GBuffer&&) = delete;
+
+		/**
+		 * Binds the framebuffer and sets the viewport to its size
+		 */
+		void Bind() const;
+
+		/**
+		 * Binds the screen framebuffer back
+		 */
+		static void Unbind();
+
+		/**
+		 * Clears geometry targets to zero and the light target to the current clear color.
+		 * Leaves the geometry targets routed for drawing.
+		 */
+		void Clear() const;
+
+		/**
+		 * Routes fragment outputs into the geometry targets
+		 */
+		void BindGeometryTargets() const;
+
+		/**
+		 * Routes fragment output 0 into the light accumulation target
+		 */
+		void BindLightTarget() const;
+
+		/**
+		 * Binds geometry targets as textures into the slots of the same number
+		 */
+		void BindGeometryTextures() const;
+
+		/**
+		 * Binds light accumulation target as a texture
+		 * @param slot texture unit
+		 */
+		void BindLightTexture(unsigned slot) const;
+
+		/**
+		 * Reallocates attachments when the window size changes
+		 */
+		void Resize(int width, int height);
+
+		inline int Width() const { return m_Width; }
+		inline int Height() const { return m_Height; }
+	private:
+		/**
+		 * Allocates attachments and checks completeness of the framebuffer
+		 */
+		void Allocate();
+
+		unsigned m_ID;
+		unsigned m_Targets[COUNT];
+		unsigned m_DepthStencil;
+		int m_Width;
+		int m_Height;
+	};
+}
@@ -0,0 +1,247 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       GpuProfiler.cpp
+ * \author     Richard Kvasnica
+ * \brief      GPU profiler class definition
+ *
+ * Measures GPU and CPU time of named parts of the frame with timer queries.
+*/
+//----------------------------------------------------------------------------------------
+
+#include "GpuProfiler.hpp"
+
+#include <constants.hpp>
+#include <gl_core_4_4.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace kvasnric
+{
+	GpuProfiler::GpuProfiler()
+		: m_Current(0), m_Next(0), m_Collected(0), m_Dropped(0), m_Wait(false), m_Recording(false)
+		, m_Open(NONE), m_CsvFrame(0)
+	{
+		for (auto& frame : m_Frames)
+		{
+			glGenQueries(2, frame.Timestamps);
+			frame.Cpu = 0.0f;
+			frame.Issued = false;
+		}
+
+		AddSection("frame");
+	}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		for (auto& frame : m_Frames)
+		{
+			glDeleteQueries(2, frame.Timestamps);
+			if (!frame.Queries.empty()) glDeleteQueries((GLsizei) frame.Queries.size(), frame.Queries.data());
+		}
+	}
+
+	unsigned GpuProfiler::AddSection(const std::string& name)
+	{
+		m_Sections.push_back({ name, std::vector<float>(PROFILER_HISTORY, 0.0f), std::vector<float>(PROFILER_HISTORY, 0.0f) });
+		return (unsigned) m_Sections.size() - 1;
+	}
+
+	void GpuProfiler::BeginFrame()
+	{
+		m_Current = (m_Current + 1) % FRAME_LAG;
+		auto& frame = m_Frames[m_Current];
+		Collect(frame);
+
+		frame.Entries.clear();
+		m_FrameStart = std::chrono::steady_clock::now();
+		// the whole frame is measured by timestamps, they do not collide with the time elapsed queries of the sections
+		glQueryCounter(frame.Timestamps[0], GL_TIMESTAMP);
+	}
+
+	void GpuProfiler::EndFrame()
+	{
+		if (m_Open != NONE) End();
+
+		auto& frame = m_Frames[m_Current];
+		glQueryCounter(frame.Timestamps[1], GL_TIMESTAMP);
+		frame.Cpu = MillisecondsSince(m_FrameStart);
+		frame.Issued = true;
+	}
+
+	void GpuProfiler::Begin(unsigned section)
+	{
+		if (m_Open != NONE) End();
+
+		auto& frame = m_Frames[m_Current];
+		const unsigned index = (unsigned) frame.Entries.size();
+
+		// grow the pool of the frame slot, the queries stay allocated for the next frames using the slot
+		if (index == frame.Queries.size())
+		{
+			GLuint query = 0;
+			glGenQueries(1, &query);
+			frame.Queries.push_back(query);
+		}
+
+		frame.Entries.push_back({ section, frame.Queries[index], 0.0f });
+		m_Open = section;
+		m_SectionStart = std::chrono::steady_clock::now();
+		glBeginQuery(GL_TIME_ELAPSED, frame.Queries[index]);
+	}
+
+	void GpuProfiler::End()
+	{
+		if (m_Open == NONE) return;
+
+		glEndQuery(GL_TIME_ELAPSED);
+		m_Frames[m_Current].Entries.back().Cpu = MillisecondsSince(m_SectionStart);
+		m_Open = NONE;
+	}
+
+	void GpuProfiler::Collect(Frame& frame)
+	{
+		if (!frame.Issued) return;
+		frame.Issued = false;
+
+		// queries finish in order, the last timestamp being available means the whole frame is
+		GLint available = GL_FALSE;
+		if (!m_Wait) glGetQueryObjectiv(frame.Timestamps[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!m_Wait && available != GL_TRUE)
+		{
+			++m_Dropped;
+			return;
+		}
+
+		std::vector<float> gpu(m_Sections.size(), 0.0f);
+		std::vector<float> cpu(m_Sections.size(), 0.0f);
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(frame.Timestamps[0], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.Timestamps[1], GL_QUERY_RESULT, &end);
+		gpu[FRAME] = (end - begin) / 1000000.0f;
+		cpu[FRAME] = frame.Cpu;
+
+		for (const auto& entry : frame.Entries)
+		{
+			GLuint64 ns = 0;
+			glGetQueryObjectui64v(entry.Query, GL_QUERY_RESULT, &ns);
+			gpu[entry.Section] += ns / 1000000.0f;
+			cpu[entry.Section] += entry.Cpu;
+		}
+
+		for (unsigned i = 0; i < m_Sections.size(); ++i)
+		{
+			m_Sections[i].Gpu[m_Next] = gpu[i];
+			m_Sections[i].Cpu[m_Next] = cpu[i];
+		}
+
+		m_Next = (m_Next + 1) % PROFILER_HISTORY;
+		++m_Collected;
+
+		if (m_Recording) m_Recorded.push_back({ gpu[FRAME], cpu[FRAME] });
+
+		if (m_Csv.is_open()) WriteCsv(gpu, cpu);
+	}
+
+	GpuProfiler::Statistics GpuProfiler::GetStatistics(unsigned section) const
+	{
+		const unsigned count = std::min(m_Collected, PROFILER_HISTORY);
+		if (count == 0) return { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		// the ring is full after the first PROFILER_HISTORY frames, until then only its beginning is used
+		const auto& s = m_Sections[section];
+		const std::vector<float> gpu(s.Gpu.begin(), s.Gpu.begin() + count);
+		const std::vector<float> cpu(s.Cpu.begin(), s.Cpu.begin() + count);
+
+		float gpuSum = 0.0f, cpuSum = 0.0f;
+		for (unsigned i = 0; i < count; ++i)
+		{
+			gpuSum += gpu[i];
+			cpuSum += cpu[i];
+		}
+
+		return { gpuSum / count, Percentile(gpu, 0.99f), cpuSum / count, Percentile(cpu, 0.99f) };
+	}
+
+	void GpuProfiler::Flush()
+	{
+		const bool wait = m_Wait;
+		m_Wait = true;
+
+		// oldest frame first so the history and the records stay in order
+		for (unsigned i = 1; i <= FRAME_LAG; ++i) Collect(m_Frames[(m_Current + i) % FRAME_LAG]);
+
+		m_Wait = wait;
+	}
+
+	void GpuProfiler::StartRecording()
+	{
+		m_Recorded.clear();
+		m_Recording = true;
+	}
+
+	bool GpuProfiler::StartCsv(const std::string& path)
+	{
+		m_Csv.open(path, std::ios::out | std::ios::trunc);
+		if (!m_Csv.is_open()) return false;
+
+		m_CsvFrame = 0;
+		m_Csv << "frame";
+		for (const auto& s : m_Sections)
+		{
+			std::string name = s.Name;
+			std::replace(name.begin(), name.end(), ' ', '_');
+			m_Csv << ',' << name << "_gpu_ms," << name << "_cpu_ms";
+		}
+		m_Csv << '\n';
+		return true;
+	}
+
+	void GpuProfiler::StopCsv()
+	{
+		m_Csv.close();
+	}
+
+	void GpuProfiler::WriteCsv(const std::vector<float>& gpu, const std::vector<float>& cpu)
+	{
+		char value[32];
+		m_Csv << m_CsvFrame++;
+		for (unsigned i = 0; i < gpu.size(); ++i)
+		{
+			std::snprintf(value, sizeof(value), ",%.4f,%.4f", gpu[i], cpu[i]);
+			m_Csv << value;
+		}
+		m_Csv << '\n';
+	}
+
+	void GpuProfiler::Print(std::ostream& os) const
+	{
+		char line[128];
+		std::snprintf(line, sizeof(line), "%-16s %9s %9s %9s %9s\n", "section", "gpu avg", "gpu p99", "cpu avg", "cpu p99");
+		os << line;
+
+		for (unsigned i = 0; i < m_Sections.size(); ++i)
+		{
+			const auto s = GetStatistics(i);
+			std::snprintf(line, sizeof(line), "%-16s %9.3f %9.3f %9.3f %9.3f\n",
+				m_Sections[i].Name.c_str(), s.GpuAverage, s.GpuP99, s.CpuAverage, s.CpuP99);
+			os << line;
+		}
+		os << m_Dropped << " frames dropped while waiting for queries" << std::endl;
+	}
+
+	float GpuProfiler::Percentile(std::vector<float> samples, float p)
+	{
+		if (samples.empty()) return 0.0f;
+
+		const size_t n = std::min(samples.size() - 1, (size_t) (p * samples.size()));
+		std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+		return samples[n];
+	}
+
+	float GpuProfiler::MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
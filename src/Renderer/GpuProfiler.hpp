@@ -0,0 +1,188 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       GpuProfiler.hpp
+ * \author     Richard Kvasnica
+ * \brief      GPU profiler class declaration
+ *
+ * Measures GPU and CPU time of named parts of the frame with timer queries.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kvasnric
+{
+	/**
+	 * Measures GPU and CPU time of named sections of every frame. Queries of a frame are read back a few frames later
+	 * and a frame the GPU has not finished by then is dropped, so profiling never waits for the GPU.
+	 */
+	class GpuProfiler
+	{
+	public:
+		// rolling statistics of one section in milliseconds
+		struct Statistics
+		{
+			float GpuAverage;
+			float GpuP99;
+			float CpuAverage;
+			float CpuP99;
+		};
+
+		// GPU and CPU time of one whole frame in milliseconds
+		struct FrameTime
+		{
+			float Gpu;
+			float Cpu;
+		};
+
+		// id of the section measuring the whole frame
+		static const unsigned FRAME = 0;
+
+		GpuProfiler();
+		~GpuProfiler();
+
+		// deletes possible copy/move constructors
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler(GpuProfiler&&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(GpuProfiler&&) = delete;
+
+		/**
+		 * Registers a new section. Sections are reported in the order they were added.
+		 * @param name name shown in the overlay and in the csv header
+		 * @returns id of the section used by Begin
+		 */
+		unsigned AddSection(const std::string& name);
+
+		/**
+		 * Starts a new frame. Reads back the oldest buffered frame if the GPU has already finished it.
+		 */
+		void BeginFrame();
+
+		/**
+		 * Ends the frame started by BeginFrame
+		 */
+		void EndFrame();
+
+		/**
+		 * Starts measuring a section and ends the one being measured. Sections cannot nest, opengl allows
+		 * only one time elapsed query at once. A section measured several times during a frame reports the sum of the times.
+		 */
+		void Begin(unsigned section);
+
+		/**
+		 * Stops measuring the current section
+		 */
+		void End();
+
+		/**
+		 * @returns average and 99th percentile of the last PROFILER_HISTORY frames read back
+		 */
+		Statistics GetStatistics(unsigned section) const;
+
+		inline const std::string& Name(unsigned section) const { return m_Sections[section].Name; }
+		inline unsigned SectionCount() const { return (unsigned) m_Sections.size(); }
+
+		/**
+		 * @returns number of frames dropped because their queries were not finished in time
+		 */
+		inline unsigned Dropped() const { return m_Dropped; }
+
+		/**
+		 * Starts writing every frame read back as one row of a csv file. Sections have to be added before.
+		 * @returns whether the file could be opened
+		 */
+		bool StartCsv(const std::string& path);
+		void StopCsv();
+		inline bool IsWritingCsv() const { return m_Csv.is_open(); }
+
+		/**
+		 * Prints statistics of every section as a table
+		 */
+		void Print(std::ostream& os) const;
+
+		/**
+		 * Waits for the results of every frame instead of dropping the unfinished ones.
+		 * Measurements that have to be complete, like the benchmark, trade the stall for them.
+		 */
+		inline void SetWaitForResults(bool option) { m_Wait = option; }
+
+		/**
+		 * Reads back every buffered frame, waits for the GPU to finish them
+		 */
+		void Flush();
+
+		/**
+		 * Starts keeping the time of every whole frame read back, previous records are cleared
+		 */
+		void StartRecording();
+		inline const std::vector<FrameTime>& Recorded() const { return m_Recorded; }
+	private:
+		// times of one section in the last frames, a ring buffer indexed by m_Next
+		struct Section
+		{
+			std::string Name;
+			std::vector<float> Gpu;
+			std::vector<float> Cpu;
+		};
+
+		// one measurement of a section in a frame
+		struct Entry
+		{
+			unsigned Section;
+			unsigned Query;
+			float Cpu;
+		};
+
+		// queries issued during one frame, the query objects are reused when the frame slot comes around again
+		struct Frame
+		{
+			std::vector<unsigned> Queries;
+			std::vector<Entry> Entries;
+			unsigned Timestamps[2];
+			float Cpu;
+			bool Issued;
+		};
+
+		/**
+		 * Reads the queries of the frame if the last of them is available and stores the times into the history
+		 */
+		void Collect(Frame& frame);
+
+		/**
+		 * Appends the times of one collected frame to the csv file
+		 */
+		void WriteCsv(const std::vector<float>& gpu, const std::vector<float>& cpu);
+
+		static float Percentile(std::vector<float> samples, float p);
+		static float MillisecondsSince(std::chrono::steady_clock::time_point start);
+
+		static const unsigned FRAME_LAG = 3;
+		static const unsigned NONE = ~0u;
+
+		Frame m_Frames[FRAME_LAG];
+		unsigned m_Current;
+
+		std::vector<Section> m_Sections;
+		unsigned m_Next;
+		unsigned m_Collected;
+		unsigned m_Dropped;
+
+		bool m_Wait;
+		bool m_Recording;
+		std::vector<FrameTime> m_Recorded;
+
+		unsigned m_Open;
+		std::chrono::steady_clock::time_point m_SectionStart;
+		std::chrono::steady_clock::time_point m_FrameStart;
+
+		std::ofstream m_Csv;
+		unsigned m_CsvFrame;
+	};
+}
@@ -0,0 +1,210 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       LightClusters.cpp
+ * \author     Richard Kvasnica
+ * \brief      Clustered light culling definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "LightClusters.hpp"
+#include "FrameSync.hpp"
+
+#include <constants.hpp>
+
+namespace kvasnric
+{
+	LightClusters::LightClusters(int width, int height)
+		: m_ClusterPoints(COUNT), m_ClusterSpots(COUNT)
+		, m_PointBuffer(POINT_LIGHTS, DRAW::DYNAMIC), m_SpotBuffer(SPOT_LIGHTS, DRAW::DYNAMIC)
+		, m_Stream(STREAM_FRAME_SIZE)
+		, m_Projection(1.0f), m_DepthSlicing(NEAR_PLANE, 1.0f), m_Near(NEAR_PLANE), m_Far(FAR_PLANE)
+		, m_Width(width), m_Height(height), m_Version(1)
+	{
+		m_PointBuffer.Upload(nullptr, 0);
+		m_SpotBuffer.Upload(nullptr, 0);
+	}
+
+	void LightClusters::AddPointLight(const PointLight& light)
+	{
+		const glm::vec2 attenuation = light.GetAttenuation();
+
+		m_Points.push_back(light);
+		m_GpuPoints.push_back({
+			glm::vec4(light.GetPosition(), light.GetRange()),
+			glm::vec4(light.GetDiffuse(), light.GetIntensity()),
+			glm::vec4(light.GetSpecular(), attenuation.x),
+			glm::vec4(light.GetAmbient(), attenuation.y)
+		});
+
+		m_PointBuffer.Upload(m_GpuPoints.data(), (unsigned) (m_GpuPoints.size() * sizeof(GpuPointLight)));
+		++m_Version;
+	}
+
+	void LightClusters::AddSpotLight(const SpotLight& light)
+	{
+		const glm::vec2 cutOff = light.GetCutOff();
+
+		m_Spots.push_back(light);
+		m_GpuSpots.push_back({
+			glm::vec4(light.GetPosition(), light.GetRange()),
+			glm::vec4(light.GetDirection(), cutOff.x),
+			glm::vec4(light.GetDiffuse(), cutOff.y),
+			glm::vec4(light.GetSpecular(), 0.0f)
+		});
+
+		m_SpotBuffer.Upload(m_GpuSpots.data(), (unsigned) (m_GpuSpots.size() * sizeof(GpuSpotLight)));
+		++m_Version;
+	}
+
+	void LightClusters::Resize(int width, int height)
+	{
+		m_Width = width;
+		m_Height = height;
+		++m_Version;
+	}
+
+	void LightClusters::Update(const glm::mat4& view, const glm::mat4& projection, unsigned slot)
+	{
+		// version zero is never current, a new slot is binned by its first update
+		if (slot >= m_Views.size()) m_Views.resize(slot + 1, { glm::mat4(1.0f), glm::mat4(1.0f), m_DepthSlicing, {}, {}, {}, {}, ~0ull, 0 });
+
+		ViewLists& lists = m_Views[slot];
+		if (lists.Version != m_Version || view != lists.View || projection != lists.Projection)
+		{
+			lists.View = view;
+			lists.Projection = projection;
+			lists.Version = m_Version;
+			Bin(lists);
+			Upload(lists);
+		}
+		// ranges streamed in an older frame are overwritten by the later ones, the same lists are streamed again
+		else if (lists.Frame != FrameSync::Frame()) Upload(lists);
+		else
+		{
+			StreamBuffer::Bind(CLUSTERS, lists.ClusterRange);
+			StreamBuffer::Bind(LIGHT_INDICES, lists.IndexRange);
+		}
+
+		m_DepthSlicing = lists.DepthSlicing;
+	}
+
+	void LightClusters::Bin(ViewLists& lists)
+	{
+		const glm::mat4& view = lists.View;
+		const glm::mat4& projection = lists.Projection;
+		m_Projection = projection;
+
+		// near and far plane recovered from the perspective projection matrix
+		m_Near = projection[3][2] / (projection[2][2] - 1.0f);
+		m_Far = projection[3][2] / (projection[2][2] + 1.0f);
+		lists.DepthSlicing = glm::vec2(m_Near, SLICES / glm::log(m_Far / m_Near));
+		m_DepthSlicing = lists.DepthSlicing;
+
+		for (int i = 0; i < COUNT; ++i)
+		{
+			m_ClusterPoints[i].clear();
+			m_ClusterSpots[i].clear();
+		}
+
+		for (unsigned i = 0; i < m_GpuPoints.size(); ++i)
+		{
+			const glm::vec4& p = m_GpuPoints[i].Position;
+			Assign(m_ClusterPoints, i, glm::vec3(view * glm::vec4(glm::vec3(p), 1.0f)), p.w);
+		}
+
+		for (unsigned i = 0; i < m_GpuSpots.size(); ++i)
+		{
+			const SpotLight& spot = m_Spots[i];
+			const glm::vec3 direction = glm::normalize(spot.GetDirection());
+			const float range = spot.GetRange();
+			const float cosine = spot.GetCutOff().y;
+
+			// smallest sphere around the cone of the given range
+			glm::vec3 center = spot.GetPosition();
+			float radius = range;
+			if (cosine > glm::cos(glm::radians(45.0f)))
+			{
+				radius = range / (2.0f * cosine);
+				center += radius * direction;
+			}
+			else if (cosine > 0.0f)
+			{
+				radius = range * glm::sqrt(1.0f - cosine * cosine);
+				center += range * cosine * direction;
+			}
+
+			Assign(m_ClusterSpots, i, glm::vec3(view * glm::vec4(center, 1.0f)), radius);
+		}
+
+		// flatten the lists, point lights of the cluster go first then spot lights
+		lists.Clusters.resize(COUNT);
+		lists.Indices.clear();
+		for (int i = 0; i < COUNT; ++i)
+		{
+			const auto& points = m_ClusterPoints[i];
+			const auto& spots = m_ClusterSpots[i];
+
+			lists.Clusters[i] = glm::uvec4((unsigned) lists.Indices.size(), (unsigned) points.size(), (unsigned) spots.size(), 0u);
+			lists.Indices.insert(lists.Indices.end(), points.begin(), points.end());
+			lists.Indices.insert(lists.Indices.end(), spots.begin(), spots.end());
+		}
+	}
+
+	void LightClusters::Upload(ViewLists& lists)
+	{
+		lists.ClusterRange = m_Stream.Upload(CLUSTERS, lists.Clusters.data(), (unsigned) (lists.Clusters.size() * sizeof(glm::uvec4)));
+		lists.IndexRange = m_Stream.Upload(LIGHT_INDICES, lists.Indices.data(), (unsigned) (lists.Indices.size() * sizeof(unsigned)));
+		lists.Frame = FrameSync::Frame();
+	}
+
+	void LightClusters::Assign(std::vector<std::vector<unsigned>>& lists, unsigned index, const glm::vec3& center, float radius) const
+	{
+		// camera looks along negative z axis
+		const float depth = -center.z;
+		if (depth + radius < m_Near || depth - radius > m_Far) return;
+
+		int x0 = 0, x1 = TILES_X - 1;
+		int y0 = 0, y1 = TILES_Y - 1;
+
+		// sphere crossing the near plane can cover any tile, otherwise project its bounding box
+		if (depth - radius > m_Near)
+		{
+			glm::vec2 low(1.0f), high(-1.0f);
+			for (int i = 0; i < 8; ++i)
+			{
+				const glm::vec3 corner = center + radius * glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+				const glm::vec4 clip = m_Projection * glm::vec4(corner, 1.0f);
+				const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+				low = glm::min(low, ndc);
+				high = glm::max(high, ndc);
+			}
+
+			if (high.x < -1.0f || high.y < -1.0f || low.x > 1.0f || low.y > 1.0f) return;
+
+			x0 = glm::clamp((int) glm::floor((low.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1);
+			x1 = glm::clamp((int) glm::floor((high.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1);
+			y0 = glm::clamp((int) glm::floor((low.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1);
+			y1 = glm::clamp((int) glm::floor((high.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1);
+		}
+
+		const int z0 = Slice(depth - radius);
+		const int z1 = Slice(depth + radius);
+
+		for (int z = z0; z <= z1; ++z)
+		{
+			for (int y = y0; y <= y1; ++y)
+			{
+				for (int x = x0; x <= x1; ++x)
+				{
+					lists[(z * TILES_Y + y) * TILES_X + x].push_back(index);
+				}
+			}
+		}
+	}
+
+	int LightClusters::Slice(float depth) const
+	{
+		if (depth <= m_Near) return 0;
+		return glm::clamp((int) (glm::log(depth / m_Near) * m_DepthSlicing.y), 0, SLICES - 1);
+	}
+}
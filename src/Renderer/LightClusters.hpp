@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       LightClusters.hpp
+ * \author     Richard Kvasnica
+ * \brief      Clustered light culling declaration
+ *
+ * Keeps all point and spot lights in shader storage buffers and assigns them to a grid
+ * of view space clusters (screen tiles x exponential depth slices), so a fragment
+ * iterates only the lights that can reach its cluster.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Buffer.hpp"
+
+#include <Scene/Light.hpp>
+
+#include <vector>
+
+namespace kvasnric
+{
+	class LightClusters
+	{
+	public:
+		// binding points of the storage buffers, the same as in the shaders
+		enum BINDING
+		{
+			POINT_LIGHTS = 0,
+			SPOT_LIGHTS = 1,
+			CLUSTERS = 2,
+			LIGHT_INDICES = 3
+		};
+
+		// cluster grid dimensions, the same as in entity.frag
+		static const int TILES_X = 16;
+		static const int TILES_Y = 9;
+		static const int SLICES = 24;
+		static const int COUNT = TILES_X * TILES_Y * SLICES;
+
+		/**
+		 * Creates empty storage buffers
+		 * @param width width of the render target in pixels
+		 * @param height height of the render target in pixels
+		 */
+		LightClusters(int width, int height);
+
+		/**
+		 * Adds point light and uploads all point lights. Its reach is given by the attenuation.
+		 */
+		void AddPointLight(const PointLight& light);
+
+		/**
+		 * Adds spot light and uploads all spot lights. Its reach is given by the range and the outer cone.
+		 */
+		void AddSpotLight(const SpotLight& light);
+
+		/**
+		 * Updates tile size when the render target changes
+		 */
+		void Resize(int width, int height);
+
+		/**
+		 * Assigns lights to the clusters of the view and uploads them. Every view slot keeps its own lists,
+		 * they are binned again only when its view or the lights changed and streamed once per frame.
+		 * Later calls of the frame with the same slot only bind the streamed ranges again.
+		 * @param view 4x4 transformation matrix from world coordinate system to camera
+		 * @param projection perspective projection the clusters are sliced by
+		 * @param slot view the lists are kept for, like a portal level
+		 */
+		void Update(const glm::mat4& view, const glm::mat4& projection, unsigned slot = 0);
+
+		inline const std::vector<PointLight>& GetPointLights() const { return m_Points; }
+		inline unsigned SpotLightCount() const { return (unsigned) m_Spots.size(); }
+
+		// size of one tile in pixels
+		inline glm::vec2 TileSize() const { return glm::vec2((float) m_Width / TILES_X, (float) m_Height / TILES_Y); }
+
+		// near plane and slices per unit of logarithmic depth
+		inline glm::vec2 DepthSlicing() const { return m_DepthSlicing; }
+	private:
+		// std430 layouts of the lights, scalars are packed into the fourth components
+		struct GpuPointLight
+		{
+			glm::vec4 Position;		// w radius
+			glm::vec4 Diffuse;		// w intensity
+			glm::vec4 Specular;		// w linear attenuation
+			glm::vec4 Ambient;		// w quadratic attenuation
+		};
+
+		struct GpuSpotLight
+		{
+			glm::vec4 Position;		// w range
+			glm::vec4 Direction;	// w inner cut off
+			glm::vec4 Diffuse;		// w outer cut off
+			glm::vec4 Specular;
+		};
+
+		// lights binned for one view slot and the ranges they were streamed to
+		struct ViewLists
+		{
+			glm::mat4 View;
+			glm::mat4 Projection;
+			glm::vec2 DepthSlicing;
+			// offset into the index list, number of point lights, number of spot lights
+			std::vector<glm::uvec4> Clusters;
+			std::vector<unsigned> Indices;
+			StreamBuffer::Range ClusterRange;
+			StreamBuffer::Range IndexRange;
+			// frame which streamed the ranges and version of the lights the lists were binned for
+			uint64_t Frame;
+			unsigned Version;
+		};
+
+		/**
+		 * Assigns lights to the clusters of the view of the lists
+		 */
+		void Bin(ViewLists& lists);
+
+		/**
+		 * Inserts light index into every cluster overlapped by the view space sphere
+		 * @param lists per cluster index lists
+		 */
+		void Assign(std::vector<std::vector<unsigned>>& lists, unsigned index, const glm::vec3& center, float radius) const;
+
+		/**
+		 * Streams the clusters and the index list into the part of the current frame
+		 */
+		void Upload(ViewLists& lists);
+
+		/**
+		 * @returns depth slice of a positive view space depth
+		 */
+		int Slice(float depth) const;
+
+		std::vector<PointLight> m_Points;
+		std::vector<SpotLight> m_Spots;
+		std::vector<GpuPointLight> m_GpuPoints;
+		std::vector<GpuSpotLight> m_GpuSpots;
+
+		// per cluster light lists reused every binning to keep their capacity
+		std::vector<std::vector<unsigned>> m_ClusterPoints;
+		std::vector<std::vector<unsigned>> m_ClusterSpots;
+
+		// portal iterations repeat the same views in both passes, every slot is binned once
+		std::vector<ViewLists> m_Views;
+
+		ShaderStorageBuffer m_PointBuffer;
+		ShaderStorageBuffer m_SpotBuffer;
+		// clusters and indices change with every view, they are streamed
+		StreamBuffer m_Stream;
+
+		// projection and depth range of the view being binned
+		glm::mat4 m_Projection;
+		glm::vec2 m_DepthSlicing;
+		float m_Near;
+		float m_Far;
+		int m_Width;
+		int m_Height;
+		// changed by every added light and resize, lists of an older version are binned again
+		unsigned m_Version;
+	};
+}
@@ -0,0 +1,131 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       LightVolumeShader.cpp
+ * \author     Richard Kvasnica
+ * \brief      Child class light volume shader definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "LightVolumeShader.hpp"
+
+#include <constants.hpp>
+
+#include <vector>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <gl_core_4_4.h>
+
+namespace kvasnric
+{
+	LightVolumeShader::LightVolumeShader()
+		: ShaderProgram(ReadShaderFromFile("res/shaders/lightVolume.vert"), ReadShaderFromFile("res/shaders/lightVolume.frag"))
+		, u_PVM(-1), u_Position(-1), u_Normal(-1), u_Albedo(-1), u_Specular(-1), u_Ambient(-1), u_View(-1)
+		, u_Radius(-1), u_Level(-1), u_Light{}, m_Model(1.0f), m_Count(0), m_Sphere(nullptr)
+	{
+		AssignLocation(u_PVM);
+		AssignLocation(u_Position);
+		AssignLocation(u_Normal);
+		AssignLocation(u_Albedo);
+		AssignLocation(u_Specular);
+		AssignLocation(u_Ambient);
+		AssignLocation(u_View);
+		AssignLocation(u_Radius);
+		AssignLocation(u_Level);
+
+		AssignLocation(u_Light.position);
+		AssignLocation(u_Light.diffuse);
+		AssignLocation(u_Light.specular);
+		AssignLocation(u_Light.ambient);
+		AssignLocation(u_Light.attenuation);
+		AssignLocation(u_Light.intensity);
+
+		SetUniform1i(u_Position, GBuffer::POSITION);
+		SetUniform1i(u_Normal, GBuffer::NORMAL);
+		SetUniform1i(u_Albedo, GBuffer::ALBEDO);
+		SetUniform1i(u_Specular, GBuffer::SPECULAR);
+		SetUniform1i(u_Ambient, GBuffer::AMBIENT);
+		SetUniform1i(u_View, GBuffer::VIEW);
+
+		InitSphere();
+	}
+
+	void LightVolumeShader::UploadPointLight(const PointLight& light, const GBuffer& gbuffer)
+	{
+		Bind();
+		gbuffer.BindGeometryTextures();
+		m_Sphere->Bind();
+
+		SetUniform3f(u_Light.position, light.GetPosition());
+		SetUniform3f(u_Light.diffuse, light.GetDiffuse());
+		SetUniform3f(u_Light.specular, light.GetSpecular());
+		SetUniform3f(u_Light.ambient, light.GetAmbient());
+		SetUniform2f(u_Light.attenuation, light.GetAttenuation());
+		SetUniform1f(u_Light.intensity, light.GetIntensity());
+
+		const float radius = light.GetRange();
+		SetUniform1f(u_Radius, radius);
+
+		m_Model = glm::scale(glm::translate(UNIT_MATRIX, light.GetPosition()), glm::vec3(radius));
+	}
+
+	void LightVolumeShader::Render(const glm::mat4& pv, float level) const
+	{
+		SetUniformMat4(u_PVM, pv * m_Model);
+		SetUniform1f(u_Level, level);
+
+		// lights are summed in the accumulation target
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		RenderElements(0, m_Count);
+		glDisable(GL_BLEND);
+	}
+
+	void LightVolumeShader::InitSphere()
+	{
+		const unsigned stacks = 8;
+		const unsigned slices = 16;
+
+		// faces of the polygonal sphere are pushed out so the whole unit sphere is inside
+		const float half = glm::pi<float>() / slices;
+		const float scale = 1.0f / (glm::cos(half) * glm::cos(half));
+
+		std::vector<float> verts;
+		std::vector<unsigned> indices;
+
+		for (unsigned i = 0; i <= stacks; ++i)
+		{
+			const float theta = glm::pi<float>() * i / stacks;
+			for (unsigned j = 0; j <= slices; ++j)
+			{
+				const float phi = glm::two_pi<float>() * j / slices;
+				verts.push_back(scale * glm::sin(theta) * glm::cos(phi));
+				verts.push_back(scale * glm::cos(theta));
+				verts.push_back(scale * glm::sin(theta) * glm::sin(phi));
+			}
+		}
+
+		// triangles are counter clockwise seen from the outside, so with front face culling
+		// only the far side of the sphere is drawn and every covered pixel is lit exactly once
+		for (unsigned i = 0; i < stacks; ++i)
+		{
+			for (unsigned j = 0; j < slices; ++j)
+			{
+				const unsigned a = i * (slices + 1) + j;
+				const unsigned b = a + slices + 1;
+
+				indices.push_back(a); indices.push_back(b + 1); indices.push_back(b);
+				indices.push_back(a); indices.push_back(a + 1); indices.push_back(b + 1);
+			}
+		}
+
+		m_Count = (unsigned) indices.size();
+
+		m_Sphere.reset(new VertexArray());
+		m_Sphere->Bind();
+		m_Sphere->SetVertexBuffer(std::make_unique<VertexBuffer>(verts.data(), (unsigned) (verts.size() * sizeof(float)), DRAW::STATIC));
+		m_Sphere->SetElementBuffer(std::make_unique<ElementBuffer>(indices.data(), (unsigned) (indices.size() * sizeof(unsigned)), DRAW::STATIC));
+
+		m_Sphere->EnableVertexAttrib(POSITION_LOC);
+		m_Sphere->SetVertexAttribPointer(POSITION_LOC, 0, 3 * sizeof(float));
+	}
+}
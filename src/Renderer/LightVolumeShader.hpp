@@ -0,0 +1,72 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       LightVolumeShader.hpp
+ * \author     Richard Kvasnica
+ * \brief      Child class light volume shader declaration
+ *
+ * Adds point lights to the light accumulation target by rasterizing a sphere bounding
+ * the reach of the light, so only the covered pixels are shaded.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ShaderProgram.hpp"
+#include "GBuffer.hpp"
+
+#include <Scene/Light.hpp>
+
+namespace kvasnric
+{
+	class LightVolumeShader final : public ShaderProgram
+	{
+	public:
+		LightVolumeShader();
+		~LightVolumeShader() override = default;
+
+		/**
+		 * Uploads point light properties and binds geometry buffer targets. Has to be called before Render.
+		 * @param light point light lit by the next volumes
+		 * @param gbuffer geometry buffer filled by the geometry pass
+		 */
+		void UploadPointLight(const PointLight& light, const GBuffer& gbuffer);
+
+		/**
+		 * Renders volume of the last uploaded light into pixels of one portal iteration
+		 * @param pv projection view matrix the iteration was rendered with
+		 * @param level index of the iteration written by the geometry pass
+		 */
+		void Render(const glm::mat4& pv, float level) const;
+	private:
+		/**
+		 * Function initializes a vao of a unit sphere made of stacks and slices.
+		 */
+		void InitSphere();
+
+		struct PointLightLocation
+		{
+			int position;
+			int diffuse;
+			int specular;
+			int ambient;
+			int attenuation;
+			int intensity;
+		};
+
+		int u_PVM;
+		int u_Position;
+		int u_Normal;
+		int u_Albedo;
+		int u_Specular;
+		int u_Ambient;
+		int u_View;
+		int u_Radius;
+		int u_Level;
+		PointLightLocation u_Light;
+
+		glm::mat4 m_Model;
+		unsigned m_Count;
+
+		std::unique_ptr<VertexArray> m_Sphere;
+	};
+}
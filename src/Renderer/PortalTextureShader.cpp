@@ -52,7 +52,7 @@ namespace kvasnric
 		SetUniformMat4(u_Model, model);
 		SetUniformMat4(u_PV, projection*view);
 
-		glDrawArrays(GL_TRIANGLES, 0, m_Count);
+		RenderArrays(m_Count);
 		glDisable(GL_BLEND);
 	}
 	
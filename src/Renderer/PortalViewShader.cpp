@@ -0,0 +1,53 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       PortalViewShader.cpp
+ * \author     Richard Kvasnica
+ * \brief      Child class portal view shader definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "PortalViewShader.hpp"
+
+#include <gl_core_4_4.h>
+
+namespace kvasnric
+{
+	PortalViewShader::PortalViewShader()
+		: ShaderProgram(ReadShaderFromFile("res/shaders/portalView.vert"), ReadShaderFromFile("res/shaders/portalView.frag"))
+		, u_PVM(-1), u_TexturePVM(-1), u_View(-1), u_Resolution(-1), u_ScreenSpace(-1)
+	{
+		AssignLocation(u_PVM);
+		AssignLocation(u_TexturePVM);
+		AssignLocation(u_View);
+		AssignLocation(u_Resolution);
+		AssignLocation(u_ScreenSpace);
+
+		SetUniform1i(u_View, Texture::DIFFUSE);
+	}
+
+	void PortalViewShader::Render(const Portal& portal, const FrameBuffer& view, const glm::mat4& pv) const
+	{
+		Draw(portal, view, pv, pv, true);
+	}
+
+	void PortalViewShader::Render(const Portal& portal, const FrameBuffer& view, const glm::mat4& pv, const glm::mat4& texturePv) const
+	{
+		Draw(portal, view, pv, texturePv, false);
+	}
+
+	void PortalViewShader::Draw(const Portal& portal, const FrameBuffer& view, const glm::mat4& pv, const glm::mat4& texturePv,
+		bool screenSpace) const
+	{
+		Bind();
+
+		view.BindColor(Texture::DIFFUSE);
+		portal.GetVAO().Bind();
+
+		SetUniformMat4(u_PVM, pv * portal.GetModelMatrix());
+		SetUniformMat4(u_TexturePVM, texturePv * portal.GetModelMatrix());
+		SetUniform2f(u_Resolution, glm::vec2(view.Width(), view.Height()));
+		SetUniform1i(u_ScreenSpace, screenSpace ? 1 : 0);
+
+		RenderElements(0, portal.IndicesCount());
+	}
+}
@@ -0,0 +1,51 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       PortalViewShader.hpp
+ * \author     Richard Kvasnica
+ * \brief      Child class portal view shader declaration
+ *
+ * Draws the portal elipse filled with an offscreen rendered view through the portal.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ShaderProgram.hpp"
+#include "FrameBuffer.hpp"
+
+#include <Portal.hpp>
+
+namespace kvasnric
+{
+	class PortalViewShader final : public ShaderProgram
+	{
+	public:
+		PortalViewShader();
+		~PortalViewShader() override = default;
+
+		/**
+		 * Renders portal elipse sampling the view texture in screen space
+		 * @param portal portal which elipse is drawn
+		 * @param view framebuffer holding the image seen through the portal
+		 * @param pv projection view matrix
+		 */
+		void Render(const Portal& portal, const FrameBuffer& view, const glm::mat4& pv) const;
+
+		/**
+		 * Renders portal elipse sampling the view texture where the portal appeared on the screen it was rendered for
+		 * @param portal portal which elipse is drawn
+		 * @param view framebuffer holding the image seen through the portal
+		 * @param pv projection view matrix
+		 * @param texturePv projection view matrix of the camera the view was rendered for
+		 */
+		void Render(const Portal& portal, const FrameBuffer& view, const glm::mat4& pv, const glm::mat4& texturePv) const;
+	private:
+		void Draw(const Portal& portal, const FrameBuffer& view, const glm::mat4& pv, const glm::mat4& texturePv, bool screenSpace) const;
+
+		int u_PVM;
+		int u_TexturePVM;
+		int u_View;
+		int u_Resolution;
+		int u_ScreenSpace;
+	};
+}
@@ -0,0 +1,342 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ProgramCache.cpp
+ * \author     Richard Kvasnica
+ * \brief      Static Program Cache class definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "ProgramCache.hpp"
+#include "pgr.h"
+
+#include <constants.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+// KHR_parallel_shader_compile is newer than the loader, its token and function are the same for the ARB version
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (CODEGEN_FUNCPTR *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+namespace kvasnric
+{
+	namespace
+	{
+		const char CACHE_MAGIC[4] = { 'K', 'V', 'P', 'C' };
+		const uint32_t CACHE_VERSION = 1;
+
+		const uint64_t FNV_OFFSET = 14695981039346656037ull;
+		const uint64_t FNV_PRIME = 1099511628211ull;
+
+		uint64_t Fnv(uint64_t hash, const char* data, size_t size)
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash ^= (unsigned char) data[i];
+				hash *= FNV_PRIME;
+			}
+			return hash;
+		}
+
+		uint64_t Fnv(uint64_t hash, const std::string& str)
+		{
+			// terminating zero is hashed too, so "ab" + "c" differs from "a" + "bc"
+			return Fnv(hash, str.c_str(), str.size() + 1);
+		}
+
+		std::string ShaderLog(unsigned shader, const char* stage)
+		{
+			GLint status = GL_FALSE;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+			if (status == GL_TRUE) return "";
+
+			GLint length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			std::string log(length > 0 ? length : 1, '\0');
+			glGetShaderInfoLog(shader, (GLsizei) log.size(), nullptr, &log[0]);
+
+			return std::string(stage) + " shader:\n" + log.c_str() + "\n";
+		}
+
+		std::string ProgramLog(unsigned program)
+		{
+			GLint length = 0;
+			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+			std::string log(length > 0 ? length : 1, '\0');
+			glGetProgramInfoLog(program, (GLsizei) log.size(), nullptr, &log[0]);
+
+			return log.c_str();
+		}
+
+		template <typename T>
+		void WriteValue(std::ofstream& file, const T& value)
+		{
+			file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template <typename T>
+		bool ReadValue(std::ifstream& file, T& value)
+		{
+			return (bool) file.read(reinterpret_cast<char*>(&value), sizeof(T));
+		}
+	}
+
+	bool ProgramCache::s_Initialized = false;
+	bool ProgramCache::s_ParallelCompile = false;
+	bool ProgramCache::s_BinarySupport = false;
+	bool ProgramCache::s_Dirty = false;
+	uint64_t ProgramCache::s_Driver = 0;
+
+	std::unordered_map<uint64_t, ProgramCache::Pending> ProgramCache::s_Pending;
+	std::unordered_map<uint64_t, ProgramCache::Binary> ProgramCache::s_Binaries;
+
+	void ProgramCache::Init()
+	{
+		if (s_Initialized) return;
+		s_Initialized = true;
+
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i)
+		{
+			const char* ext = (const char*) glGetStringi(GL_EXTENSIONS, i);
+			if (std::strcmp(ext, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(ext, "GL_ARB_parallel_shader_compile") == 0)
+				s_ParallelCompile = true;
+		}
+
+		if (s_ParallelCompile)
+		{
+			// let the driver use as many compiler threads as it wants
+			auto maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) glutGetProcAddress("glMaxShaderCompilerThreadsKHR");
+			if (maxThreads == nullptr) maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) glutGetProcAddress("glMaxShaderCompilerThreadsARB");
+			if (maxThreads != nullptr) maxThreads(0xFFFFFFFF);
+		}
+
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		s_BinarySupport = formats > 0;
+
+		s_Driver = DriverHash();
+		if (s_BinarySupport) Read();
+	}
+
+	void ProgramCache::Prefetch(const std::string& vertexSrc, const std::string& fragSrc)
+	{
+		Init();
+
+		const uint64_t hash = Hash(vertexSrc, fragSrc);
+		if (s_Binaries.find(hash) != s_Binaries.end() || s_Pending.find(hash) != s_Pending.end()) return;
+
+		s_Pending.insert({ hash, Start(vertexSrc, fragSrc) });
+	}
+
+	unsigned ProgramCache::Acquire(const std::string& vertexSrc, const std::string& fragSrc)
+	{
+		Init();
+
+		const uint64_t hash = Hash(vertexSrc, fragSrc);
+
+		const auto binary = s_Binaries.find(hash);
+		if (binary != s_Binaries.end())
+		{
+			const unsigned program = Load(binary->second);
+			if (program != 0) return program;
+
+			// driver update can invalidate binaries without changing its strings, such binary is compiled again
+			s_Binaries.erase(binary);
+			s_Dirty = true;
+		}
+
+		const auto pending = s_Pending.find(hash);
+		if (pending != s_Pending.end())
+		{
+			const Pending p = pending->second;
+			s_Pending.erase(pending);
+			return Finish(p, hash);
+		}
+
+		return Finish(Start(vertexSrc, fragSrc), hash);
+	}
+
+	void ProgramCache::Save()
+	{
+		if (!s_Dirty || !s_BinarySupport) return;
+
+		std::ofstream file(PROGRAM_CACHE_PATH, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "Program cache could not be written to: " << PROGRAM_CACHE_PATH << std::endl;
+			return;
+		}
+
+		file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		WriteValue(file, CACHE_VERSION);
+		WriteValue(file, s_Driver);
+		WriteValue(file, (uint32_t) s_Binaries.size());
+
+		for (const auto& x : s_Binaries)
+		{
+			WriteValue(file, x.first);
+			WriteValue(file, (uint32_t) x.second.Format);
+			WriteValue(file, (uint32_t) x.second.Data.size());
+			file.write(x.second.Data.data(), x.second.Data.size());
+		}
+
+		s_Dirty = false;
+	}
+
+	void ProgramCache::Shutdown()
+	{
+		Save();
+
+		for (const auto& x : s_Pending)
+		{
+			glDeleteShader(x.second.Vert);
+			glDeleteShader(x.second.Frag);
+			glDeleteProgram(x.second.Program);
+		}
+		s_Pending.clear();
+	}
+
+	uint64_t ProgramCache::Hash(const std::string& vertexSrc, const std::string& fragSrc)
+	{
+		return Fnv(Fnv(FNV_OFFSET, vertexSrc), fragSrc);
+	}
+
+	uint64_t ProgramCache::DriverHash()
+	{
+		uint64_t hash = FNV_OFFSET;
+
+		for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION })
+		{
+			const char* str = (const char*) glGetString(name);
+			hash = Fnv(hash, str != nullptr ? str : "");
+		}
+		return hash;
+	}
+
+	ProgramCache::Pending ProgramCache::Start(const std::string& vertexSrc, const std::string& fragSrc)
+	{
+		Pending p;
+		p.Vert = glCreateShader(GL_VERTEX_SHADER);
+		p.Frag = glCreateShader(GL_FRAGMENT_SHADER);
+
+		const char* vs = vertexSrc.c_str();
+		const char* fs = fragSrc.c_str();
+		glShaderSource(p.Vert, 1, &vs, nullptr);
+		glShaderSource(p.Frag, 1, &fs, nullptr);
+		glCompileShader(p.Vert);
+		glCompileShader(p.Frag);
+
+		// statuses are not queried here, any query would make the driver finish the work right away
+		p.Program = glCreateProgram();
+		glAttachShader(p.Program, p.Vert);
+		glAttachShader(p.Program, p.Frag);
+		if (s_BinarySupport) glProgramParameteri(p.Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(p.Program);
+
+		return p;
+	}
+
+	unsigned ProgramCache::Finish(const Pending& pending, uint64_t hash)
+	{
+		while (!IsComplete(pending.Program)) std::this_thread::yield();
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(pending.Program, GL_LINK_STATUS, &status);
+
+		if (status != GL_TRUE)
+		{
+			const std::string msg = "Failed to create program\n" + ShaderLog(pending.Vert, "vertex")
+				+ ShaderLog(pending.Frag, "fragment") + ProgramLog(pending.Program);
+
+			glDeleteShader(pending.Vert);
+			glDeleteShader(pending.Frag);
+			glDeleteProgram(pending.Program);
+			throw std::runtime_error(msg.c_str());
+		}
+
+		// linked program does not need its shaders anymore
+		glDetachShader(pending.Program, pending.Vert);
+		glDetachShader(pending.Program, pending.Frag);
+		glDeleteShader(pending.Vert);
+		glDeleteShader(pending.Frag);
+
+		if (s_BinarySupport)
+		{
+			GLint length = 0;
+			glGetProgramiv(pending.Program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+			if (length > 0)
+			{
+				Binary binary;
+				GLenum format = 0;
+				binary.Data.resize(length);
+				glGetProgramBinary(pending.Program, length, nullptr, &format, binary.Data.data());
+				binary.Format = format;
+
+				s_Binaries[hash] = std::move(binary);
+				s_Dirty = true;
+			}
+		}
+
+		return pending.Program;
+	}
+
+	unsigned ProgramCache::Load(const Binary& binary)
+	{
+		const unsigned program = glCreateProgram();
+		glProgramBinary(program, binary.Format, binary.Data.data(), (GLsizei) binary.Data.size());
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status == GL_TRUE) return program;
+
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	bool ProgramCache::IsComplete(unsigned program)
+	{
+		// without the extension the status query itself waits for the driver
+		if (!s_ParallelCompile) return true;
+
+		GLint done = GL_FALSE;
+		glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+		return done == GL_TRUE;
+	}
+
+	void ProgramCache::Read()
+	{
+		std::ifstream file(PROGRAM_CACHE_PATH, std::ios::binary);
+		if (!file.is_open()) return;
+
+		char magic[sizeof(CACHE_MAGIC)];
+		uint32_t version = 0, count = 0;
+		uint64_t driver = 0;
+
+		if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0) return;
+		if (!ReadValue(file, version) || version != CACHE_VERSION) return;
+
+		// binaries of another driver are dropped, the file is rewritten on the next save
+		if (!ReadValue(file, driver) || driver != s_Driver) return;
+		if (!ReadValue(file, count)) return;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			uint64_t hash = 0;
+			uint32_t format = 0, size = 0;
+			if (!ReadValue(file, hash) || !ReadValue(file, format) || !ReadValue(file, size)) break;
+
+			Binary binary;
+			binary.Format = format;
+			binary.Data.resize(size);
+			if (!file.read(binary.Data.data(), size)) break;
+
+			s_Binaries.insert({ hash, std::move(binary) });
+		}
+	}
+}
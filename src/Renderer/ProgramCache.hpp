@@ -0,0 +1,115 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ProgramCache.hpp
+ * \author     Richard Kvasnica
+ * \brief      Static Program Cache class declaration
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kvasnric
+{
+	// Static class creating shader programs. Programs requested ahead are compiled by the driver in parallel,
+	// linked programs are stored as binaries on the disk so the next launch does not compile them at all.
+	class ProgramCache
+	{
+	public:
+		/**
+		 * Queries driver capabilities and loads binaries from the cache file. Called by the first request.
+		 */
+		static void Init();
+
+		/**
+		 * Starts compilation and linking of the program without waiting for it. Does nothing when its binary is cached.
+		 * @param vertexSrc glsl source code string of vertex shader
+		 * @param fragSrc glsl source code string of fragment shader
+		 */
+		static void Prefetch(const std::string& vertexSrc, const std::string& fragSrc);
+
+		/**
+		 * Returns linked program of the sources. Loads its binary, finishes the prefetched one or compiles it now.
+		 * @param vertexSrc glsl source code string of vertex shader
+		 * @param fragSrc glsl source code string of fragment shader
+		 * @returns opengl program id, the caller owns it
+		 */
+		static unsigned Acquire(const std::string& vertexSrc, const std::string& fragSrc);
+
+		/**
+		 * Writes binaries into the cache file if some were added since the last save
+		 */
+		static void Save();
+
+		/**
+		 * Saves the cache and deletes programs that were prefetched but never acquired. Called before the context is destroyed.
+		 */
+		static void Shutdown();
+
+	private:
+		// program whose shaders were sent to the driver but which was not checked yet
+		struct Pending
+		{
+			unsigned Program;
+			unsigned Vert;
+			unsigned Frag;
+		};
+
+		// binary retrieved from a linked program
+		struct Binary
+		{
+			unsigned Format;
+			std::vector<char> Data;
+		};
+
+		/**
+		 * @returns FNV-1a hash of both sources
+		 */
+		static uint64_t Hash(const std::string& vertexSrc, const std::string& fragSrc);
+
+		/**
+		 * @returns hash of the strings identifying the driver, binaries of another driver cannot be loaded
+		 */
+		static uint64_t DriverHash();
+
+		/**
+		 * Sends sources to the driver and starts the link without querying any status
+		 */
+		static Pending Start(const std::string& vertexSrc, const std::string& fragSrc);
+
+		/**
+		 * Waits for the program to link, checks it and stores its binary
+		 * @throws std::runtime_error when compilation or linking failed
+		 */
+		static unsigned Finish(const Pending& pending, uint64_t hash);
+
+		/**
+		 * Creates program from the cached binary
+		 * @returns program id or 0 when the driver rejected the binary
+		 */
+		static unsigned Load(const Binary& binary);
+
+		/**
+		 * @returns whether the driver finished the work on the program, so querying its status will not stall
+		 */
+		static bool IsComplete(unsigned program);
+
+		/**
+		 * Reads binaries from the cache file, whole file is ignored if it was written by another driver
+		 */
+		static void Read();
+
+		static bool s_Initialized;
+		static bool s_ParallelCompile;
+		static bool s_BinarySupport;
+		static bool s_Dirty;
+		static uint64_t s_Driver;
+
+		static std::unordered_map<uint64_t, Pending> s_Pending;
+		static std::unordered_map<uint64_t, Binary> s_Binaries;
+	};
+}
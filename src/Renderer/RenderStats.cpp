@@ -0,0 +1,99 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RenderStats.cpp
+ * \author     Richard Kvasnica
+ * \brief      Static render statistics class definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "RenderStats.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace kvasnric
+{
+	const char* const RenderStats::NAMES[COUNTERS] = {
+		"draws", "programs", "textures", "vaos", "uniforms", "stencil", "uniform B", "buffer B"
+	};
+
+	unsigned RenderStats::s_Current[VIEWS][COUNTERS] = {};
+	unsigned RenderStats::s_Last[VIEWS][COUNTERS] = {};
+	unsigned RenderStats::s_View = MAIN;
+	unsigned RenderStats::s_Frame = 0;
+	unsigned RenderStats::s_DumpInterval = 0;
+
+	void RenderStats::BeginFrame()
+	{
+		// uploads between frames, like loading the meshes, would be counted into the first frame otherwise
+		std::memset(s_Current, 0, sizeof(s_Current));
+		s_View = MAIN;
+	}
+
+	void RenderStats::EndFrame()
+	{
+		std::memcpy(s_Last, s_Current, sizeof(s_Last));
+		s_View = MAIN;
+		++s_Frame;
+
+		if (s_DumpInterval != 0 && s_Frame % s_DumpInterval == 0)
+		{
+			std::cout << "Render statistics of frame " << s_Frame << ":" << std::endl;
+			Print(std::cout);
+		}
+	}
+
+	void RenderStats::SetView(unsigned stampId)
+	{
+		// stencil values of the orange portal start at 10, levels deeper than the limit cannot be rendered
+		if (stampId < 10) s_View = stampId;
+		else s_View = PORTAL_MAX_ITERATIONS + stampId - 9;
+
+		if (s_View >= VIEWS) s_View = MAIN;
+	}
+
+	unsigned RenderStats::Total(COUNTER counter)
+	{
+		unsigned sum = 0;
+		for (unsigned view = 0; view < VIEWS; ++view) sum += s_Last[view][counter];
+		return sum;
+	}
+
+	void RenderStats::Print(std::ostream& os)
+	{
+		char cell[32];
+
+		std::snprintf(cell, sizeof(cell), "%-10s", "view");
+		os << cell;
+		for (const auto name : NAMES)
+		{
+			std::snprintf(cell, sizeof(cell), " %10s", name);
+			os << cell;
+		}
+		os << '\n';
+
+		for (unsigned view = 0; view <= VIEWS; ++view)
+		{
+			// the last row is the sum of all views, views not rendered in the frame are skipped
+			if (view < VIEWS && view != MAIN && s_Last[view][DRAW_CALLS] == 0 && s_Last[view][STENCIL_CHANGES] == 0) continue;
+
+			std::snprintf(cell, sizeof(cell), "%-10s", view < VIEWS ? ViewName(view).c_str() : "total");
+			os << cell;
+			for (unsigned c = 0; c < COUNTERS; ++c)
+			{
+				std::snprintf(cell, sizeof(cell), " %10u", view < VIEWS ? s_Last[view][c] : Total((COUNTER) c));
+				os << cell;
+			}
+			os << '\n';
+		}
+		os.flush();
+	}
+
+	std::string RenderStats::ViewName(unsigned view)
+	{
+		if (view == MAIN) return "main";
+		if (view <= (unsigned) PORTAL_MAX_ITERATIONS) return "blue " + std::to_string(view);
+		return "orange " + std::to_string(view - PORTAL_MAX_ITERATIONS);
+	}
+}
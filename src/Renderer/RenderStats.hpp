@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RenderStats.hpp
+ * \author     Richard Kvasnica
+ * \brief      Static render statistics class declaration
+ *
+ * Counts draw calls, state changes and uploaded bytes of every view rendered in a frame.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <constants.hpp>
+
+#include <ostream>
+#include <string>
+
+namespace kvasnric
+{
+	// Static class counting the work the renderer hands to opengl. Counters are kept separately for the main view
+	// and for every level of both portals, the wrappers of opengl calls add to the view that is being rendered.
+	class RenderStats
+	{
+	public:
+		// counted quantities, bytes are the sizes of the uploaded values and buffer data
+		enum COUNTER : unsigned
+		{
+			DRAW_CALLS = 0,
+			PROGRAM_BINDS,
+			TEXTURE_BINDS,
+			VAO_BINDS,
+			UNIFORMS,
+			STENCIL_CHANGES,
+			UNIFORM_BYTES,
+			BUFFER_BYTES,
+			COUNTERS
+		};
+
+		// main view followed by the levels of the blue and of the orange portal
+		static const unsigned MAIN = 0;
+		static const unsigned VIEWS = 1 + 2 * PORTAL_MAX_ITERATIONS;
+
+		/**
+		 * Clears the counters of the current frame and switches to the main view
+		 */
+		static void BeginFrame();
+
+		/**
+		 * Keeps the counters of the finished frame for queries and prints them if the dump interval has passed
+		 */
+		static void EndFrame();
+
+		/**
+		 * Switches the view following calls are counted to
+		 * @param stampId stencil value of the view, 0 is the main view, blue levels start at 1 and orange at 10
+		 */
+		static void SetView(unsigned stampId);
+
+		inline static void Count(COUNTER counter, unsigned amount = 1) { s_Current[s_View][counter] += amount; }
+
+		/**
+		 * Counts one uniform upload of the given size
+		 */
+		inline static void CountUniform(unsigned bytes)
+		{
+			++s_Current[s_View][UNIFORMS];
+			s_Current[s_View][UNIFORM_BYTES] += bytes;
+		}
+
+		/**
+		 * @returns value of the counter in the view during the last finished frame
+		 */
+		inline static unsigned Get(unsigned view, COUNTER counter) { return s_Last[view][counter]; }
+
+		/**
+		 * @returns value of the counter summed over all views of the last finished frame
+		 */
+		static unsigned Total(COUNTER counter);
+
+		/**
+		 * Prints the counters of the last frame every given number of frames
+		 * @param frames dump interval, zero turns dumping off
+		 */
+		inline static void SetDumpInterval(unsigned frames) { s_DumpInterval = frames; }
+		inline static unsigned DumpInterval() { return s_DumpInterval; }
+
+		/**
+		 * Prints counters of every view used in the last frame as a table
+		 */
+		static void Print(std::ostream& os);
+
+		/**
+		 * @returns name of the view, like main, blue 2 or orange 1
+		 */
+		static std::string ViewName(unsigned view);
+	private:
+		static const char* const NAMES[COUNTERS];
+
+		static unsigned s_Current[VIEWS][COUNTERS];
+		static unsigned s_Last[VIEWS][COUNTERS];
+		static unsigned s_View;
+		static unsigned s_Frame;
+		static unsigned s_DumpInterval;
+	};
+}
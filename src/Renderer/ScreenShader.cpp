@@ -0,0 +1,33 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ScreenShader.cpp
+ * \author     Richard Kvasnica
+ * \brief      Child class screen shader definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "ScreenShader.hpp"
+
+#include <Scene/Texture.hpp>
+
+namespace kvasnric
+{
+	ScreenShader::ScreenShader()
+		: ShaderProgram(ReadShaderFromFile("res/shaders/screen.vert"), ReadShaderFromFile("res/shaders/screen.frag"))
+		, u_Screen(-1), m_Empty(new VertexArray())
+	{
+		AssignLocation(u_Screen);
+
+		SetUniform1i(u_Screen, Texture::DIFFUSE);
+	}
+
+	void ScreenShader::Render(const GBuffer& gbuffer) const
+	{
+		Bind();
+
+		gbuffer.BindLightTexture(Texture::DIFFUSE);
+		m_Empty->Bind();
+
+		RenderFullScreenTriangle();
+	}
+}
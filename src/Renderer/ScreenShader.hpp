@@ -0,0 +1,35 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ScreenShader.hpp
+ * \author     Richard Kvasnica
+ * \brief      Child class screen shader declaration
+ *
+ * Copies the light accumulation target of the geometry buffer onto the screen.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ShaderProgram.hpp"
+#include "GBuffer.hpp"
+
+namespace kvasnric
+{
+	class ScreenShader final : public ShaderProgram
+	{
+	public:
+		ScreenShader();
+		~ScreenShader() override = default;
+
+		/**
+		 * Renders the lit image of the geometry buffer into the currently bound framebuffer
+		 * @param gbuffer geometry buffer with the accumulated light
+		 */
+		void Render(const GBuffer& gbuffer) const;
+	private:
+		int u_Screen;
+
+		// vertices are generated in the shader, core profile still needs a vao bound
+		std::unique_ptr<VertexArray> m_Empty;
+	};
+}
@@ -7,6 +7,8 @@
 //----------------------------------------------------------------------------------------
 
 #include "ShaderProgram.hpp"
+#include "ProgramCache.hpp"
+#include "RenderStats.hpp"
 #include "pgr.h"
 
 #include <stdexcept>
@@ -16,29 +18,22 @@
 namespace kvasnric
 {
 	ShaderProgram::ShaderProgram(const std::string& vertexSrc, const std::string& fragSrc)
-		: m_ID(0)
-		, m_Vert(pgr::createShaderFromSource(GL_VERTEX_SHADER, vertexSrc))
-		, m_Frag(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, fragSrc))
+		: m_ID(ProgramCache::Acquire(vertexSrc, fragSrc))
 	{
-		GLuint sh[3] = { m_Vert, m_Frag, 0 };
-
-		m_ID = pgr::createProgram(sh);
-
-		if (m_ID == 0)
-			throw std::runtime_error("Failed to create program");
-
 		glUseProgram(m_ID);
 	}
 
 	ShaderProgram::~ShaderProgram()
 	{
 		Unbind();
-		pgr::deleteProgramAndShaders(m_ID);
+		// shaders were deleted right after linking by the program cache
+		glDeleteProgram(m_ID);
 	}
 
 	void ShaderProgram::Bind() const
 	{
 		glUseProgram(m_ID);
+		RenderStats::Count(RenderStats::PROGRAM_BINDS);
 	}
 
 	void ShaderProgram::Unbind()
@@ -87,6 +82,19 @@ namespace kvasnric
 	void ShaderProgram::RenderElements(const unsigned offset, const unsigned count)
 	{
 		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*) offset);
+		RenderStats::Count(RenderStats::DRAW_CALLS);
+	}
+
+	void ShaderProgram::RenderFullScreenTriangle()
+	{
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		RenderStats::Count(RenderStats::DRAW_CALLS);
+	}
+
+	void ShaderProgram::RenderArrays(const unsigned count)
+	{
+		glDrawArrays(GL_TRIANGLES, 0, count);
+		RenderStats::Count(RenderStats::DRAW_CALLS);
 	}
 	
 	int ShaderProgram::GetAttribLocation(const std::string& name) const
@@ -118,70 +126,90 @@ namespace kvasnric
 	void ShaderProgram::SetUniform1i(const std::string& name, int value) const
 	{
 		glUniform1i(GetUniformLocation(name), value);
+		RenderStats::CountUniform(sizeof(int));
 	}
 
 	void ShaderProgram::SetUniform1i(const int location, int value)
 	{
 		glUniform1i(location, value);
+		RenderStats::CountUniform(sizeof(int));
+	}
+
+	void ShaderProgram::SetUniform1iv(const int location, const int* values, const int count)
+	{
+		glUniform1iv(location, count, values);
+		RenderStats::CountUniform(count * sizeof(int));
 	}
 
 	void ShaderProgram::SetUniform1f(const std::string& name, float value) const
 	{
 		glUniform1f(GetUniformLocation(name), value);
+		RenderStats::CountUniform(sizeof(float));
 	}
 
 	void ShaderProgram::SetUniform1f(const int location, float value)
 	{
 		glUniform1f(location, value);
+		RenderStats::CountUniform(sizeof(float));
 	}
 
 	void ShaderProgram::SetUniform2f(const std::string& name, const glm::vec2& value) const
 	{
 		glUniform2f(GetUniformLocation(name), value.x, value.y);
+		RenderStats::CountUniform(sizeof(glm::vec2));
 	}
 
 	void ShaderProgram::SetUniform2f(const int location, const glm::vec2& value)
 	{
 		glUniform2f(location, value.x, value.y);
+		RenderStats::CountUniform(sizeof(glm::vec2));
 	}
 
 	void ShaderProgram::SetUniform3f(const std::string& name, const glm::vec3& value) const
 	{
 		glUniform3f(GetUniformLocation(name), value.x, value.y, value.z);
+		RenderStats::CountUniform(sizeof(glm::vec3));
 	}
 
 	void ShaderProgram::SetUniform3f(const int location, const glm::vec3& value)
 	{
 		glUniform3f(location, value.x, value.y, value.z);
+		RenderStats::CountUniform(sizeof(glm::vec3));
 	}
 
 	void ShaderProgram::SetUniform4f(const std::string& name, const glm::vec4& value) const
 	{
 		glUniform4f(GetUniformLocation(name), value.x, value.y, value.z, value.w);
+		RenderStats::CountUniform(sizeof(glm::vec4));
 	}
 
 	void ShaderProgram::SetUniform4f(const int location, const glm::vec4& value)
 	{
 		glUniform4f(location, value.x, value.y, value.z, value.w);
+		RenderStats::CountUniform(sizeof(glm::vec4));
 	}
 
 	void ShaderProgram::SetUniformMat3(const std::string& name, const glm::mat3& matrix) const
 	{
 		glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
+		RenderStats::CountUniform(sizeof(glm::mat3));
 	}
 
 	void ShaderProgram::SetUniformMat3(const int location, const glm::mat3& matrix)
 	{
 		glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+		RenderStats::CountUniform(sizeof(glm::mat3));
 	}
 
 	void ShaderProgram::SetUniformMat4(const std::string& name, const glm::mat4& matrix) const
 	{
 		glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
+		RenderStats::CountUniform(sizeof(glm::mat4));
 	}
 
 	void ShaderProgram::SetUniformMat4(const int location, const glm::mat4& matrix)
 	{
 		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+		RenderStats::CountUniform(sizeof(glm::mat4));
 	}
 }
@@ -21,7 +21,8 @@ namespace kvasnric
 	{
 	public:
 		/**
-		 * Constructs a new shader program by compiling two inputting source strings
+		 * Constructs a new shader program from two inputting source strings. Program is taken from the program cache,
+		 * so it is compiled only if it was neither prefetched nor cached on the disk.
 		 * @param vertexSrc glsl source code string of vertex shader
 		 * @param fragSrc glsl source code string of fragment shader
 		 */
@@ -108,6 +109,7 @@ namespace kvasnric
 		 * Does the same as the above, only it takes hard uniform location and assigns value to it in the shader.
 		 */
 		static void SetUniform1i(int location, int value);
+		static void SetUniform1iv(int location, const int* values, int count);
 		static void SetUniform1f(int location, float value);
 		static void SetUniform2f(int location, const glm::vec2& value);
 		static void SetUniform3f(int location, const glm::vec3& value);
@@ -116,10 +118,20 @@ namespace kvasnric
 		static void SetUniformMat4(int location, const glm::mat4& matrix);
 
 		/**
-		 * Wraps glDrawElements opengl function
+		 * Wraps glDrawElements opengl function. Draw calls of all programs are counted by RenderStats.
 		 */
 		static void RenderElements(unsigned offset, unsigned count);
 
+		/**
+		 * Wraps glDrawArrays opengl function, draws triangles from the first vertex of the bound vao
+		 */
+		static void RenderArrays(unsigned count);
+
+		/**
+		 * Draws one triangle covering the whole screen. Vertices are generated in the vertex shader from gl_VertexID
+		 */
+		static void RenderFullScreenTriangle();
+
 		static void RenderBackFace();
 		static void RenderFrontFace();
 		static void EnableBlending();
@@ -146,8 +158,6 @@ namespace kvasnric
 		int GetUniformLocation(const char* name) const;
 
 		unsigned m_ID;
-		unsigned m_Vert;
-		unsigned m_Frag;
 
 		std::unordered_map<std::string, int> m_UniformLocations;
 	};
@@ -9,6 +9,7 @@
 //----------------------------------------------------------------------------------------
 
 #include "StencilStamp.hpp"
+#include "RenderStats.hpp"
 
 #include <gl_core_4_4.h>
 
@@ -28,20 +29,23 @@ namespace kvasnric
 		// binds shader
 		Bind();
 
-		// turns depth buffer to be read only
+		// turns depth buffer to be read only and the stamp does not leave any color
 		glDepthMask(GL_FALSE);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
 		// enables stencil test
 		EnableTest();
 
 		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
 		glStencilFunc(GL_EQUAL, stampId-1, 0xFF);
+		RenderStats::Count(RenderStats::STENCIL_CHANGES);
 
 		vao.Bind();
 		SetUniformMat4(u_PVM, pvm);
-		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
+		RenderElements(0, count);
 
-		// enables writing to depth buffer back
+		// enables writing to depth and color buffer back
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 		glDepthMask(GL_TRUE);
 	}
 
@@ -51,66 +55,52 @@ namespace kvasnric
 		Bind();
 
 		glDepthMask(GL_FALSE);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
 		EnableTest();
 
 		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 		glStencilFunc(GL_ALWAYS, stampId, 0xFF);
+		RenderStats::Count(RenderStats::STENCIL_CHANGES);
 
 		vao.Bind();
 		SetUniformMat4(u_PVM, pvm);
-		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
+		RenderElements(0, count);
 
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 		glDepthMask(GL_TRUE);
 	}
 
-	void StencilStamp::StampModel(const Model& m, const glm::mat4& pvm, unsigned stampId) const
-	{
-		Bind();
-
-		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-		glStencilFunc(GL_ALWAYS, stampId, 0xFF);
-		SetUniformMat4(u_PVM, pvm);
-		
-		for (const auto & mesh : m.GetMeshes())
-		{
-			mesh->Bind();
-			glDrawElements(GL_TRIANGLES, mesh->GetCountOfIndices(), GL_UNSIGNED_INT, nullptr);
-		}
-	}
-
-	unsigned StencilStamp::ReadStencilPixelValue(const int x, const int y)
-	{
-		unsigned char pixel = 0;
-		glReadPixels(x, y, 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &pixel);
-		return pixel;
-	}
-
 	void StencilStamp::StampWithShader(unsigned stampId)
 	{
 		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 		glStencilFunc(GL_ALWAYS, stampId, 0xFF);
+		RenderStats::Count(RenderStats::STENCIL_CHANGES);
 	}
 
 	void StencilStamp::CompareToStamp(unsigned stampId)
 	{
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 		glStencilFunc(GL_EQUAL, stampId, 0xFF);
+		RenderStats::Count(RenderStats::STENCIL_CHANGES);
 	}
 
 	void StencilStamp::CheckInStamp(unsigned stampId)
 	{
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 		glStencilFunc(GL_LEQUAL, stampId, 0xFF);
+		RenderStats::Count(RenderStats::STENCIL_CHANGES);
 	}
 
 	void StencilStamp::EnableTest()
 	{
 		glEnable(GL_STENCIL_TEST);
+		RenderStats::Count(RenderStats::STENCIL_CHANGES);
 	}
 
 	void StencilStamp::DisableTest()
 	{
 		glDisable(GL_STENCIL_TEST);
+		RenderStats::Count(RenderStats::STENCIL_CHANGES);
 	}
 }
@@ -11,7 +11,7 @@
 #pragma once
 
 #include "ShaderProgram.hpp"
-#include <Scene/Model.hpp>
+#include "VertexArray.hpp"
 
 namespace kvasnric
 {
@@ -38,19 +38,6 @@ namespace kvasnric
 		 */
 		void StampElementsFirst(const VertexArray& vao, unsigned count, const glm::mat4& pvm, unsigned stampId) const;
 
-		/**
-		 * Makes a stamp from Model instance.
-		 * @param m Model instance
-		 * @param pvm tansform stamp into the world
-		 * @param stampId stamp value that will be written into stencil buffer
-		 */
-		void StampModel(const Model& m, const glm::mat4& pvm, unsigned stampId) const;
-
-		/**
-		 * reads pixel value from stencil buffer
-		 */
-		static unsigned ReadStencilPixelValue(int x, int y);
-
 		/**
 		 * sets stencil function to write a value when we want other shader to be used.
 		 */
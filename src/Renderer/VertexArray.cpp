@@ -9,6 +9,7 @@
 //----------------------------------------------------------------------------------------
 
 #include "VertexArray.hpp"
+#include "RenderStats.hpp"
 
 #include <gl_core_4_4.h>
 
@@ -29,6 +30,7 @@ namespace kvasnric
 	void VertexArray::Bind() const
 	{
 		glBindVertexArray(m_ID);
+		RenderStats::Count(RenderStats::VAO_BINDS);
 	}
 
 	void VertexArray::Unbind()
@@ -36,6 +38,14 @@ namespace kvasnric
 		glBindVertexArray(0);
 	}
 
+	void VertexArray::SetElementBuffer(std::shared_ptr<ElementBuffer> ebo)
+	{
+		// element array binding is a state of the vao
+		Bind();
+		ebo->Bind();
+		m_ElementBuffer = std::move(ebo);
+	}
+
 	void VertexArray::SetVertexAttribPointer(unsigned short location, unsigned offset, unsigned stride, bool normalize)
 	{
 		glVertexAttribPointer(location, 3, GL_FLOAT, normalize, stride, (void*) offset);
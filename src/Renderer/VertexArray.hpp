@@ -45,13 +45,10 @@ namespace kvasnric
 		}
 
 		/**
-		 * Assigns element buffer object to vao
-		 * @param ebo r-value reference to unique pointer of an ebo
+		 * Assigns element buffer object to vao. Binds the vao, so an ebo shared by more vaos is attached to each of them.
+		 * @param ebo shared pointer of an ebo
 		 */
-		inline void SetElementBuffer(std::unique_ptr<ElementBuffer>&& ebo)
-		{
-			m_ElementBuffer = std::move(ebo);
-		}
+		void SetElementBuffer(std::shared_ptr<ElementBuffer> ebo);
 
 		/**
 		 * Wraps opengl call of glVertexAttribPointer
@@ -65,6 +62,6 @@ namespace kvasnric
 	private:
 		unsigned m_ID;
 		std::unique_ptr<VertexBuffer> m_VertexBuffer;
-		std::unique_ptr<ElementBuffer> m_ElementBuffer;
+		std::shared_ptr<ElementBuffer> m_ElementBuffer;
 	};
 }
@@ -12,8 +12,8 @@
 
 namespace kvasnric
 {
-	MountedCamera::MountedCamera(const GameObject * x)
-		: Camera(), m_Mount(x)
+	MountedCamera::MountedCamera(const EntityStore& store, Entity mount)
+		: Camera(), m_Store(store), m_Mount(mount)
 	{
 		UpdateCameraSpace();
 	}
@@ -39,8 +39,8 @@ namespace kvasnric
 			sin(m_Yaw) * cos(m_Pitch)
 		));
 
-		// shift camera position from gameobject position by the direction vector
-		m_Position = m_Mount->GetPosition() + 2.0f*m_Front;
+		// shift camera position from entity position by the direction vector
+		if (m_Store.IsAlive(m_Mount)) m_Position = m_Store.GetWorldPosition(m_Mount) + 2.0f*m_Front;
 
 		// reverse the look vector so the shifted camera faces the object.
 		m_Front = -m_Front;
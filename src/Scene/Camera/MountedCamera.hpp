@@ -11,7 +11,7 @@
 #pragma once
 
 #include "Camera.hpp"
-#include <Scene/GameObject.hpp>
+#include <Scene/EntityStore.hpp>
 
 namespace kvasnric
 {
@@ -19,10 +19,11 @@ namespace kvasnric
 	{
 	public:
 		/**
-		 * Constructor that takes in valid GameObject pointer
-		 * so it can use virtual calls.
+		 * Constructor that takes the entity the camera looks at
+		 * @param store entities, has to outlive the camera
+		 * @param mount handle of the entity, the camera stays where it was once the entity is destroyed
 		 */
-		MountedCamera(const GameObject * x);
+		MountedCamera(const EntityStore& store, Entity mount);
 
 		/**
 		 * Handles updating yaw and pitch angles of the camera
@@ -30,11 +31,12 @@ namespace kvasnric
 		void MouseMovement(const glm::vec2& offset) override;
 
 		/**
-		 * Updates camera space by moving camera position by the direction of yaw and pitch angles from the gameobject position.
+		 * Updates camera space by moving camera position by the direction of yaw and pitch angles from the entity position.
 		 */
 		void UpdateCameraSpace() override;
 	private:
 		
-		const GameObject * m_Mount;
+		const EntityStore& m_Store;
+		Entity m_Mount;
 	};
 }
\ No newline at end of file
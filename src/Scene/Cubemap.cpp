@@ -10,6 +10,7 @@
 
 #include <pgr.h>
 #include <constants.hpp>
+#include <Renderer/RenderStats.hpp>
 
 namespace kvasnric
 {
@@ -19,15 +20,15 @@ namespace kvasnric
 		glActiveTexture(GL_TEXTURE0 + m_Type);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, m_ID);
 
-		// loads six different textures
+		// loads six different textures, sky colors are sRGB
 		const std::string path = "res/textures/cubemaps/" + m_Name;
 		if (
-			!pgr::loadTexImage2D(path + "_px.png", GL_TEXTURE_CUBE_MAP_POSITIVE_X) ||
-			!pgr::loadTexImage2D(path + "_nx.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_X) ||
-			!pgr::loadTexImage2D(path + "_py.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Y) ||
-			!pgr::loadTexImage2D(path + "_ny.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Y) ||
-			!pgr::loadTexImage2D(path + "_pz.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Z) ||
-			!pgr::loadTexImage2D(path + "_nz.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Z))
+			!UploadImage(path + "_px.png", GL_TEXTURE_CUBE_MAP_POSITIVE_X, true) ||
+			!UploadImage(path + "_nx.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_X, true) ||
+			!UploadImage(path + "_py.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Y, true) ||
+			!UploadImage(path + "_ny.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, true) ||
+			!UploadImage(path + "_pz.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Z, true) ||
+			!UploadImage(path + "_nz.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, true))
 		{
 			const std::string msg = "Cannot load cube map texture: " + m_Name;
 			throw std::runtime_error(msg.c_str());
@@ -46,6 +47,7 @@ namespace kvasnric
 	{
 		glActiveTexture(GL_TEXTURE0 + m_Type);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, m_ID);
+		RenderStats::Count(RenderStats::TEXTURE_BINDS);
 	}
 
 	CubeMapShader::CubeMapShader()
@@ -85,7 +87,7 @@ namespace kvasnric
 		SetUniformMat4(u_PV, projection*viewT);
 
 		// draw triangles of currently bound vao
-		glDrawArrays(GL_TRIANGLES, 0, m_Count);
+		RenderArrays(m_Count);
 
 		// switch depth eval function back to less
 		glDepthFunc(GL_LESS);
@@ -0,0 +1,347 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       EntityStore.cpp
+ * \author     Richard Kvasnica
+ * \brief      Packed component arrays of scene entities definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "EntityStore.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace kvasnric
+{
+	const uint32_t EntityStore::NONE;
+
+	/**
+	 * Copies the kept elements in the new order
+	 */
+	template <typename T>
+	static void Gather(std::vector<T>& values, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> gathered;
+		gathered.reserve(order.size());
+		for (const uint32_t i : order) gathered.push_back(std::move(values[i]));
+		values.swap(gathered);
+	}
+
+	Entity EntityStore::Create(std::shared_ptr<Model> model, const glm::vec3& position, const glm::mat4& basis,
+		unsigned flags, Entity parent)
+	{
+		const uint32_t parentIndex = parent == Entity() ? NONE : IndexOf(parent);
+
+		auto bounds = m_ModelBounds.find(model.get());
+		if (bounds == m_ModelBounds.end())
+		{
+			glm::vec3 min(INFINITY), max(-INFINITY);
+			for (const auto& mesh : model->GetMeshes())
+			{
+				for (const auto& v : mesh->GetVertices())
+				{
+					min = glm::min(min, v.Position);
+					max = glm::max(max, v.Position);
+				}
+			}
+
+			// model without vertices gets an empty box at its origin
+			if (min.x > max.x) min = max = glm::vec3(0.0f);
+			bounds = m_ModelBounds.emplace(model.get(), std::make_pair((min + max) * 0.5f, (max - min) * 0.5f)).first;
+		}
+
+		uint32_t slot;
+		if (m_FreeSlots.empty())
+		{
+			slot = (uint32_t) m_SlotIndices.size();
+			m_SlotIndices.push_back(NONE);
+			m_SlotGenerations.push_back(0);
+		}
+		else
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+
+		// parent already exists, so appending keeps parents before their children
+		m_SlotIndices[slot] = (uint32_t) m_Models.size();
+		m_IndexSlots.push_back(slot);
+
+		m_Positions.push_back(position);
+		m_Bases.push_back(basis);
+		m_Parents.push_back(parentIndex);
+		m_Dirty.push_back(1);
+		m_World.push_back(UNIT_MATRIX);
+
+		m_LocalCenters.push_back(bounds->second.first);
+		m_LocalExtents.push_back(bounds->second.second);
+		m_Centers.push_back(glm::vec3(0.0f));
+		m_Extents.push_back(glm::vec3(0.0f));
+
+		m_Models.push_back(std::move(model));
+		m_Flags.push_back(flags);
+
+		return Entity(slot, m_SlotGenerations[slot]);
+	}
+
+	bool EntityStore::IsAlive(Entity entity) const
+	{
+		return entity.Slot < m_SlotIndices.size() && m_SlotIndices[entity.Slot] != NONE
+			&& m_SlotGenerations[entity.Slot] == entity.Generation;
+	}
+
+	uint32_t EntityStore::IndexOf(Entity entity) const
+	{
+		if (!IsAlive(entity)) throw std::runtime_error("Entity " + std::to_string(entity.Slot) + " does not exist");
+		return m_SlotIndices[entity.Slot];
+	}
+
+	void EntityStore::Destroy(Entity entity)
+	{
+		const uint32_t root = IndexOf(entity);
+		if (!m_Sorted) Sort();
+
+		// children come after their parents, one sweep finds the whole subtree
+		std::vector<uint8_t> removed(m_Models.size(), 0);
+		removed[root] = 1;
+		for (uint32_t i = root + 1; i < m_Models.size(); ++i)
+		{
+			if (m_Parents[i] != NONE && removed[m_Parents[i]]) removed[i] = 1;
+		}
+
+		std::vector<uint32_t> order;
+		order.reserve(m_Models.size());
+		for (uint32_t i = 0; i < m_Models.size(); ++i)
+		{
+			if (!removed[i])
+			{
+				order.push_back(i);
+				continue;
+			}
+
+			// old handles of the slot never match again
+			const uint32_t slot = m_IndexSlots[i];
+			m_SlotIndices[slot] = NONE;
+			++m_SlotGenerations[slot];
+			m_FreeSlots.push_back(slot);
+		}
+
+		m_Movers.erase(std::remove_if(m_Movers.begin(), m_Movers.end(),
+			[&](const Mover& mover) { return m_SlotIndices[mover.Slot] == NONE; }), m_Movers.end());
+
+		Reorder(order);
+	}
+
+	void EntityStore::SetParent(Entity entity, Entity parent)
+	{
+		const uint32_t index = IndexOf(entity);
+		const uint32_t parentIndex = parent == Entity() ? NONE : IndexOf(parent);
+
+		for (uint32_t p = parentIndex; p != NONE; p = m_Parents[p])
+		{
+			if (p == index) throw std::runtime_error("Entity cannot be a parent of itself");
+		}
+
+		m_Parents[index] = parentIndex;
+		m_Dirty[index] = 1;
+		m_Sorted = false;
+	}
+
+	void EntityStore::AttachMover(Entity entity, std::shared_ptr<Spline> spline)
+	{
+		IndexOf(entity);
+		m_Movers.push_back({ entity.Slot, std::move(spline) });
+	}
+
+	void EntityStore::SetPosition(Entity entity, const glm::vec3& position)
+	{
+		const uint32_t i = IndexOf(entity);
+		m_Positions[i] = position;
+		m_Dirty[i] = 1;
+	}
+
+	void EntityStore::Translate(Entity entity, const glm::vec3& vec)
+	{
+		const uint32_t i = IndexOf(entity);
+		m_Positions[i] += vec;
+		m_Dirty[i] = 1;
+	}
+
+	void EntityStore::Scale(Entity entity, const glm::vec3& scale)
+	{
+		const uint32_t i = IndexOf(entity);
+		m_Bases[i] = glm::scale(UNIT_MATRIX, scale) * m_Bases[i];
+		m_Dirty[i] = 1;
+	}
+
+	void EntityStore::RotationYAxis(Entity entity, float angle)
+	{
+		const uint32_t i = IndexOf(entity);
+		m_Bases[i] = glm::rotate(UNIT_MATRIX, glm::radians(angle), Y_AXIS) * m_Bases[i];
+		m_Dirty[i] = 1;
+	}
+
+	const glm::vec3& EntityStore::GetPosition(Entity entity) const
+	{
+		return m_Positions[IndexOf(entity)];
+	}
+
+	glm::vec3 EntityStore::GetWorldPosition(Entity entity) const
+	{
+		return glm::vec3(m_World[IndexOf(entity)][3]);
+	}
+
+	const glm::mat4& EntityStore::GetModelMatrix(Entity entity) const
+	{
+		return m_World[IndexOf(entity)];
+	}
+
+	const Model& EntityStore::GetModel(Entity entity) const
+	{
+		return *m_Models[IndexOf(entity)];
+	}
+
+	bool EntityStore::IsInProximity(Entity entity, const glm::vec3& pos, float proximity) const
+	{
+		const glm::vec3 dist = GetWorldPosition(entity) - pos;
+		return glm::dot(dist, dist) < proximity * proximity;
+	}
+
+	void EntityStore::UpdateMovers(float time)
+	{
+		for (const auto& mover : m_Movers)
+		{
+			const uint32_t i = m_SlotIndices[mover.Slot];
+			m_Positions[i] = mover.Path->GetPosition(time);
+
+			// facing the direction of the spline, x axis stays horizontal
+			const glm::vec3 z = glm::normalize(mover.Path->GetDirection(time));
+			const glm::vec3 x = glm::normalize(glm::cross(WORLD_UP, z));
+			const glm::vec3 y = glm::normalize(glm::cross(z, x));
+
+			m_Bases[i] = {
+				x.x, x.y, x.z, 0.0f,
+				y.x, y.y, y.z, 0.0f,
+				z.x, z.y, z.z, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f
+			};
+			m_Dirty[i] = 1;
+		}
+	}
+
+	void EntityStore::UpdateTransforms()
+	{
+		if (!m_Sorted) Sort();
+
+		const uint32_t count = (uint32_t) m_Models.size();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			// parent was already visited, its flag tells whether it moved in this update
+			const uint32_t parent = m_Parents[i];
+			if (parent != NONE && m_Dirty[parent]) m_Dirty[i] = 1;
+			if (!m_Dirty[i]) continue;
+
+			glm::mat4 world = glm::translate(UNIT_MATRIX, m_Positions[i]) * m_Bases[i];
+			if (parent != NONE) world = m_World[parent] * world;
+			m_World[i] = world;
+
+			// box of the transformed box, the half extent is projected on the world axes
+			const glm::vec3& e = m_LocalExtents[i];
+			m_Centers[i] = glm::vec3(world * glm::vec4(m_LocalCenters[i], 1.0f));
+			m_Extents[i] = glm::abs(glm::vec3(world[0])) * e.x + glm::abs(glm::vec3(world[1])) * e.y + glm::abs(glm::vec3(world[2])) * e.z;
+		}
+
+		std::fill(m_Dirty.begin(), m_Dirty.end(), 0);
+	}
+
+	void EntityStore::Cull(std::vector<uint32_t>& visible, const glm::mat4& pv, unsigned mask) const
+	{
+		// planes of the frustum are sums and differences of the rows of the matrix, normals point inside
+		glm::vec4 planes[6];
+		glm::vec3 absNormals[6];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const glm::vec4 row(pv[0][axis], pv[1][axis], pv[2][axis], pv[3][axis]);
+			const glm::vec4 w(pv[0][3], pv[1][3], pv[2][3], pv[3][3]);
+			planes[2 * axis] = w + row;
+			planes[2 * axis + 1] = w - row;
+		}
+		for (int p = 0; p < 6; ++p) absNormals[p] = glm::abs(glm::vec3(planes[p]));
+
+		visible.clear();
+		const uint32_t count = (uint32_t) m_Models.size();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!(m_Flags[i] & mask)) continue;
+
+			const glm::vec3& c = m_Centers[i];
+			const glm::vec3& e = m_Extents[i];
+
+			// box is outside when even its corner furthest along the normal is behind a plane
+			int p = 0;
+			while (p < 6 && glm::dot(glm::vec3(planes[p]), c) + glm::dot(absNormals[p], e) + planes[p].w >= 0.0f) ++p;
+
+			if (p == 6) visible.push_back(i);
+		}
+	}
+
+	void EntityStore::Sort()
+	{
+		// children of every entity are listed after each other, like elements of a sparse matrix row
+		const uint32_t count = (uint32_t) m_Models.size();
+		std::vector<uint32_t> start(count + 1, 0), children(count);
+		for (const uint32_t parent : m_Parents)
+		{
+			if (parent != NONE) ++start[parent + 1];
+		}
+		for (size_t i = 1; i < start.size(); ++i) start[i] += start[i - 1];
+
+		std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+		std::vector<uint32_t> order;
+		order.reserve(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (m_Parents[i] == NONE) order.push_back(i);
+			else children[fill[m_Parents[i]]++] = i;
+		}
+
+		// the order itself is the queue of the breadth first walk
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			const uint32_t entity = order[i];
+			order.insert(order.end(), children.begin() + start[entity], children.begin() + start[entity + 1]);
+		}
+
+		Reorder(order);
+		m_Sorted = true;
+	}
+
+	void EntityStore::Reorder(const std::vector<uint32_t>& order)
+	{
+		// new index of every old one, parents have to be translated to it
+		std::vector<uint32_t> remap(m_Models.size(), NONE);
+		for (uint32_t i = 0; i < order.size(); ++i) remap[order[i]] = i;
+		for (auto& parent : m_Parents)
+		{
+			if (parent != NONE) parent = remap[parent];
+		}
+
+		Gather(m_Positions, order);
+		Gather(m_Bases, order);
+		Gather(m_Parents, order);
+		Gather(m_Dirty, order);
+		Gather(m_World, order);
+		Gather(m_LocalCenters, order);
+		Gather(m_LocalExtents, order);
+		Gather(m_Centers, order);
+		Gather(m_Extents, order);
+		Gather(m_Models, order);
+		Gather(m_Flags, order);
+		Gather(m_IndexSlots, order);
+
+		for (uint32_t i = 0; i < m_IndexSlots.size(); ++i) m_SlotIndices[m_IndexSlots[i]] = i;
+	}
+}
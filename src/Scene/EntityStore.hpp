@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       EntityStore.hpp
+ * \author     Richard Kvasnica
+ * \brief      Packed component arrays of scene entities declaration
+ *
+ * Every component of the entities is kept in its own array, one element per entity at the same index,
+ * so moving, updating matrices, culling and building the render list are linear sweeps over few arrays.
+ * Arrays are packed and ordered with parents before their children, entities are therefore moved
+ * around and referenced from the outside by handles, not by indices or pointers.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Model.hpp"
+#include "Spline.hpp"
+
+#include <constants.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kvasnric
+{
+	// stable reference to an entity, it stays valid until the entity is destroyed however the arrays move
+	struct Entity
+	{
+		Entity() : Slot(0xffffffffu), Generation(0) {}
+		Entity(uint32_t slot, uint32_t generation) : Slot(slot), Generation(generation) {}
+
+		inline bool operator==(const Entity& x) const { return Slot == x.Slot && Generation == x.Generation; }
+		inline bool operator!=(const Entity& x) const { return !(*this == x); }
+
+		uint32_t Slot;
+		uint32_t Generation;
+	};
+
+	class EntityStore
+	{
+	public:
+		// what the entity is for, culling passes a mask of the flags it wants
+		enum FLAG : unsigned
+		{
+			QUEUED = 1 << 0,	// drawn by the queued opaque pass, other entities are drawn one by one by their handle
+			ALL = 0xffffffffu
+		};
+
+		EntityStore() = default;
+		EntityStore(const EntityStore&) = delete;
+		EntityStore& operator=(const EntityStore&) = delete;
+
+		/**
+		 * Creates an entity, its world matrix is computed by the next UpdateTransforms
+		 * @param model model rendered for the entity
+		 * @param position position relative to the parent, in world space if it has none
+		 * @param basis rotation and scale relative to the parent, without translation
+		 * @param flags bit mask of FLAG values
+		 * @param parent entity whose transformation this one follows, default handle for none
+		 */
+		Entity Create(std::shared_ptr<Model> model, const glm::vec3& position, const glm::mat4& basis = UNIT_MATRIX,
+			unsigned flags = QUEUED, Entity parent = Entity());
+
+		/**
+		 * Destroys the entity together with everything attached below it, their handles become invalid
+		 */
+		void Destroy(Entity entity);
+
+		/**
+		 * @returns whether the handle refers to an entity which was not destroyed
+		 */
+		bool IsAlive(Entity entity) const;
+
+		/**
+		 * Changes the parent of an entity. The relative transformation is kept, so the entity moves with the new parent.
+		 * @param parent new parent, it must not be the entity or any entity below it, default handle for none
+		 */
+		void SetParent(Entity entity, Entity parent);
+
+		/**
+		 * Makes the entity follow the spline, facing its direction
+		 */
+		void AttachMover(Entity entity, std::shared_ptr<Spline> spline);
+
+		void SetPosition(Entity entity, const glm::vec3& position);
+		void Translate(Entity entity, const glm::vec3& vec);
+		void Scale(Entity entity, const glm::vec3& scale);
+
+		/**
+		 * Rotates the entity by angle in degrees around y axis on top of its current rotation and scale
+		 */
+		void RotationYAxis(Entity entity, float angle);
+
+		const glm::vec3& GetPosition(Entity entity) const;
+		glm::vec3 GetWorldPosition(Entity entity) const;
+
+		/**
+		 * @returns model matrix from model space to world space computed by the last UpdateTransforms
+		 */
+		const glm::mat4& GetModelMatrix(Entity entity) const;
+		const Model& GetModel(Entity entity) const;
+
+		/**
+		 * @returns If the position in world coordinates is closer to the entity than proximity.
+		 */
+		bool IsInProximity(Entity entity, const glm::vec3& pos, float proximity) const;
+
+		/**
+		 * Moves every entity with a mover to its place on the spline at the given time
+		 */
+		void UpdateMovers(float time);
+
+		/**
+		 * Computes world matrices and world bounds of the entities which changed and of everything below them
+		 */
+		void UpdateTransforms();
+
+		/**
+		 * Finds entities whose world bounds intersect the view frustum
+		 * @param visible output vector of indices of the visible entities, valid until an entity is created or destroyed
+		 * @param pv projection view matrix of the frustum
+		 * @param mask entities sharing no flag with the mask are skipped
+		 */
+		void Cull(std::vector<uint32_t>& visible, const glm::mat4& pv, unsigned mask = ALL) const;
+
+		inline size_t Size() const { return m_Models.size(); }
+
+		/**
+		 * Access by index for sweeps over the culled entities
+		 */
+		inline const Model& GetModelAt(uint32_t index) const { return *m_Models[index]; }
+		inline const glm::mat4& GetModelMatrixAt(uint32_t index) const { return m_World[index]; }
+	private:
+		static const uint32_t NONE = 0xffffffffu;
+
+		struct Mover
+		{
+			uint32_t Slot;
+			std::shared_ptr<Spline> Path;
+		};
+
+		/**
+		 * @returns index of the entity, throws when the handle is not alive
+		 */
+		uint32_t IndexOf(Entity entity) const;
+
+		/**
+		 * Orders the entities breadth first from the roots
+		 */
+		void Sort();
+
+		/**
+		 * Rebuilds every array from the given entities in the given order, the others are dropped
+		 * @param order old indices of the kept entities, parents before their children
+		 */
+		void Reorder(const std::vector<uint32_t>& order);
+
+		// transform component, relative to the parent
+		std::vector<glm::vec3> m_Positions;
+		std::vector<glm::mat4> m_Bases;
+		std::vector<uint32_t> m_Parents;
+		std::vector<uint8_t> m_Dirty;
+		std::vector<glm::mat4> m_World;
+
+		// bounds component, box of the model and box of the entity in world space, both as center and half extent
+		std::vector<glm::vec3> m_LocalCenters;
+		std::vector<glm::vec3> m_LocalExtents;
+		std::vector<glm::vec3> m_Centers;
+		std::vector<glm::vec3> m_Extents;
+
+		// render component
+		std::vector<std::shared_ptr<Model>> m_Models;
+		std::vector<unsigned> m_Flags;
+
+		// spline mover component, only few entities have it
+		std::vector<Mover> m_Movers;
+
+		// handles, slot of every entity and index and generation of every slot
+		std::vector<uint32_t> m_IndexSlots;
+		std::vector<uint32_t> m_SlotIndices;
+		std::vector<uint32_t> m_SlotGenerations;
+		std::vector<uint32_t> m_FreeSlots;
+
+		// model boxes, models are shared by many entities
+		std::unordered_map<const Model*, std::pair<glm::vec3, glm::vec3>> m_ModelBounds;
+
+		bool m_Sorted = true;
+	};
+}
@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       HeightGrid.cpp
+ * \author     Richard Kvasnica
+ * \brief      Uniform grid of floor triangles definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "HeightGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace kvasnric
+{
+	const float HeightGrid::MIN_DETERMINANT = 0.0000001f;
+
+	// 2D cross product, the z component of the 3D one
+	static inline float Cross(const glm::vec2& a, const glm::vec2& b)
+	{
+		return a.x * b.y - a.y * b.x;
+	}
+
+	HeightGrid::HeightGrid(const Model& model, float cellSize)
+		: m_Min(0.0f), m_CellSize(1.0f), m_InvCellSize(1.0f), m_Cells(0)
+	{
+		glm::vec2 max(-INFINITY);
+		m_Min = glm::vec2(INFINITY);
+
+		std::vector<glm::vec2> mins, maxs;
+		for (const auto& mesh : model.GetMeshes())
+		{
+			const auto& vertices = mesh->GetVertices();
+			const auto& indices = mesh->GetIndices();
+
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				const glm::vec3& v0 = vertices[indices[i]].Position;
+				const glm::vec3& v1 = vertices[indices[i + 1]].Position;
+				const glm::vec3& v2 = vertices[indices[i + 2]].Position;
+
+				Triangle t;
+				t.Corner = { v0.x, v0.z };
+				t.Edge1 = glm::vec2(v1.x, v1.z) - t.Corner;
+				t.Edge2 = glm::vec2(v2.x, v2.z) - t.Corner;
+
+				const float det = Cross(t.Edge1, t.Edge2);
+				if (std::abs(det) < MIN_DETERMINANT) continue;
+
+				t.InvDeterminant = 1.0f / det;
+				t.Y = v0.y;
+				t.DeltaY1 = v1.y - v0.y;
+				t.DeltaY2 = v2.y - v0.y;
+				m_Triangles.push_back(t);
+
+				mins.push_back(glm::min(glm::min(t.Corner, t.Corner + t.Edge1), t.Corner + t.Edge2));
+				maxs.push_back(glm::max(glm::max(t.Corner, t.Corner + t.Edge1), t.Corner + t.Edge2));
+				m_Min = glm::min(m_Min, mins.back());
+				max = glm::max(max, maxs.back());
+			}
+		}
+
+		if (m_Triangles.empty())
+		{
+			m_Min = glm::vec2(0.0f);
+			m_CellStart.assign(1, 0);
+			return;
+		}
+
+		const glm::vec2 size = glm::max(max - m_Min, glm::vec2(MIN_DETERMINANT));
+		if (cellSize <= 0.0f) cellSize = std::sqrt(size.x * size.y / m_Triangles.size());
+
+		// cells are square, the longer side decides when there would be too many of them
+		cellSize = std::max(cellSize, std::max(size.x, size.y) / MAX_CELLS);
+		m_CellSize = cellSize;
+		m_InvCellSize = 1.0f / cellSize;
+		m_Cells = glm::max(glm::ivec2(glm::ceil(size * m_InvCellSize)), glm::ivec2(1));
+
+		const auto cellOf = [&](const glm::vec2& p)
+		{
+			return glm::clamp(glm::ivec2(glm::floor((p - m_Min) * m_InvCellSize)), glm::ivec2(0), m_Cells - 1);
+		};
+
+		// counting pass finds where the list of each cell starts, the second pass fills the lists
+		m_CellStart.assign(m_Cells.x * m_Cells.y + 1, 0);
+		for (size_t t = 0; t < m_Triangles.size(); ++t)
+		{
+			const glm::ivec2 lo = cellOf(mins[t]), hi = cellOf(maxs[t]);
+			for (int z = lo.y; z <= hi.y; ++z)
+				for (int x = lo.x; x <= hi.x; ++x) ++m_CellStart[z * m_Cells.x + x + 1];
+		}
+		for (size_t i = 1; i < m_CellStart.size(); ++i) m_CellStart[i] += m_CellStart[i - 1];
+
+		std::vector<uint32_t> fill(m_CellStart.begin(), m_CellStart.end() - 1);
+		m_CellTriangles.resize(m_CellStart.back());
+		for (size_t t = 0; t < m_Triangles.size(); ++t)
+		{
+			const glm::ivec2 lo = cellOf(mins[t]), hi = cellOf(maxs[t]);
+			for (int z = lo.y; z <= hi.y; ++z)
+				for (int x = lo.x; x <= hi.x; ++x) m_CellTriangles[fill[z * m_Cells.x + x]++] = (uint32_t) t;
+		}
+	}
+
+	float HeightGrid::HeightAt(const Triangle& triangle, const glm::vec2& point)
+	{
+		// tolerance closes the cracks between neighbouring triangles
+		const float EPS = 0.000001f;
+
+		const glm::vec2 p = point - triangle.Corner;
+		const float u = Cross(p, triangle.Edge2) * triangle.InvDeterminant;
+		const float v = Cross(triangle.Edge1, p) * triangle.InvDeterminant;
+
+		if (u < -EPS || v < -EPS || u + v > 1.0f + EPS) return -INFINITY;
+		return triangle.Y + u * triangle.DeltaY1 + v * triangle.DeltaY2;
+	}
+
+	float HeightGrid::Query(const glm::vec3& position) const
+	{
+		const glm::vec2 point(position.x, position.z);
+		const glm::vec2 cell = glm::floor((point - m_Min) * m_InvCellSize);
+		if (cell.x < 0.0f || cell.y < 0.0f || cell.x >= m_Cells.x || cell.y >= m_Cells.y) return -INFINITY;
+
+		const int i = (int) cell.y * m_Cells.x + (int) cell.x;
+
+		// highest of the triangles under the position, like the closest hit of a ray pointing down
+		float best = -INFINITY;
+		for (uint32_t c = m_CellStart[i]; c < m_CellStart[i + 1]; ++c)
+		{
+			const float h = HeightAt(m_Triangles[m_CellTriangles[c]], point);
+			if (h > best && h < position.y) best = h;
+		}
+		return best;
+	}
+
+	bool HeightGrid::Height(float& height, const glm::vec3& position) const
+	{
+		const float h = Query(position);
+		if (h == -INFINITY) return false;
+
+		height = h;
+		return true;
+	}
+
+	void HeightGrid::Heights(float* heights, const glm::vec3* positions, size_t count) const
+	{
+		for (size_t i = 0; i < count; ++i) heights[i] = Query(positions[i]);
+	}
+}
@@ -0,0 +1,95 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       HeightGrid.hpp
+ * \author     Richard Kvasnica
+ * \brief      Uniform grid of floor triangles declaration
+ *
+ * Floor is split into square cells in the xz plane, each cell lists the triangles overlapping it.
+ * Height below a point is found from the triangles of the one cell the point falls into.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Model.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kvasnric
+{
+	/**
+	 * Answers the same question as a ray shot straight down at the floor: the highest floor point below a position.
+	 * Triangles are taken in model coordinates, the floor object has to have unit model matrix.
+	 */
+	class HeightGrid
+	{
+	public:
+		/**
+		 * Sorts the triangles of all meshes of the model into cells
+		 * @param model floor model
+		 * @param cellSize edge of one cell, zero chooses it so there are about as many cells as triangles
+		 */
+		explicit HeightGrid(const Model& model, float cellSize = 0.0f);
+
+		/**
+		 * Finds the floor under the position
+		 * @param height output parameter of the height of the floor, will be left out if no floor was found
+		 * @param position point the floor is looked for under, its height is exclusive
+		 * @returns bool whether there is a floor under the position
+		 */
+		bool Height(float& height, const glm::vec3& position) const;
+
+		/**
+		 * Finds the floor under many positions at once, like every agent standing on the floor each step
+		 * @param heights output array of the heights, -INFINITY where there is no floor
+		 * @param positions array of the points the floor is looked for under
+		 * @param count number of the positions
+		 */
+		void Heights(float* heights, const glm::vec3* positions, size_t count) const;
+
+		inline glm::ivec2 Cells() const { return m_Cells; }
+		inline float CellSize() const { return m_CellSize; }
+		inline size_t TriangleCount() const { return m_Triangles.size(); }
+	private:
+		// triangle projected on xz with its height as a linear function of the barycentric coordinates
+		struct Triangle
+		{
+			glm::vec2 Corner;
+			glm::vec2 Edge1;
+			glm::vec2 Edge2;
+			float InvDeterminant;
+			float Y;
+			float DeltaY1;
+			float DeltaY2;
+		};
+
+		/**
+		 * @returns height of the triangle above the point, -INFINITY if the point does not lie in it
+		 */
+		static float HeightAt(const Triangle& triangle, const glm::vec2& point);
+
+		/**
+		 * @returns highest floor under the position or -INFINITY, the cell is looked up once
+		 */
+		float Query(const glm::vec3& position) const;
+
+		// triangles whose projection is smaller than this are vertical, a ray straight down never hits them
+		static const float MIN_DETERMINANT;
+
+		// limit of cells per side, very thin floors would get too many cells otherwise
+		static const int MAX_CELLS = 1024;
+
+		glm::vec2 m_Min;
+		float m_CellSize;
+		float m_InvCellSize;
+		glm::ivec2 m_Cells;
+
+		// triangles of cell i are m_CellTriangles[m_CellStart[i]] up to m_CellTriangles[m_CellStart[i + 1]]
+		std::vector<uint32_t> m_CellStart;
+		std::vector<uint32_t> m_CellTriangles;
+		std::vector<Triangle> m_Triangles;
+	};
+}
@@ -8,6 +8,8 @@
 
 #include "Light.hpp"
 
+#include <constants.hpp>
+
 namespace kvasnric
 {
 	Light::Light(const glm::vec3& diffuse, const glm::vec3& specular)
@@ -17,20 +19,39 @@ namespace kvasnric
 
 	PointLight::PointLight(const glm::vec3& pos, const glm::vec3& diffuse, const glm::vec3& specular, const glm::vec3& ambient, float atLinear, float atQuad, float intensity)
 		: Light(diffuse, specular), m_Position(pos), m_Ambient(ambient)
-		, m_AttenuationLinear(atLinear), m_AttenuationQuadratic(atQuad), m_Intensity(intensity)
+		, m_AttenuationLinear(atLinear), m_AttenuationQuadratic(atQuad), m_Intensity(intensity), m_Range(0.0f)
 	{
+		m_Range = GetRange(LIGHT_CUTOFF);
 	}
 
 	PointLight::PointLight(const glm::vec3& pos, const glm::vec3& diffuse, float specular, float ambient, float atLinear, float atQuad, float intensity)
 		: Light(diffuse, glm::vec3(specular)), m_Position(pos), m_Ambient(ambient)
-		, m_AttenuationLinear(atLinear), m_AttenuationQuadratic(atQuad), m_Intensity(intensity)
+		, m_AttenuationLinear(atLinear), m_AttenuationQuadratic(atQuad), m_Intensity(intensity), m_Range(0.0f)
+	{
+		m_Range = GetRange(LIGHT_CUTOFF);
+	}
+
+	float PointLight::GetRange(float threshold) const
 	{
+		const auto maxComponent = [](const glm::vec3& v) { return glm::max(v.x, glm::max(v.y, v.z)); };
+
+		// brightest light the surface can receive before attenuation
+		const float light = maxComponent(m_Diffuse) * (maxComponent(m_Ambient) + m_Intensity + maxComponent(m_Specular));
+
+		// solve quadratic * d^2 + linear * d + 1 = light / threshold
+		const float c = 1.0f - light / threshold;
+		if (c >= 0.0f) return 0.0f;
+		if (m_AttenuationQuadratic <= 0.0f) return m_AttenuationLinear > 0.0f ? -c / m_AttenuationLinear : FAR_PLANE;
+
+		const float discriminant = m_AttenuationLinear * m_AttenuationLinear - 4.0f * m_AttenuationQuadratic * c;
+		return (-m_AttenuationLinear + glm::sqrt(discriminant)) / (2.0f * m_AttenuationQuadratic);
 	}
 
 	SpotLight::SpotLight(const glm::vec3& pos, const glm::vec3& direction, const glm::vec3& diffuse, float specular, float inCutoff, float outCutoff, bool gazePoint)
 		: Light(diffuse, glm::vec3(specular)), m_Position(pos)
 		, m_Direction(gazePoint ? direction - pos : direction)
 		, m_CutOffInner(glm::cos(glm::radians(inCutoff))), m_CutOffOuter(glm::cos(glm::radians(outCutoff)))
+		, m_Range(SPOT_LIGHT_RANGE)
 	{
 	}
 
@@ -38,6 +59,7 @@ namespace kvasnric
 		: Light(diffuse, specular), m_Position(pos)
 		, m_Direction(gazePoint ? glm::normalize(direction - pos) : direction)
 		, m_CutOffInner(glm::cos(glm::radians(inCutoff))), m_CutOffOuter(glm::cos(glm::radians(outCutoff)))
+		, m_Range(SPOT_LIGHT_RANGE)
 	{
 	}
 
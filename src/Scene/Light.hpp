@@ -77,6 +77,7 @@ namespace kvasnric
 			m_AttenuationLinear = linear; m_AttenuationQuadratic = quadratic;
 		}
 		inline void SetIntensity(float intensity) { m_Intensity = intensity; }
+		inline void SetRange(float range) { m_Range = range; }
 
 		// getters
 		inline const glm::vec3& GetPosition() const { return m_Position; }
@@ -86,12 +87,24 @@ namespace kvasnric
 			return glm::vec2(m_AttenuationLinear, m_AttenuationQuadratic);
 		}
 		inline float GetIntensity() const { return m_Intensity; }
+
+		/**
+		 * @returns distance where the light is smoothly faded out. By default where the attenuation drops under LIGHT_CUTOFF
+		 */
+		inline float GetRange() const { return m_Range; }
+
+		/**
+		 * Distance at which the attenuated light of a white surface drops below the threshold
+		 * @param threshold smallest light contribution that is still visible
+		 */
+		float GetRange(float threshold) const;
 	private:
 		glm::vec3 m_Position;
 		glm::vec3 m_Ambient;
 		float m_AttenuationLinear;
 		float m_AttenuationQuadratic;
 		float m_Intensity;
+		float m_Range;
 	};
 
 	// SPOT LIGHT
@@ -124,15 +137,18 @@ namespace kvasnric
 		inline void SetPosition(const glm::vec3& pos) { m_Position = pos; }
 		inline void SetDirection(const glm::vec3& direction) { m_Direction = direction; }
 		inline void SetCutOff(float inner, float outer) { m_CutOffInner = inner; m_CutOffOuter = outer; }
+		inline void SetRange(float range) { m_Range = range; }
 
 		// getters
 		inline const glm::vec3& GetPosition() const { return m_Position; }
 		inline const glm::vec3& GetDirection() const { return m_Direction; }
 		inline glm::vec2 GetCutOff() const { return glm::vec2(m_CutOffInner, m_CutOffOuter); }
+		inline float GetRange() const { return m_Range; }
 	private:
 		glm::vec3 m_Position;
 		glm::vec3 m_Direction;
 		float m_CutOffInner;
 		float m_CutOffOuter;
+		float m_Range;
 	};
 }
\ No newline at end of file
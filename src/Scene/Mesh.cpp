@@ -25,7 +25,7 @@ namespace kvasnric
 
 
 	Mesh::Mesh()
-		: m_VAO(nullptr), m_Material(nullptr), m_Finalized(false)
+		: m_VAO(nullptr), m_PositionVAO(nullptr), m_Material(nullptr), m_Finalized(false)
 	{
 	}
 
@@ -33,7 +33,9 @@ namespace kvasnric
 		: m_Vertices(std::move(x.m_Vertices))
 		, m_Indices(std::move(x.m_Indices))
 		, m_VAO(std::move(x.m_VAO))
+		, m_PositionVAO(std::move(x.m_PositionVAO))
 		, m_Material(std::move(x.m_Material))
+		, m_BVH(std::move(x.m_BVH))
 		, m_Finalized(x.m_Finalized)
 	{
 	}
@@ -44,68 +46,74 @@ namespace kvasnric
 		m_Material->Bind();
 	}
 
+	void Mesh::BindPositions() const
+	{
+		if (m_PositionVAO) m_PositionVAO->Bind();
+		else m_VAO->Bind();
+	}
+
+	void Mesh::BuildBVH()
+	{
+		m_BVH = std::make_unique<MeshBVH>(m_Vertices, m_Indices);
+	}
+
+	void Mesh::RefitBVH()
+	{
+		if (m_BVH) m_BVH->Refit(m_Vertices, m_Indices);
+	}
+
 	bool Mesh::FindIntersection(glm::vec3& out, glm::vec3& normal, const glm::vec3& origin, const glm::vec3& direction) const
 	{
+		MeshBVH::Hit hit;
+		if (!FindClosestHit(hit, origin, direction)) return false;
+
+		out = origin + direction * hit.Distance;
+		normal = m_Vertices[m_Indices[hit.Triangle]].Normal;
+		return true;
+	}
+
+	bool Mesh::FindClosestHit(MeshBVH::Hit& hit, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+	{
+		if (m_BVH) return m_BVH->ClosestHit(hit, origin, direction, maxDistance);
+
 		bool intersects = false;
 		for (unsigned i = 0; i < m_Indices.size(); i+=3)
 		{
-			// give intersection into temp value and check if the new intersection is closer than the already found one. 
-			glm::vec3 temp;
-			if (Intersects(temp, origin, direction, i) && (!intersects || (temp.x*temp.x + temp.y*temp.y + temp.z*temp.z) < (out.x*out.x + out.y*out.y + out.z*out.z)))
+			// check if the new intersection is closer to the origin than the already found one
+			float t;
+			if (MeshBVH::IntersectTriangle(t, m_Vertices[m_Indices[i]].Position, m_Vertices[m_Indices[i + 1]].Position,
+				m_Vertices[m_Indices[i + 2]].Position, origin, direction) && t < maxDistance)
 			{
 				intersects = true;
-				out = temp;
-				normal = m_Vertices[m_Indices[i]].Normal;
+				maxDistance = t;
+				hit = { t, i };
 			}
 		}
 
 		return intersects;
 	}
 
-	// Inspired from wikipedias pseudo-code.
-	bool Mesh::Intersects(glm::vec3& out, const glm::vec3& origin, const glm::vec3& direction, unsigned triangleId) const
+	bool Mesh::IntersectsAny(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
 	{
-		const float EPS = 0.0000001f;
-
-		const glm::vec3& v0 = m_Vertices[m_Indices[triangleId]].Position;
-		const glm::vec3& v1 = m_Vertices[m_Indices[triangleId + 1]].Position;
-		const glm::vec3& v2 = m_Vertices[m_Indices[triangleId + 2]].Position;
-
-		const glm::vec3 edge1 = v1 - v0;
-		const glm::vec3 edge2 = v2 - v0;
-
-		const glm::vec3 h = glm::cross(direction, edge2);
-		const float a = glm::dot(edge1, h);
+		if (m_BVH) return m_BVH->AnyHit(origin, direction, maxDistance);
 
-		// checks whether the two direction vectors are parallel
-		if (a > -EPS && a < EPS) return false;
-
-		const float f = 1.0f / a;
-
-		const glm::vec3 s = origin - v0;
-
-		const float u = f * glm::dot(s, h);
-
-		// direction faces in the opposite way from triangle
-		if (u < 0.0f || u > 1.0f) return false;
-
-		const glm::vec3 q = glm::cross(s, edge1);
-
-		const float v = f * glm::dot(direction, q);
-
-		if (v < 0.0f || u + v > 1.0f) return false;
-
-		const float t = f * glm::dot(edge2, q);
-
-		// ray intersection
-		if (t > EPS)
+		for (unsigned i = 0; i < m_Indices.size(); i += 3)
 		{
-			out = origin + direction * t;
-			return true;
+			float t;
+			if (MeshBVH::IntersectTriangle(t, m_Vertices[m_Indices[i]].Position, m_Vertices[m_Indices[i + 1]].Position,
+				m_Vertices[m_Indices[i + 2]].Position, origin, direction) && t < maxDistance) return true;
 		}
-		
 		return false;
-		
+	}
+
+	bool Mesh::Intersects(glm::vec3& out, const glm::vec3& origin, const glm::vec3& direction, unsigned triangleId) const
+	{
+		float t;
+		if (!MeshBVH::IntersectTriangle(t, m_Vertices[m_Indices[triangleId]].Position, m_Vertices[m_Indices[triangleId + 1]].Position,
+			m_Vertices[m_Indices[triangleId + 2]].Position, origin, direction)) return false;
+
+		out = origin + direction * t;
+		return true;
 	}
 
 	void Mesh::AssignMaterial(std::unique_ptr<Material>&& m) noexcept
@@ -130,15 +138,17 @@ namespace kvasnric
 		m_Indices.emplace_back(v3);
 	}
 
-	void Mesh::RegisterMesh()
+	void Mesh::RegisterMesh(bool positionStream)
 	{
 		m_VAO = std::make_unique<VertexArray>();
 
 		m_VAO->SetVertexBuffer(std::make_unique<VertexBuffer>(
 			m_Vertices.data(), m_Vertices.size() * sizeof(Vertex), DRAW::STATIC));
 
-		m_VAO->SetElementBuffer(std::make_unique<ElementBuffer>(
-			m_Indices.data(), m_Indices.size() << 2, DRAW::STATIC));
+		// position stream indexes the vertices by the same elements
+		const std::shared_ptr<ElementBuffer> ebo = std::make_shared<ElementBuffer>(
+			m_Indices.data(), m_Indices.size() << 2, DRAW::STATIC);
+		m_VAO->SetElementBuffer(ebo);
 
 		m_VAO->EnableVertexAttrib(POSITION_LOC);
 		m_VAO->SetVertexAttribPointer(POSITION_LOC, offsetof(Vertex, Position), sizeof(Vertex));
@@ -152,6 +162,22 @@ namespace kvasnric
 		m_VAO->EnableVertexAttrib(TANGENT_LOC);
 		m_VAO->SetVertexAttribPointer(TANGENT_LOC, offsetof(Vertex, Tangent), sizeof(Vertex));
 
+		if (positionStream)
+		{
+			// depth and stencil passes fetch 12 bytes per vertex instead of the whole interleaved vertex
+			std::vector<glm::vec3> positions;
+			positions.reserve(m_Vertices.size());
+			for (const auto& v : m_Vertices) positions.push_back(v.Position);
+
+			m_PositionVAO = std::make_unique<VertexArray>();
+			m_PositionVAO->SetVertexBuffer(std::make_unique<VertexBuffer>(
+				positions.data(), positions.size() * sizeof(glm::vec3), DRAW::STATIC));
+			m_PositionVAO->SetElementBuffer(ebo);
+
+			m_PositionVAO->EnableVertexAttrib(POSITION_LOC);
+			m_PositionVAO->SetVertexAttribPointer(POSITION_LOC, 0, sizeof(glm::vec3));
+		}
+
 		m_Finalized = true;
 	}
 
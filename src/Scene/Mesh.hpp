@@ -14,6 +14,7 @@
 #include <glm/glm.hpp>
 #include <Renderer/VertexArray.hpp>
 #include "Material.hpp"
+#include "MeshBVH.hpp"
 
 namespace kvasnric
 {
@@ -59,8 +60,9 @@ namespace kvasnric
 
 		/**
 		 * Needs to called every time a mesh is complete. Creates VAO and sends the vertex and elements data into shader.
+		 * @param positionStream also creates tightly packed positions with their own VAO for depth and stencil passes
 		 */
-		void RegisterMesh();
+		void RegisterMesh(bool positionStream = true);
 
 		/**
 		 * Binds this mesh's VAO.
@@ -68,7 +70,25 @@ namespace kvasnric
 		void Bind() const;
 
 		/**
-		 * Goes through all the faces and finds the intersection point with an inputted direction vector.
+		 * Binds VAO with only positions at POSITION_LOC and no material textures.
+		 * Falls back to the full VAO if the mesh was registered without the position stream.
+		 */
+		void BindPositions() const;
+
+		/**
+		 * Builds the bounding volume hierarchy of the faces, intersections then test only the faces near the ray.
+		 * Meshes the game intersects every frame or on every click build it once they are complete.
+		 */
+		void BuildBVH();
+
+		/**
+		 * Fits the hierarchy to the vertices again after they moved, the faces have to stay the same.
+		 */
+		void RefitBVH();
+
+		/**
+		 * Goes through the faces and finds the intersection point with an inputted direction vector.
+		 * Walks the hierarchy when it was built, otherwise tests every face.
 		 * @param out output parameter of resulting intersection point, will be left out if no intersection was found
 		 * @param normal output parameter of intersecting face's normal, will be left out if no intersection was found
 		 * @param origin origin of direction in world coordinates
@@ -77,6 +97,21 @@ namespace kvasnric
 		 */
 		bool FindIntersection(glm::vec3& out, glm::vec3 & normal, const glm::vec3& origin, const glm::vec3& direction) const;
 
+		/**
+		 * Finds the closest intersection like FindIntersection, but gives the ray parameter and the face
+		 * @param hit output parameter of the intersection, will be left out if no intersection was found
+		 * @param maxDistance faces further along the direction are ignored
+		 * @returns bool whether an intersection was found
+		 */
+		bool FindClosestHit(MeshBVH::Hit& hit, const glm::vec3& origin, const glm::vec3& direction, float maxDistance = INFINITY) const;
+
+		/**
+		 * Like FindIntersection, but returns as soon as any face is hit.
+		 * @param maxDistance faces further along the direction are ignored
+		 * @returns bool whether some face is closer than maxDistance
+		 */
+		bool IntersectsAny(const glm::vec3& origin, const glm::vec3& direction, float maxDistance = INFINITY) const;
+
 		/**
 		 * MllerTrumbore intersection algorithm
 		 * @param out output parameter of resulting intersection point, will be left out if no intersection was found
@@ -92,6 +127,9 @@ namespace kvasnric
 		 */
 		inline uint32_t GetCountOfIndices() const { return m_Indices.size(); }
 
+		inline const std::vector<Vertex>& GetVertices() const { return m_Vertices; }
+		inline const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+
 		/**
 		 * @returns A mesh's material
 		 */
@@ -103,7 +141,9 @@ namespace kvasnric
 		std::vector<uint32_t> m_Indices;
 
 		std::unique_ptr<VertexArray> m_VAO;
+		std::unique_ptr<VertexArray> m_PositionVAO;
 		std::unique_ptr<Material> m_Material;
+		std::unique_ptr<MeshBVH> m_BVH;
 
 		bool m_Finalized;
 	};
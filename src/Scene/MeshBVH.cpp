@@ -0,0 +1,343 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshBVH.cpp
+ * \author     Richard Kvasnica
+ * \brief      Bounding volume hierarchy of mesh triangles definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "MeshBVH.hpp"
+#include "Mesh.hpp"
+
+#include <algorithm>
+
+namespace kvasnric
+{
+	// half of the surface area of a box, the heuristic only compares the areas
+	static float HalfArea(const glm::vec3& min, const glm::vec3& max)
+	{
+		const glm::vec3 e = glm::max(max - min, glm::vec3(0.0f));
+		return e.x * e.y + e.y * e.z + e.z * e.x;
+	}
+
+	MeshBVH::MeshBVH(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		const uint32_t count = (uint32_t) indices.size() / 3;
+		if (!count) return;
+
+		// bounds and centroids of the triangles are computed once, the build only reads them
+		std::vector<glm::vec3> centroids(count), mins(count), maxs(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const glm::vec3& v0 = vertices[indices[i * 3]].Position;
+			const glm::vec3& v1 = vertices[indices[i * 3 + 1]].Position;
+			const glm::vec3& v2 = vertices[indices[i * 3 + 2]].Position;
+
+			mins[i] = glm::min(glm::min(v0, v1), v2);
+			maxs[i] = glm::max(glm::max(v0, v1), v2);
+			centroids[i] = (mins[i] + maxs[i]) * 0.5f;
+		}
+
+		std::vector<uint32_t> triangles(count);
+		for (uint32_t i = 0; i < count; ++i) triangles[i] = i;
+
+		// binary tree with leaves of at least one triangle has at most 2n - 1 nodes
+		m_Nodes.reserve(2 * count - 1);
+		m_Nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), count });
+
+		Subdivide(0, 0, triangles, centroids, mins, maxs);
+		m_Nodes.shrink_to_fit();
+
+		// leaves point to the first of their blocks from now on, the blocks hold ids of the first index of the triangles
+		for (auto& tri : triangles) tri *= 3;
+		for (auto& node : m_Nodes)
+		{
+			if (node.Count) node.First = m_Blocks.AddTriangles(triangles.data() + node.First, node.Count, vertices, indices);
+		}
+	}
+
+	void MeshBVH::Subdivide(uint32_t node, unsigned depth, std::vector<uint32_t>& triangles, const std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs)
+	{
+		const uint32_t first = m_Nodes[node].First;
+		const uint32_t count = m_Nodes[node].Count;
+
+		glm::vec3 min(INFINITY), max(-INFINITY), cmin(INFINITY), cmax(-INFINITY);
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const uint32_t tri = triangles[i];
+			min = glm::min(min, mins[tri]);
+			max = glm::max(max, maxs[tri]);
+			cmin = glm::min(cmin, centroids[tri]);
+			cmax = glm::max(cmax, centroids[tri]);
+		}
+		m_Nodes[node].Min = min;
+		m_Nodes[node].Max = max;
+
+		if (count <= MAX_LEAF || depth >= MAX_DEPTH) return;
+
+		// triangles are binned by centroids along each axis and every border between the bins is a split candidate
+		struct Bin
+		{
+			glm::vec3 Min = glm::vec3(INFINITY);
+			glm::vec3 Max = glm::vec3(-INFINITY);
+			uint32_t Count = 0;
+		};
+
+		int bestAxis = -1;
+		unsigned bestSplit = 0;
+		float bestCost = INFINITY;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float extent = cmax[axis] - cmin[axis];
+			if (extent <= 0.0f) continue;
+
+			const float scale = BINS / extent;
+			Bin bins[BINS];
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const uint32_t tri = triangles[i];
+				const unsigned b = std::min(BINS - 1, (unsigned) ((centroids[tri][axis] - cmin[axis]) * scale));
+				bins[b].Min = glm::min(bins[b].Min, mins[tri]);
+				bins[b].Max = glm::max(bins[b].Max, maxs[tri]);
+				++bins[b].Count;
+			}
+
+			// sweep from the right stores the cost of the right side, the sweep from the left adds the left side
+			float rightCost[BINS];
+			glm::vec3 rmin(INFINITY), rmax(-INFINITY);
+			uint32_t rcount = 0;
+			for (unsigned b = BINS - 1; b > 0; --b)
+			{
+				rmin = glm::min(rmin, bins[b].Min);
+				rmax = glm::max(rmax, bins[b].Max);
+				rcount += bins[b].Count;
+				rightCost[b] = rcount ? HalfArea(rmin, rmax) * rcount : 0.0f;
+			}
+
+			glm::vec3 lmin(INFINITY), lmax(-INFINITY);
+			uint32_t lcount = 0;
+			for (unsigned b = 1; b < BINS; ++b)
+			{
+				lmin = glm::min(lmin, bins[b - 1].Min);
+				lmax = glm::max(lmax, bins[b - 1].Max);
+				lcount += bins[b - 1].Count;
+				if (!lcount || lcount == count) continue;
+
+				const float cost = HalfArea(lmin, lmax) * lcount + rightCost[b];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b;
+				}
+			}
+		}
+
+		// splitting costs one box test more, it has to save more triangle tests than that
+		const float area = HalfArea(min, max);
+		if (bestAxis < 0 || (area > 0.0f && 1.0f + bestCost / area >= (float) count)) return;
+
+		const float scale = BINS / (cmax[bestAxis] - cmin[bestAxis]);
+		const auto middle = std::partition(triangles.begin() + first, triangles.begin() + first + count, [&](uint32_t tri)
+		{
+			return std::min(BINS - 1, (unsigned) ((centroids[tri][bestAxis] - cmin[bestAxis]) * scale)) < bestSplit;
+		});
+		const uint32_t leftCount = (uint32_t) (middle - triangles.begin()) - first;
+
+		// children are next to each other, the parent keeps only the index of the left one
+		const uint32_t left = (uint32_t) m_Nodes.size();
+		m_Nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), leftCount });
+		m_Nodes.push_back({ glm::vec3(0.0f), first + leftCount, glm::vec3(0.0f), count - leftCount });
+		m_Nodes[node].First = left;
+		m_Nodes[node].Count = 0;
+
+		Subdivide(left, depth + 1, triangles, centroids, mins, maxs);
+		Subdivide(left + 1, depth + 1, triangles, centroids, mins, maxs);
+	}
+
+	void MeshBVH::FitLeaf(Node& node, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) const
+	{
+		node.Min = glm::vec3(INFINITY);
+		node.Max = glm::vec3(-INFINITY);
+		for (uint32_t b = node.First; b < node.First + TriangleBlocks::BlocksFor(node.Count); ++b)
+		{
+			for (unsigned lane = 0; lane < TriangleBlocks::WIDTH; ++lane)
+			{
+				const uint32_t id = m_Blocks.Triangle(b, lane);
+				if (id == TriangleBlocks::NO_TRIANGLE) break;
+
+				for (uint32_t v = 0; v < 3; ++v)
+				{
+					node.Min = glm::min(node.Min, vertices[indices[id + v]].Position);
+					node.Max = glm::max(node.Max, vertices[indices[id + v]].Position);
+				}
+			}
+		}
+	}
+
+	void MeshBVH::Refit(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		m_Blocks.Update(vertices, indices);
+
+		// children are always stored after their parent, so walking backwards visits them first
+		for (size_t i = m_Nodes.size(); i-- > 0;)
+		{
+			Node& node = m_Nodes[i];
+			if (node.Count)
+			{
+				FitLeaf(node, vertices, indices);
+				continue;
+			}
+
+			const Node& left = m_Nodes[node.First];
+			const Node& right = m_Nodes[node.First + 1];
+			node.Min = glm::min(left.Min, right.Min);
+			node.Max = glm::max(left.Max, right.Max);
+		}
+	}
+
+	float MeshBVH::IntersectBox(const Node& node, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance)
+	{
+		const glm::vec3 t0 = (node.Min - origin) * invDirection;
+		const glm::vec3 t1 = (node.Max - origin) * invDirection;
+		const glm::vec3 tmin = glm::min(t0, t1);
+		const glm::vec3 tmax = glm::max(t0, t1);
+
+		const float enter = std::max(std::max(tmin.x, tmin.y), tmin.z);
+		const float exit = std::min(std::min(tmax.x, tmax.y), tmax.z);
+
+		return exit >= enter && exit > 0.0f && enter < maxDistance ? enter : INFINITY;
+	}
+
+	bool MeshBVH::ClosestHit(Hit& hit, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+	{
+		if (m_Nodes.empty()) return false;
+
+		const glm::vec3 invDirection = 1.0f / direction;
+		if (IntersectBox(m_Nodes[0], origin, invDirection, maxDistance) == INFINITY) return false;
+
+		// pending far children with the distance their box was entered at
+		uint32_t stack[MAX_DEPTH];
+		float entered[MAX_DEPTH];
+		unsigned size = 0;
+
+		bool found = false;
+		uint32_t triangle = 0;
+		uint32_t current = 0;
+		for (;;)
+		{
+			const Node& node = m_Nodes[current];
+			if (node.Count)
+			{
+				// each block shortens maxDistance to its closest hit
+				for (uint32_t b = node.First; b < node.First + TriangleBlocks::BlocksFor(node.Count); ++b)
+				{
+					if (m_Blocks.Intersect(maxDistance, triangle, b, origin, direction)) found = true;
+				}
+			}
+			else
+			{
+				// closer child is visited first, so the far one is often culled by the hit found in the closer one
+				uint32_t closer = node.First, further = node.First + 1;
+				float dCloser = IntersectBox(m_Nodes[closer], origin, invDirection, maxDistance);
+				float dFurther = IntersectBox(m_Nodes[further], origin, invDirection, maxDistance);
+				if (dFurther < dCloser)
+				{
+					std::swap(closer, further);
+					std::swap(dCloser, dFurther);
+				}
+
+				if (dCloser != INFINITY)
+				{
+					if (dFurther != INFINITY)
+					{
+						stack[size] = further;
+						entered[size++] = dFurther;
+					}
+					current = closer;
+					continue;
+				}
+			}
+
+			// pending nodes entered behind the closest hit cannot hold a closer one
+			while (size && entered[size - 1] >= maxDistance) --size;
+			if (!size) break;
+			current = stack[--size];
+		}
+
+		if (found) hit = { maxDistance, triangle };
+		return found;
+	}
+
+	bool MeshBVH::AnyHit(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+	{
+		if (m_Nodes.empty()) return false;
+
+		const glm::vec3 invDirection = 1.0f / direction;
+
+		uint32_t stack[MAX_DEPTH + 1];
+		unsigned size = 0;
+		stack[size++] = 0;
+
+		// order does not matter, the first intersection ends the query
+		while (size)
+		{
+			const Node& node = m_Nodes[stack[--size]];
+			if (IntersectBox(node, origin, invDirection, maxDistance) == INFINITY) continue;
+
+			if (!node.Count)
+			{
+				stack[size++] = node.First + 1;
+				stack[size++] = node.First;
+				continue;
+			}
+
+			float t[TriangleBlocks::WIDTH];
+			for (uint32_t b = node.First; b < node.First + TriangleBlocks::BlocksFor(node.Count); ++b)
+			{
+				if (m_Blocks.IntersectLanes(t, b, origin, direction, maxDistance)) return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Inspired from wikipedias pseudo-code.
+	bool MeshBVH::IntersectTriangle(float& t, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2,
+		const glm::vec3& origin, const glm::vec3& direction)
+	{
+		const float EPS = 0.0000001f;
+
+		const glm::vec3 edge1 = v1 - v0;
+		const glm::vec3 edge2 = v2 - v0;
+
+		const glm::vec3 h = glm::cross(direction, edge2);
+		const float a = glm::dot(edge1, h);
+
+		// checks whether the two direction vectors are parallel
+		if (a > -EPS && a < EPS) return false;
+
+		const float f = 1.0f / a;
+
+		const glm::vec3 s = origin - v0;
+
+		const float u = f * glm::dot(s, h);
+
+		// direction faces in the opposite way from triangle
+		if (u < 0.0f || u > 1.0f) return false;
+
+		const glm::vec3 q = glm::cross(s, edge1);
+
+		const float v = f * glm::dot(direction, q);
+
+		if (v < 0.0f || u + v > 1.0f) return false;
+
+		// ray intersection
+		const float d = f * glm::dot(edge2, q);
+		if (d <= EPS) return false;
+
+		t = d;
+		return true;
+	}
+}
@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshBVH.hpp
+ * \author     Richard Kvasnica
+ * \brief      Bounding volume hierarchy of mesh triangles declaration
+ *
+ * Binary tree of axis aligned boxes built with the surface area heuristic, a ray visits
+ * only the boxes it passes through, so a query costs about log of the triangle count.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "TriangleBlocks.hpp"
+
+namespace kvasnric
+{
+	struct Vertex;
+
+	/**
+	 * Hierarchy over the triangles of one mesh. Leaves keep copies of their triangles in simd blocks, so queries
+	 * do not touch the mesh, the vertices and indices are passed only to the build and the refit.
+	 */
+	class MeshBVH
+	{
+	public:
+		// closest intersection of a ray
+		struct Hit
+		{
+			float Distance;			// ray parameter, world distance when the direction is normalized
+			unsigned Triangle;		// id of the first index of the triangle in elements vector
+		};
+
+		/**
+		 * Builds the hierarchy by binned surface area heuristic
+		 * @param vertices vertices of the mesh
+		 * @param indices elements of the mesh, three per triangle
+		 */
+		MeshBVH(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+		/**
+		 * Recomputes the blocks and boxes of all nodes bottom up after the vertices moved. The tree keeps its topology,
+		 * so it degrades when the triangles move far from each other, build a new one then.
+		 */
+		void Refit(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+		/**
+		 * Finds the intersection closest to the ray origin
+		 * @param maxDistance intersections further along the ray are ignored
+		 * @returns bool whether an intersection was found
+		 */
+		bool ClosestHit(Hit& hit, const glm::vec3& origin, const glm::vec3& direction, float maxDistance = INFINITY) const;
+
+		/**
+		 * Stops at the first intersection found, for visibility and occlusion queries
+		 * @param maxDistance intersections further along the ray are ignored
+		 * @returns bool whether any intersection closer than maxDistance exists
+		 */
+		bool AnyHit(const glm::vec3& origin, const glm::vec3& direction, float maxDistance = INFINITY) const;
+
+		/**
+		 * Moller-Trumbore intersection algorithm, the same test as Mesh::Intersects
+		 * @param t output parameter of the ray parameter of the intersection, will be left out if no intersection was found
+		 * @returns bool whether the ray intersects the triangle in front of its origin
+		 */
+		static bool IntersectTriangle(float& t, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2,
+			const glm::vec3& origin, const glm::vec3& direction);
+
+		inline size_t NodeCount() const { return m_Nodes.size(); }
+	private:
+		// 32 bytes, two nodes per cache line. Leaf has Count > 0 triangles starting in block First,
+		// inner node has Count == 0 and its children are at First and First + 1.
+		struct Node
+		{
+			glm::vec3 Min;
+			uint32_t First;
+			glm::vec3 Max;
+			uint32_t Count;
+		};
+
+		void Subdivide(uint32_t node, unsigned depth, std::vector<uint32_t>& triangles, const std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs);
+		void FitLeaf(Node& node, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) const;
+
+		/**
+		 * Slab test
+		 * @returns ray parameter where the ray enters the box, INFINITY if it misses it or enters it after maxDistance
+		 */
+		static float IntersectBox(const Node& node, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance);
+
+		// split candidates evaluated per axis, nodes with at most MAX_LEAF triangles are not split,
+		// a leaf fills at least one block of the intersection kernel
+		static const unsigned BINS = 12;
+		static const unsigned MAX_LEAF = TriangleBlocks::WIDTH > 4 ? TriangleBlocks::WIDTH : 4;
+
+		// traversal keeps at most one pending node per level, the build stops splitting at this depth
+		static const unsigned MAX_DEPTH = 64;
+
+		std::vector<Node> m_Nodes;
+		TriangleBlocks m_Blocks;
+	};
+}
@@ -15,4 +15,9 @@ namespace kvasnric
 		m_Meshes.emplace_back(std::make_unique<Mesh>());
 		return *m_Meshes.back();
 	}
+
+	void Model::BuildBVH()
+	{
+		for (auto& mesh : m_Meshes) mesh->BuildBVH();
+	}
 }
\ No newline at end of file
@@ -34,6 +34,11 @@ namespace kvasnric
 		 */
 		inline void AddMesh(Mesh&& m) { m_Meshes.emplace_back(std::make_unique<Mesh>(std::move(m))); }
 		Mesh& NewMesh();
+
+		/**
+		 * Builds the bounding volume hierarchy of every mesh, for models the game intersects rays with.
+		 */
+		void BuildBVH();
 	protected:
 		std::vector<std::unique_ptr<Mesh>> m_Meshes;
 		std::string m_Directory;
@@ -15,6 +15,27 @@ namespace kvasnric
 	PortalWalls::PortalWalls(std::shared_ptr<Texture2D> diffuse, std::shared_ptr<Texture2D> specular, std::shared_ptr<Texture2D> normal, std::shared_ptr<Texture2D> rough, std::shared_ptr<Texture2D> ao)
 	{
 		auto mesh = Mesh();
+		CreateGeometry(mesh);
+
+		auto mat = std::make_unique<Material>();
+
+		mat->SetDiffuse(std::move(diffuse));
+		mat->SetSpecular(std::move(specular));
+		mat->SetNormal(std::move(normal));
+		mat->SetRoughness(std::move(rough));
+		mat->SetOcclusion(std::move(ao));
+
+		mesh.AssignMaterial(std::move(mat));
+		mesh.RegisterMesh();
+
+		// every click shoots a ray against the walls
+		mesh.BuildBVH();
+		AddMesh(std::move(mesh));
+		m_Mesh = m_Meshes.back().get();
+	}
+
+	void PortalWalls::CreateGeometry(Mesh& mesh)
+	{
 		const int vertCnt = 52;
 
 		const float verts[vertCnt * 11] = { // positions, normals, texcoords, tangents
@@ -126,19 +147,6 @@ namespace kvasnric
 		{
 			mesh.AddFace(indices[i], indices[i + 1], indices[i + 2]);
 		}
-		
-		auto mat = std::make_unique<Material>();
-
-		mat->SetDiffuse(std::move(diffuse));
-		mat->SetSpecular(std::move(specular));
-		mat->SetNormal(std::move(normal));
-		mat->SetRoughness(std::move(rough));
-		mat->SetOcclusion(std::move(ao));
-
-		mesh.AssignMaterial(std::move(mat));
-		mesh.RegisterMesh();
-		AddMesh(std::move(mesh));
-		m_Mesh = m_Meshes.back().get();
 	}
 
 }
@@ -21,6 +21,12 @@ namespace kvasnric
 		 * Constructs Portal Walls with different types of material properties 
 		 */
 		PortalWalls( std::shared_ptr<Texture2D> diffuse, std::shared_ptr<Texture2D> specular, std::shared_ptr<Texture2D> normal, std::shared_ptr<Texture2D> rough, std::shared_ptr<Texture2D> ao );
+
+		/**
+		 * Fills the vertices and faces of the walls. The mesh is neither registered nor given a material,
+		 * so it can be used for intersections without an opengl context.
+		 */
+		static void CreateGeometry(Mesh& mesh);
 	private:
 		Mesh * m_Mesh;
 	};
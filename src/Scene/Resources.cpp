@@ -13,6 +13,8 @@
 
 #include "pgr.h"
 
+#include <Renderer/ProgramCache.hpp>
+
 namespace kvasnric
 {
 	void Resources::LoadModels(const std::vector<std::string>& files)
@@ -41,6 +43,51 @@ namespace kvasnric
 		m_StencilStamp.reset(new StencilStamp());
 	}
 
+	void Resources::PrefetchShaders()
+	{
+		// vertex and fragment stage of every program loaded by the application. Entity sources without any define
+		// are the variant compiled on load, the others depend on the models and are prefetched by PrefetchVariants
+		const std::pair<const char*, const char*> programs[] = {
+			{ "entity", "entity" },
+			{ "entity", "gbuffer" },
+			{ "depth", "depth" },
+			{ "cubemap", "cubemap" },
+			{ "portalTex", "portalTex" },
+			{ "portalView", "portalView" },
+			{ "stencilStamp", "stencilStamp" },
+			{ "menu", "menu" },
+			{ "screen", "screen" },
+			{ "screen", "deferredLighting" },
+			{ "screen", "overlay" },
+			{ "lightVolume", "lightVolume" }
+		};
+
+		for (const auto& p : programs)
+		{
+			ProgramCache::Prefetch(
+				ShaderProgram::ReadShaderFromFile("res/shaders/" + std::string(p.first) + ".vert"),
+				ShaderProgram::ReadShaderFromFile("res/shaders/" + std::string(p.second) + ".frag"));
+		}
+	}
+
+	void Resources::PrefetchVariants(const Model& m) const
+	{
+		for (const auto& mesh : m.GetMeshes())
+		{
+			const unsigned features = EntityShader::Features(mesh->GetMaterial());
+			m_Entity->Prefetch(features);
+			m_Geometry->Prefetch(features);
+		}
+	}
+
+	void Resources::PrefetchVariants() const
+	{
+		for (const auto& model : m_Models)
+		{
+			PrefetchVariants(*model.second);
+		}
+	}
+
 	void Resources::LoadShader(const std::string& file)
 	{
 		const auto vsSrc = ShaderProgram::ReadShaderFromFile("res/shaders/" + file + ".vert");
@@ -55,11 +102,37 @@ namespace kvasnric
 		const auto fsSrc = ShaderProgram::ReadShaderFromFile("res/shaders/entity.frag");
 
 		m_Entity.reset(new EntityShader(vsSrc, fsSrc));
+
+		// both opaque paths share the position only shader of the depth pre-pass
+		m_Depth.reset(new DepthShader());
+		m_Entity->SetDepthShader(m_Depth.get());
 	}
 
 	void Resources::LoadPortals()
 	{
 		m_PortalTexture.reset(new PortalTextureShader());
+		m_PortalView.reset(new PortalViewShader());
+	}
+
+	void Resources::LoadDeferred()
+	{
+		// geometry pass shares the vertex stage and uniforms with the entity shader, only writes surfaces instead of light
+		const auto vsSrc = ShaderProgram::ReadShaderFromFile("res/shaders/entity.vert");
+		const auto fsSrc = ShaderProgram::ReadShaderFromFile("res/shaders/gbuffer.frag");
+
+		m_Geometry.reset(new EntityShader(vsSrc, fsSrc));
+		m_Geometry->SetDepthShader(m_Depth.get());
+
+		m_DeferredLighting.reset(new DeferredLightingShader());
+		m_LightVolume.reset(new LightVolumeShader());
+		m_Screen.reset(new ScreenShader());
+	}
+
+	void Resources::LoadLightClusters(int width, int height)
+	{
+		// lights of the scene are shaded by the entity shader, which has to be loaded first
+		m_Lights.reset(new LightClusters(width, height));
+		m_Entity->SetLightClusters(m_Lights.get());
 	}
 
 	std::shared_ptr<Model> Resources::operator[](const std::string& name)
@@ -219,12 +292,17 @@ namespace kvasnric
 	}
 
 	std::shared_ptr<Texture2D> Resources::GetTexture(const std::string& name, Texture2D::TYPE type)
+	{
+		return GetTexture(name, type, Texture::IsColor(type));
+	}
+
+	std::shared_ptr<Texture2D> Resources::GetTexture(const std::string& name, Texture2D::TYPE type, bool srgb)
 	{
 		const auto it = m_Textures.find(name);
 
 		if (it == m_Textures.end())
 		{
-			return m_Textures.insert({ name, std::make_shared<Texture2D>(name, type) }).first->second;
+			return m_Textures.insert({ name, std::make_shared<Texture2D>(name, type, srgb) }).first->second;
 		}
 
 		return it->second;
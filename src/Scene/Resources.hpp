@@ -13,7 +13,12 @@
 #include <Renderer/EntityShader.hpp>
 #include <Scene/Cubemap.hpp>
 #include <Renderer/PortalTextureShader.hpp>
+#include <Renderer/PortalViewShader.hpp>
 #include <Renderer/StencilStamp.hpp>
+#include <Renderer/DepthShader.hpp>
+#include <Renderer/DeferredLightingShader.hpp>
+#include <Renderer/LightVolumeShader.hpp>
+#include <Renderer/ScreenShader.hpp>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -27,6 +32,20 @@ namespace kvasnric
 		Resources() = default;
 		~Resources() = default;
 
+		// Starts compiling every shader program of the application at once, later loads only pick them up
+		static void PrefetchShaders();
+
+		/**
+		 * Starts compiling the entity and geometry variants of every material of the model, with and without fog.
+		 * Entity shaders have to be loaded already.
+		 */
+		void PrefetchVariants(const Model& m) const;
+
+		/**
+		 * Same as above for every model loaded so far
+		 */
+		void PrefetchVariants() const;
+
 		// Loads different types of shader programs
 		void LoadShader(const std::string& file);
 		void LoadEntityShader();
@@ -35,6 +54,8 @@ namespace kvasnric
 		void LoadCubeMapShader();
 		void LoadStencilStampTester();
 		void LoadPortals();
+		void LoadDeferred();
+		void LoadLightClusters(int width, int height);
 
 		/**
 		 * If the model is already loaded it returns it from the unordered map od models
@@ -47,13 +68,25 @@ namespace kvasnric
 		 */
 		std::shared_ptr<Texture2D> GetTexture(const std::string& name, Texture2D::TYPE type );
 
+		/**
+		 * Same as above, with the color space given explicitly for textures bound to a slot of another type.
+		 */
+		std::shared_ptr<Texture2D> GetTexture(const std::string& name, Texture2D::TYPE type, bool srgb);
+
 		// Shader getters
 		inline EntityShader& Entity() const { return *m_Entity; }
 		inline ShaderProgram& Shader() const { return *m_Shader; }
 		inline CubeMap& Cubemap() const { return *m_CubeMap; }
 		inline CubeMapShader& CubemapShader() const { return *m_CubeMapShader; }
 		inline PortalTextureShader& PortalTexture() const { return *m_PortalTexture; }
+		inline PortalViewShader& PortalView() const { return *m_PortalView; }
 		inline StencilStamp& Stencil() const { return *m_StencilStamp; }
+		inline EntityShader& Geometry() const { return *m_Geometry; }
+		inline DeferredLightingShader& DeferredLighting() const { return *m_DeferredLighting; }
+		inline LightVolumeShader& LightVolume() const { return *m_LightVolume; }
+		inline ScreenShader& Screen() const { return *m_Screen; }
+		inline LightClusters& Lights() const { return *m_Lights; }
+		inline DepthShader& Depth() const { return *m_Depth; }
 	private:
 		/**
 		 * Constructs a new Model by loading it and returns its pointer.
@@ -91,9 +124,16 @@ namespace kvasnric
 		std::unique_ptr<CubeMap> m_CubeMap;
 		std::unique_ptr<ShaderProgram> m_Shader;
 		std::unique_ptr<CubeMapShader> m_CubeMapShader;
+		std::unique_ptr<DepthShader> m_Depth;
 		std::unique_ptr<EntityShader> m_Entity;
 		std::unique_ptr<PortalTextureShader> m_PortalTexture;
+		std::unique_ptr<PortalViewShader> m_PortalView;
 		std::unique_ptr<StencilStamp> m_StencilStamp;
+		std::unique_ptr<EntityShader> m_Geometry;
+		std::unique_ptr<DeferredLightingShader> m_DeferredLighting;
+		std::unique_ptr<LightVolumeShader> m_LightVolume;
+		std::unique_ptr<ScreenShader> m_Screen;
+		std::unique_ptr<LightClusters> m_Lights;
 		
 	};
 }
@@ -0,0 +1,330 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       SceneRaycast.cpp
+ * \author     Richard Kvasnica
+ * \brief      Scene level ray queries definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "SceneRaycast.hpp"
+
+#include <JobSystem.hpp>
+
+#include <algorithm>
+
+namespace kvasnric
+{
+	/**
+	 * Slab test
+	 * @returns ray parameter where the ray enters the box, INFINITY if it misses it or enters it after maxDistance
+	 */
+	static float IntersectBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance)
+	{
+		const glm::vec3 t0 = (min - origin) * invDirection;
+		const glm::vec3 t1 = (max - origin) * invDirection;
+		const glm::vec3 tmin = glm::min(t0, t1);
+		const glm::vec3 tmax = glm::max(t0, t1);
+
+		const float enter = std::max(std::max(tmin.x, tmin.y), tmin.z);
+		const float exit = std::min(std::min(tmax.x, tmax.y), tmax.z);
+
+		return exit >= enter && exit > 0.0f && enter < maxDistance ? enter : INFINITY;
+	}
+
+	unsigned SceneRaycast::Add(const GameObject& object, unsigned layers)
+	{
+		const unsigned id = Add(object.GetModel(), object.GetModelMatrix(), layers);
+		m_Instances.back().Object = &object;
+		return id;
+	}
+
+	unsigned SceneRaycast::Add(const EntityStore& store, Entity entity, unsigned layers)
+	{
+		const unsigned id = Add(store.GetModel(entity), store.GetModelMatrix(entity), layers);
+		m_Instances.back().Store = &store;
+		m_Instances.back().Owner = entity;
+		return id;
+	}
+
+	unsigned SceneRaycast::Add(const Model& model, const glm::mat4& matrix, unsigned layers)
+	{
+		Instance instance;
+		instance.Geometry = &model;
+		instance.Object = nullptr;
+		instance.Store = nullptr;
+		instance.Layers = layers;
+		instance.LocalMin = glm::vec3(INFINITY);
+		instance.LocalMax = glm::vec3(-INFINITY);
+
+		for (const auto& mesh : model.GetMeshes())
+		{
+			for (const auto& v : mesh->GetVertices())
+			{
+				instance.LocalMin = glm::min(instance.LocalMin, v.Position);
+				instance.LocalMax = glm::max(instance.LocalMax, v.Position);
+			}
+		}
+
+		Place(instance, matrix);
+		m_Instances.push_back(instance);
+		return (unsigned) m_Instances.size() - 1;
+	}
+
+	void SceneRaycast::Place(Instance& instance, const glm::mat4& matrix) const
+	{
+		instance.Matrix = matrix;
+		instance.Inverse = glm::inverse(matrix);
+		instance.Min = glm::vec3(INFINITY);
+		instance.Max = glm::vec3(-INFINITY);
+
+		// model without vertices keeps an empty box, no ray enters it
+		if (instance.LocalMin.x > instance.LocalMax.x) return;
+
+		// world box encloses all eight transformed corners of the model box
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 local(
+				corner & 1 ? instance.LocalMax.x : instance.LocalMin.x,
+				corner & 2 ? instance.LocalMax.y : instance.LocalMin.y,
+				corner & 4 ? instance.LocalMax.z : instance.LocalMin.z);
+			const glm::vec3 world(matrix * glm::vec4(local, 1.0f));
+			instance.Min = glm::min(instance.Min, world);
+			instance.Max = glm::max(instance.Max, world);
+		}
+	}
+
+	void SceneRaycast::Build()
+	{
+		m_Order.resize(m_Instances.size());
+		for (uint32_t i = 0; i < m_Order.size(); ++i) m_Order[i] = i;
+
+		m_Nodes.clear();
+		if (m_Instances.empty()) return;
+
+		m_Nodes.reserve(2 * m_Instances.size() - 1);
+		m_Nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), (uint32_t) m_Instances.size(), 0 });
+		Subdivide(0);
+	}
+
+	void SceneRaycast::FitNode(Node& node) const
+	{
+		node.Min = glm::vec3(INFINITY);
+		node.Max = glm::vec3(-INFINITY);
+		node.Layers = 0;
+
+		if (node.Count)
+		{
+			for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+			{
+				const Instance& instance = m_Instances[m_Order[i]];
+				node.Min = glm::min(node.Min, instance.Min);
+				node.Max = glm::max(node.Max, instance.Max);
+				node.Layers |= instance.Layers;
+			}
+			return;
+		}
+
+		for (uint32_t child = node.First; child < node.First + 2; ++child)
+		{
+			node.Min = glm::min(node.Min, m_Nodes[child].Min);
+			node.Max = glm::max(node.Max, m_Nodes[child].Max);
+			node.Layers |= m_Nodes[child].Layers;
+		}
+	}
+
+	void SceneRaycast::Subdivide(uint32_t node)
+	{
+		const uint32_t first = m_Nodes[node].First;
+		const uint32_t count = m_Nodes[node].Count;
+
+		if (count <= MAX_LEAF)
+		{
+			FitNode(m_Nodes[node]);
+			return;
+		}
+
+		// median split along the longest axis of the centers, instances are few and boxes overlap a lot anyway
+		glm::vec3 cmin(INFINITY), cmax(-INFINITY);
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const Instance& instance = m_Instances[m_Order[i]];
+			cmin = glm::min(cmin, (instance.Min + instance.Max) * 0.5f);
+			cmax = glm::max(cmax, (instance.Min + instance.Max) * 0.5f);
+		}
+
+		const glm::vec3 extent = cmax - cmin;
+		const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+		const auto begin = m_Order.begin() + first;
+		std::nth_element(begin, begin + count / 2, begin + count, [&](uint32_t a, uint32_t b)
+		{
+			return m_Instances[a].Min[axis] + m_Instances[a].Max[axis] < m_Instances[b].Min[axis] + m_Instances[b].Max[axis];
+		});
+
+		const uint32_t left = (uint32_t) m_Nodes.size();
+		m_Nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), count / 2, 0 });
+		m_Nodes.push_back({ glm::vec3(0.0f), first + count / 2, glm::vec3(0.0f), count - count / 2, 0 });
+		m_Nodes[node].First = left;
+		m_Nodes[node].Count = 0;
+
+		Subdivide(left);
+		Subdivide(left + 1);
+		FitNode(m_Nodes[node]);
+	}
+
+	void SceneRaycast::Refit()
+	{
+		for (auto& instance : m_Instances)
+		{
+			if (instance.Object) Place(instance, instance.Object->GetModelMatrix());
+			else if (instance.Store && instance.Store->IsAlive(instance.Owner)) Place(instance, instance.Store->GetModelMatrix(instance.Owner));
+		}
+
+		// children are always stored after their parent, so walking backwards visits them first
+		for (size_t i = m_Nodes.size(); i-- > 0;) FitNode(m_Nodes[i]);
+	}
+
+	bool SceneRaycast::IntersectInstance(Hit& hit, uint32_t id, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, bool anyHit) const
+	{
+		const Instance& instance = m_Instances[id];
+
+		// affine transformation keeps the ray parameter, the model space direction is left unnormalized on purpose
+		const glm::vec3 localOrigin(instance.Inverse * glm::vec4(origin, 1.0f));
+		const glm::vec3 localDirection(instance.Inverse * glm::vec4(direction, 0.0f));
+
+		bool found = false;
+		for (const auto& mesh : instance.Geometry->GetMeshes())
+		{
+			if (anyHit)
+			{
+				if (mesh->IntersectsAny(localOrigin, localDirection, maxDistance)) return true;
+				continue;
+			}
+
+			MeshBVH::Hit local;
+			if (!mesh->FindClosestHit(local, localOrigin, localDirection, maxDistance)) continue;
+
+			maxDistance = local.Distance;
+			found = true;
+
+			const glm::vec3& normal = mesh->GetVertices()[mesh->GetIndices()[local.Triangle]].Normal;
+			hit.Distance = local.Distance;
+			hit.Position = origin + direction * local.Distance;
+			hit.Normal = glm::normalize(glm::transpose(glm::mat3(instance.Inverse)) * normal);
+			hit.Instance = id;
+			hit.Object = instance.Object;
+			hit.Owner = instance.Owner;
+			hit.Part = mesh.get();
+			hit.Triangle = local.Triangle;
+		}
+
+		return found;
+	}
+
+	template <bool ANY_HIT>
+	bool SceneRaycast::Traverse(Hit& hit, const glm::vec3& origin, const glm::vec3& direction, unsigned mask, float maxDistance) const
+	{
+		if (m_Nodes.empty() || !(m_Nodes[0].Layers & mask)) return false;
+
+		const glm::vec3 invDirection = 1.0f / direction;
+
+		// pending nodes with the distance their box was entered at
+		uint32_t stack[MAX_DEPTH + 1];
+		float entered[MAX_DEPTH + 1];
+		unsigned size = 0;
+
+		stack[size] = 0;
+		entered[size++] = IntersectBox(m_Nodes[0].Min, m_Nodes[0].Max, origin, invDirection, maxDistance);
+
+		bool found = false;
+		while (size)
+		{
+			--size;
+			// closer hit found since the node was pushed may already cover it
+			if (entered[size] >= maxDistance) continue;
+			const Node& node = m_Nodes[stack[size]];
+
+			if (!node.Count)
+			{
+				// closer child is popped first, so its hit can cull the other one
+				uint32_t closer = node.First, further = node.First + 1;
+				float dCloser = m_Nodes[closer].Layers & mask ? IntersectBox(m_Nodes[closer].Min, m_Nodes[closer].Max, origin, invDirection, maxDistance) : INFINITY;
+				float dFurther = m_Nodes[further].Layers & mask ? IntersectBox(m_Nodes[further].Min, m_Nodes[further].Max, origin, invDirection, maxDistance) : INFINITY;
+				if (dFurther < dCloser)
+				{
+					std::swap(closer, further);
+					std::swap(dCloser, dFurther);
+				}
+
+				if (dFurther != INFINITY)
+				{
+					stack[size] = further;
+					entered[size++] = dFurther;
+				}
+				if (dCloser != INFINITY)
+				{
+					stack[size] = closer;
+					entered[size++] = dCloser;
+				}
+				continue;
+			}
+
+			for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+			{
+				const uint32_t id = m_Order[i];
+				const Instance& instance = m_Instances[id];
+				if (!(instance.Layers & mask) || IntersectBox(instance.Min, instance.Max, origin, invDirection, maxDistance) == INFINITY) continue;
+
+				if (IntersectInstance(hit, id, origin, direction, maxDistance, ANY_HIT))
+				{
+					if (ANY_HIT) return true;
+					maxDistance = hit.Distance;
+					found = true;
+				}
+			}
+		}
+
+		return found;
+	}
+
+	bool SceneRaycast::Raycast(Hit& hit, const glm::vec3& origin, const glm::vec3& direction, unsigned mask, float maxDistance) const
+	{
+		return Traverse<false>(hit, origin, direction, mask, maxDistance);
+	}
+
+	bool SceneRaycast::Occluded(const glm::vec3& origin, const glm::vec3& direction, unsigned mask, float maxDistance) const
+	{
+		Hit unused;
+		return Traverse<true>(unused, origin, direction, mask, maxDistance);
+	}
+
+	void SceneRaycast::RaycastBatch(Hit* hits, const Ray* rays, size_t count, unsigned mask, JobSystem* jobs) const
+	{
+		// queries only read the scene, every packet writes its own range of hits
+		const auto packet = [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (!Traverse<false>(hits[i], rays[i].Origin, rays[i].Direction, mask, rays[i].MaxDistance)) hits[i].Distance = INFINITY;
+			}
+		};
+
+		if (jobs) jobs->ParallelFor(count, PACKET, packet);
+		else packet(0, count);
+	}
+
+	void SceneRaycast::OccludedBatch(uint8_t* occluded, const Ray* rays, size_t count, unsigned mask, JobSystem* jobs) const
+	{
+		const auto packet = [&](size_t begin, size_t end)
+		{
+			Hit unused;
+			for (size_t i = begin; i < end; ++i)
+			{
+				occluded[i] = Traverse<true>(unused, rays[i].Origin, rays[i].Direction, mask, rays[i].MaxDistance) ? 1 : 0;
+			}
+		};
+
+		if (jobs) jobs->ParallelFor(count, PACKET, packet);
+		else packet(0, count);
+	}
+}
@@ -0,0 +1,179 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       SceneRaycast.hpp
+ * \author     Richard Kvasnica
+ * \brief      Scene level ray queries declaration
+ *
+ * Two level acceleration structure. The top level is a hierarchy of world bounds of the instances,
+ * each instance casts the ray into the mesh hierarchies of its model through its inverse model matrix.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "GameObject.hpp"
+#include "EntityStore.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kvasnric
+{
+	class JobSystem;
+
+	class SceneRaycast
+	{
+	public:
+		// what an instance is for, queries pass a mask of the layers they want to hit
+		enum LAYER : unsigned
+		{
+			SOLID = 1 << 0,
+			FLOOR = 1 << 1,
+			PORTAL_CONDUCTIVE = 1 << 2,
+			PICKABLE = 1 << 3,
+			ALL = 0xffffffffu
+		};
+
+		// closest intersection in world coordinates
+		struct Hit
+		{
+			float Distance;				// ray parameter, world distance when the direction is normalized
+			glm::vec3 Position;
+			glm::vec3 Normal;			// normal of the first vertex of the face in world coordinates, normalized
+			unsigned Instance;			// id returned by Add
+			const GameObject* Object;	// object of the instance, nullptr for models added with a fixed matrix
+			Entity Owner;				// entity of the instance, default handle for the others
+			const Mesh* Part;			// mesh of the model the face belongs to
+			unsigned Triangle;			// id of the first index of the face in elements vector of the mesh
+		};
+
+		// one ray of a batch
+		struct Ray
+		{
+			glm::vec3 Origin;
+			glm::vec3 Direction;
+			float MaxDistance;
+		};
+
+		// consecutive rays one thread takes at once, callers generating coherent rays next to each other keep them together
+		static const size_t PACKET = 64;
+
+		SceneRaycast() = default;
+
+		/**
+		 * Adds an object whose model matrix is read again by every Refit. The object has to outlive the scene
+		 * and stay at the same address. Meshes of its model should have their hierarchy built.
+		 * @param layers bit mask of LAYER values
+		 * @returns id of the instance
+		 */
+		unsigned Add(const GameObject& object, unsigned layers);
+
+		/**
+		 * Adds an entity whose model matrix is read again by every Refit, destroyed entities stay where they were last.
+		 * The store has to outlive the scene.
+		 * @param layers bit mask of LAYER values
+		 * @returns id of the instance
+		 */
+		unsigned Add(const EntityStore& store, Entity entity, unsigned layers);
+
+		/**
+		 * Adds a model which never moves
+		 * @param model model placed in the world, it has to outlive the scene
+		 * @param matrix model matrix from model space to world space
+		 * @param layers bit mask of LAYER values
+		 * @returns id of the instance
+		 */
+		unsigned Add(const Model& model, const glm::mat4& matrix, unsigned layers);
+
+		/**
+		 * Builds the top level hierarchy, has to be called after the instances were added
+		 */
+		void Build();
+
+		/**
+		 * Reads model matrices of the objects and entities again and fits the boxes of the top level to them
+		 */
+		void Refit();
+
+		/**
+		 * Finds the closest intersection with the instances of the given layers
+		 * @param hit output parameter of the intersection, will be left out if no intersection was found
+		 * @param mask instances sharing no layer with the mask are skipped
+		 * @param maxDistance intersections further along the ray are ignored
+		 * @returns bool whether an intersection was found
+		 */
+		bool Raycast(Hit& hit, const glm::vec3& origin, const glm::vec3& direction, unsigned mask = ALL, float maxDistance = INFINITY) const;
+
+		/**
+		 * @returns bool whether any instance of the given layers is intersected closer than maxDistance
+		 */
+		bool Occluded(const glm::vec3& origin, const glm::vec3& direction, unsigned mask = ALL, float maxDistance = INFINITY) const;
+
+		/**
+		 * Finds the closest intersection of every ray of the batch
+		 * @param hits output array of count hits, Distance is INFINITY where the ray hit nothing
+		 * @param rays array of count rays
+		 * @param mask instances sharing no layer with the mask are skipped
+		 * @param jobs threads the packets of the batch are spread over, nullptr runs it on the calling thread
+		 */
+		void RaycastBatch(Hit* hits, const Ray* rays, size_t count, unsigned mask = ALL, JobSystem* jobs = nullptr) const;
+
+		/**
+		 * Tests every ray of the batch for any intersection closer than its MaxDistance, like line of sight checks
+		 * @param occluded output array of count flags, 1 where the ray is blocked
+		 */
+		void OccludedBatch(uint8_t* occluded, const Ray* rays, size_t count, unsigned mask = ALL, JobSystem* jobs = nullptr) const;
+
+		inline size_t InstanceCount() const { return m_Instances.size(); }
+	private:
+		struct Instance
+		{
+			const Model* Geometry;
+			const GameObject* Object;
+			const EntityStore* Store;
+			Entity Owner;
+			unsigned Layers;
+			glm::mat4 Matrix;
+			glm::mat4 Inverse;
+			// bounds of the model in model space, transformed into world bounds by every refit
+			glm::vec3 LocalMin;
+			glm::vec3 LocalMax;
+			glm::vec3 Min;
+			glm::vec3 Max;
+		};
+
+		// leaf has Count > 0 instances starting at First in m_Order, inner node has children at First and First + 1.
+		// Layers are the union of the layers below, so whole subtrees of other layers are skipped.
+		struct Node
+		{
+			glm::vec3 Min;
+			uint32_t First;
+			glm::vec3 Max;
+			uint32_t Count;
+			unsigned Layers;
+		};
+
+		void Place(Instance& instance, const glm::mat4& matrix) const;
+		void Subdivide(uint32_t node);
+		void FitNode(Node& node) const;
+
+		/**
+		 * Casts the ray into one instance in its model space
+		 * @param anyHit returns at the first face found instead of the closest one
+		 */
+		bool IntersectInstance(Hit& hit, uint32_t instance, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, bool anyHit) const;
+
+		template <bool ANY_HIT>
+		bool Traverse(Hit& hit, const glm::vec3& origin, const glm::vec3& direction, unsigned mask, float maxDistance) const;
+
+		// instances in a leaf, the scene has few of them so the tree stays shallow
+		static const unsigned MAX_LEAF = 2;
+		static const unsigned MAX_DEPTH = 64;
+
+		std::vector<Instance> m_Instances;
+		std::vector<uint32_t> m_Order;
+		std::vector<Node> m_Nodes;
+	};
+}
@@ -9,7 +9,9 @@
 #include "Texture.hpp"
 
 #include <pgr.h>
+#include <Renderer/RenderStats.hpp>
 #include <stdexcept>
+#include <vector>
 
 namespace kvasnric
 {
@@ -25,13 +27,59 @@ namespace kvasnric
 		glDeleteTextures(1, &m_ID);
 	}
 
+	bool Texture::IsColor(TYPE type)
+	{
+		return type == DIFFUSE || type == CUBEMAP;
+	}
+
+	bool Texture::UploadImage(const std::string& path, unsigned target, bool srgb)
+	{
+		ILuint image = 0;
+		ilGenImages(1, &image);
+		ilBindImage(image);
+
+		// opengl expects the first row at the bottom
+		ilEnable(IL_ORIGIN_SET);
+		ilOriginFunc(IL_ORIGIN_LOWER_LEFT);
+
+		if (ilLoadImage(path.c_str()) == IL_FALSE)
+		{
+			ilDeleteImages(1, &image);
+			return false;
+		}
+
+		const ILint width = ilGetInteger(IL_IMAGE_WIDTH);
+		const ILint height = ilGetInteger(IL_IMAGE_HEIGHT);
+		const ILenum format = ilGetInteger(IL_IMAGE_FORMAT);
+
+		// every image is converted to one byte per channel, alpha is kept only if the image has it
+		const bool alpha = format == IL_RGBA || format == IL_BGRA;
+		std::vector<unsigned char> data(width * height * (alpha ? 4 : 3));
+		ilCopyPixels(0, 0, 0, width, height, 1, alpha ? IL_RGBA : IL_RGB, IL_UNSIGNED_BYTE, data.data());
+		ilDeleteImages(1, &image);
+
+		GLint internal = alpha ? GL_RGBA8 : GL_RGB8;
+		if (srgb) internal = alpha ? GL_SRGB8_ALPHA8 : GL_SRGB8;
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(target, 0, internal, width, height, 0, alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, data.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		return true;
+	}
+
 	Texture2D::Texture2D(const std::string& filename, TYPE type)
+		: Texture2D(filename, type, IsColor(type))
+	{
+	}
+
+	Texture2D::Texture2D(const std::string& filename, TYPE type, bool srgb)
 		: Texture(filename, type)
 	{
 		glBindTexture(GL_TEXTURE_2D, m_ID);
 
 		// loads texture on texture2d target from path
-		if (!pgr::loadTexImage2D("res/textures/" + m_Name, GL_TEXTURE_2D))
+		if (!UploadImage("res/textures/" + m_Name, GL_TEXTURE_2D, srgb))
 		{
 			const std::string msg = "Cannot load texture: " + m_Name;
 			throw std::runtime_error(msg.c_str());
@@ -48,6 +96,7 @@ namespace kvasnric
 	{
 		glActiveTexture(GL_TEXTURE0 + m_Type);
 		glBindTexture(GL_TEXTURE_2D, m_ID);
+		RenderStats::Count(RenderStats::TEXTURE_BINDS);
 	}
 
 
@@ -50,7 +50,21 @@ namespace kvasnric
 		 * @return Texture name
 		 */
 		inline std::string GetName() const { return m_Name; }
+
+		/**
+		 * @returns whether the texture type holds colors, which are stored in sRGB. Data maps stay linear.
+		 */
+		static bool IsColor(TYPE type);
 	protected:
+		/**
+		 * Loads image file into the currently bound texture target
+		 * @param path path to the image file
+		 * @param target texture target passed to glTexImage2D
+		 * @param srgb stores texels as sRGB, so they are converted to linear space when sampled
+		 * @returns false if the file could not be loaded
+		 */
+		static bool UploadImage(const std::string& path, unsigned target, bool srgb);
+
 		std::string m_Name;
 		unsigned m_ID;
 		TYPE m_Type;
@@ -61,9 +75,15 @@ namespace kvasnric
 	{
 	public:
 		/**
-		 * Constructor that loads single texture file based on filename
+		 * Constructor that loads single texture file based on filename. Color space is chosen by the type.
 		 */
 		Texture2D(const std::string& filename, TYPE type);
+
+		/**
+		 * Constructor that loads single texture file based on filename
+		 * @param srgb whether the image holds sRGB colors
+		 */
+		Texture2D(const std::string& filename, TYPE type, bool srgb);
 		~Texture2D() override = default;
 
 		/**
@@ -0,0 +1,222 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       TriangleBlocks.cpp
+ * \author     Richard Kvasnica
+ * \brief      Vectorised ray triangle intersection definition
+*/
+//----------------------------------------------------------------------------------------
+
+#include "TriangleBlocks.hpp"
+#include "Mesh.hpp"
+
+#if KVASNRIC_TRIANGLE_LANES > 1
+#include <immintrin.h>
+#endif
+
+namespace kvasnric
+{
+	namespace
+	{
+		// the kernel is written once over these few operations, each instruction set defines them for its register
+#if KVASNRIC_TRIANGLE_LANES == 16
+		using Floats = __m512;
+		using Mask = __mmask16;
+
+		inline Floats Load(const float* p) { return _mm512_loadu_ps(p); }
+		inline Floats Set(float x) { return _mm512_set1_ps(x); }
+		inline Floats Add(Floats a, Floats b) { return _mm512_add_ps(a, b); }
+		inline Floats Sub(Floats a, Floats b) { return _mm512_sub_ps(a, b); }
+		inline Floats Mul(Floats a, Floats b) { return _mm512_mul_ps(a, b); }
+		inline Floats Div(Floats a, Floats b) { return _mm512_div_ps(a, b); }
+		inline void Store(float* p, Floats a) { _mm512_storeu_ps(p, a); }
+		inline Mask Less(Floats a, Floats b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		inline Mask LessEqual(Floats a, Floats b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+		inline Mask Greater(Floats a, Floats b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+		inline Mask Or(Mask a, Mask b) { return a | b; }
+		inline Mask And(Mask a, Mask b) { return a & b; }
+		inline Mask AndNot(Mask a, Mask b) { return (Mask) (~a & b); }
+		inline unsigned Bits(Mask a) { return a; }
+#elif KVASNRIC_TRIANGLE_LANES == 8
+		using Floats = __m256;
+		using Mask = __m256;
+
+		inline Floats Load(const float* p) { return _mm256_loadu_ps(p); }
+		inline Floats Set(float x) { return _mm256_set1_ps(x); }
+		inline Floats Add(Floats a, Floats b) { return _mm256_add_ps(a, b); }
+		inline Floats Sub(Floats a, Floats b) { return _mm256_sub_ps(a, b); }
+		inline Floats Mul(Floats a, Floats b) { return _mm256_mul_ps(a, b); }
+		inline Floats Div(Floats a, Floats b) { return _mm256_div_ps(a, b); }
+		inline void Store(float* p, Floats a) { _mm256_storeu_ps(p, a); }
+		inline Mask Less(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		inline Mask LessEqual(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+		inline Mask Greater(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		inline Mask Or(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+		inline Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+		inline Mask AndNot(Mask a, Mask b) { return _mm256_andnot_ps(a, b); }
+		inline unsigned Bits(Mask a) { return (unsigned) _mm256_movemask_ps(a); }
+#elif KVASNRIC_TRIANGLE_LANES == 4
+		using Floats = __m128;
+		using Mask = __m128;
+
+		inline Floats Load(const float* p) { return _mm_loadu_ps(p); }
+		inline Floats Set(float x) { return _mm_set1_ps(x); }
+		inline Floats Add(Floats a, Floats b) { return _mm_add_ps(a, b); }
+		inline Floats Sub(Floats a, Floats b) { return _mm_sub_ps(a, b); }
+		inline Floats Mul(Floats a, Floats b) { return _mm_mul_ps(a, b); }
+		inline Floats Div(Floats a, Floats b) { return _mm_div_ps(a, b); }
+		inline void Store(float* p, Floats a) { _mm_storeu_ps(p, a); }
+		inline Mask Less(Floats a, Floats b) { return _mm_cmplt_ps(a, b); }
+		inline Mask LessEqual(Floats a, Floats b) { return _mm_cmple_ps(a, b); }
+		inline Mask Greater(Floats a, Floats b) { return _mm_cmpgt_ps(a, b); }
+		inline Mask Or(Mask a, Mask b) { return _mm_or_ps(a, b); }
+		inline Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+		inline Mask AndNot(Mask a, Mask b) { return _mm_andnot_ps(a, b); }
+		inline unsigned Bits(Mask a) { return (unsigned) _mm_movemask_ps(a); }
+#else
+		using Floats = float;
+		using Mask = bool;
+
+		inline Floats Load(const float* p) { return *p; }
+		inline Floats Set(float x) { return x; }
+		inline Floats Add(Floats a, Floats b) { return a + b; }
+		inline Floats Sub(Floats a, Floats b) { return a - b; }
+		inline Floats Mul(Floats a, Floats b) { return a * b; }
+		inline Floats Div(Floats a, Floats b) { return a / b; }
+		inline void Store(float* p, Floats a) { *p = a; }
+		inline Mask Less(Floats a, Floats b) { return a < b; }
+		inline Mask LessEqual(Floats a, Floats b) { return a <= b; }
+		inline Mask Greater(Floats a, Floats b) { return a > b; }
+		inline Mask Or(Mask a, Mask b) { return a || b; }
+		inline Mask And(Mask a, Mask b) { return a && b; }
+		inline Mask AndNot(Mask a, Mask b) { return !a && b; }
+		inline unsigned Bits(Mask a) { return a ? 1u : 0u; }
+#endif
+
+		// the same as glm::dot, the sum goes from x to z
+		inline Floats Dot(Floats ax, Floats ay, Floats az, Floats bx, Floats by, Floats bz)
+		{
+			return Add(Add(Mul(ax, bx), Mul(ay, by)), Mul(az, bz));
+		}
+	}
+
+	const char* TriangleBlocks::InstructionSet()
+	{
+		switch (WIDTH)
+		{
+		case 16: return "AVX-512";
+		case 8: return "AVX";
+		case 4: return "SSE";
+		default: return "scalar";
+		}
+	}
+
+	void TriangleBlocks::Pack(Block& block, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) const
+	{
+		for (unsigned lane = 0; lane < WIDTH; ++lane)
+		{
+			// zero edges give zero determinant, the lane is rejected as parallel
+			glm::vec3 v0(0.0f), edge1(0.0f), edge2(0.0f);
+			const uint32_t id = block.Triangles[lane];
+			if (id != NO_TRIANGLE)
+			{
+				v0 = vertices[indices[id]].Position;
+				edge1 = vertices[indices[id + 1]].Position - v0;
+				edge2 = vertices[indices[id + 2]].Position - v0;
+			}
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				block.V0[axis][lane] = v0[axis];
+				block.Edge1[axis][lane] = edge1[axis];
+				block.Edge2[axis][lane] = edge2[axis];
+			}
+		}
+	}
+
+	uint32_t TriangleBlocks::AddTriangles(const uint32_t* triangles, uint32_t count, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		const uint32_t first = (uint32_t) m_Blocks.size();
+		m_Blocks.resize(first + BlocksFor(count));
+
+		for (uint32_t b = first; b < m_Blocks.size(); ++b)
+		{
+			Block& block = m_Blocks[b];
+			for (unsigned lane = 0; lane < WIDTH; ++lane)
+			{
+				const uint32_t i = (b - first) * WIDTH + lane;
+				block.Triangles[lane] = i < count ? triangles[i] : NO_TRIANGLE;
+			}
+			Pack(block, vertices, indices);
+		}
+
+		return first;
+	}
+
+	void TriangleBlocks::Update(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		for (auto& block : m_Blocks) Pack(block, vertices, indices);
+	}
+
+	unsigned TriangleBlocks::IntersectLanes(float t[WIDTH], uint32_t block, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+	{
+		const Block& b = m_Blocks[block];
+		const Floats EPS = Set(0.0000001f);
+		const Floats zero = Set(0.0f);
+		const Floats one = Set(1.0f);
+
+		const Floats dx = Set(direction.x), dy = Set(direction.y), dz = Set(direction.z);
+
+		const Floats e1x = Load(b.Edge1[0]), e1y = Load(b.Edge1[1]), e1z = Load(b.Edge1[2]);
+		const Floats e2x = Load(b.Edge2[0]), e2y = Load(b.Edge2[1]), e2z = Load(b.Edge2[2]);
+
+		// h = cross(direction, edge2)
+		const Floats hx = Sub(Mul(dy, e2z), Mul(e2y, dz));
+		const Floats hy = Sub(Mul(dz, e2x), Mul(e2z, dx));
+		const Floats hz = Sub(Mul(dx, e2y), Mul(e2x, dy));
+		const Floats a = Dot(e1x, e1y, e1z, hx, hy, hz);
+
+		// the scalar version returns early, here every rejection only clears lanes
+		Mask reject = And(Greater(a, Sub(zero, EPS)), Less(a, EPS));
+
+		const Floats f = Div(one, a);
+
+		// s = origin - v0
+		const Floats sx = Sub(Set(origin.x), Load(b.V0[0]));
+		const Floats sy = Sub(Set(origin.y), Load(b.V0[1]));
+		const Floats sz = Sub(Set(origin.z), Load(b.V0[2]));
+
+		const Floats u = Mul(f, Dot(sx, sy, sz, hx, hy, hz));
+		reject = Or(reject, Or(Less(u, zero), Greater(u, one)));
+
+		// q = cross(s, edge1)
+		const Floats qx = Sub(Mul(sy, e1z), Mul(e1y, sz));
+		const Floats qy = Sub(Mul(sz, e1x), Mul(e1z, sx));
+		const Floats qz = Sub(Mul(sx, e1y), Mul(e1x, sy));
+
+		const Floats v = Mul(f, Dot(dx, dy, dz, qx, qy, qz));
+		reject = Or(reject, Or(Less(v, zero), Greater(Add(u, v), one)));
+
+		const Floats d = Mul(f, Dot(e2x, e2y, e2z, qx, qy, qz));
+		reject = Or(reject, LessEqual(d, EPS));
+
+		Store(t, d);
+		return Bits(AndNot(reject, Less(d, Set(maxDistance))));
+	}
+
+	bool TriangleBlocks::Intersect(float& distance, uint32_t& triangle, uint32_t block, const glm::vec3& origin, const glm::vec3& direction) const
+	{
+		float t[WIDTH];
+		unsigned hits = IntersectLanes(t, block, origin, direction, distance);
+		if (!hits) return false;
+
+		for (unsigned lane = 0; hits; ++lane, hits >>= 1)
+		{
+			if ((hits & 1) && t[lane] < distance)
+			{
+				distance = t[lane];
+				triangle = m_Blocks[block].Triangles[lane];
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,107 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       TriangleBlocks.hpp
+ * \author     Richard Kvasnica
+ * \brief      Vectorised ray triangle intersection declaration
+ *
+ * Triangles are packed into blocks of structure of arrays, one triangle per simd lane,
+ * and a ray is tested against a whole block with one pass of Moller-Trumbore.
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// lanes of the widest instruction set the compiler targets, msvc enables avx with /arch:AVX2 and avx-512 with /arch:AVX512
+#if defined(KVASNRIC_SCALAR_TRIANGLES)
+#define KVASNRIC_TRIANGLE_LANES 1
+#elif defined(__AVX512F__)
+#define KVASNRIC_TRIANGLE_LANES 16
+#elif defined(__AVX__)
+#define KVASNRIC_TRIANGLE_LANES 8
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KVASNRIC_TRIANGLE_LANES 4
+#else
+#define KVASNRIC_TRIANGLE_LANES 1
+#endif
+
+namespace kvasnric
+{
+	struct Vertex;
+
+	/**
+	 * Leaf storage of acceleration structures. Edges are precomputed, so the vertices are not gathered through
+	 * the elements at query time. Every lane computes exactly the operations of MeshBVH::IntersectTriangle
+	 * in the same order, so the hits and distances are bitwise the same as the scalar ones
+	 * as long as the compiler does not contract them into fused multiply-adds (/fp:precise, -ffp-contract=off).
+	 */
+	class TriangleBlocks
+	{
+	public:
+		static const unsigned WIDTH = KVASNRIC_TRIANGLE_LANES;
+
+		// marks lanes padding the last block of a group, they hold a degenerate triangle which is never hit
+		static const uint32_t NO_TRIANGLE = 0xffffffffu;
+
+		/**
+		 * Packs triangles into new blocks, the last one is padded
+		 * @param triangles ids of the first index of each triangle in elements vector
+		 * @returns index of the first of the new blocks
+		 */
+		uint32_t AddTriangles(const uint32_t* triangles, uint32_t count, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+		/**
+		 * Computes the corners and edges of all blocks again after the vertices moved
+		 */
+		void Update(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+		/**
+		 * Tests the ray against every lane of the block
+		 * @param t output parameter of ray parameters, valid only in the lanes that were hit
+		 * @param maxDistance intersections at or further than this are not hits
+		 * @returns bit mask of the lanes with an intersection in front of the origin and closer than maxDistance
+		 */
+		unsigned IntersectLanes(float t[WIDTH], uint32_t block, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
+		/**
+		 * Finds the closest intersection in the block, the first lane wins ties like the scalar loop does
+		 * @param distance in: intersections at or further are ignored, out: ray parameter of the hit
+		 * @param triangle output parameter of the hit triangle id, will be left out if no intersection was found
+		 * @returns bool whether a closer intersection was found
+		 */
+		bool Intersect(float& distance, uint32_t& triangle, uint32_t block, const glm::vec3& origin, const glm::vec3& direction) const;
+
+		/**
+		 * @returns triangle id in the lane of the block, NO_TRIANGLE in padding lanes
+		 */
+		inline uint32_t Triangle(uint32_t block, unsigned lane) const { return m_Blocks[block].Triangles[lane]; }
+
+		inline uint32_t Count() const { return (uint32_t) m_Blocks.size(); }
+
+		/**
+		 * @returns number of blocks needed for the given number of triangles
+		 */
+		static inline uint32_t BlocksFor(uint32_t triangles) { return (triangles + WIDTH - 1) / WIDTH; }
+
+		/**
+		 * @returns name of the instruction set the kernel was compiled for
+		 */
+		static const char* InstructionSet();
+	private:
+		// one coordinate of all lanes is contiguous, so it is one simd load
+		struct Block
+		{
+			float V0[3][WIDTH];
+			float Edge1[3][WIDTH];
+			float Edge2[3][WIDTH];
+			uint32_t Triangles[WIDTH];
+		};
+
+		void Pack(Block& block, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) const;
+
+		std::vector<Block> m_Blocks;
+	};
+}
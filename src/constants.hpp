@@ -41,9 +41,56 @@ namespace kvasnric
 
 	const float MOVEMENT_SPEED = 3.0f;
 
+	// simulation advances in fixed steps independent of the frame rate, frames show a blend of the last two steps.
+	// Frames slower than the step limit are simulated in slow motion rather than stalling on catching up
+	const float SIMULATION_STEP = 1.0f / 120.0f;
+	const int SIMULATION_MAX_STEPS = 8;
+
+	// camera moving further than this in a single step was teleported and is not blended
+	const float INTERPOLATION_SNAP_DISTANCE = 1.0f;
+
+	// frames the GPU may still be rendering while the CPU prepares the next one, streamed buffers are kept this many times.
+	// Every frame more keeps the GPU busier and adds one frame of latency from the input to the screen
+	const unsigned FRAMES_IN_FLIGHT = 2;
+
+	// streamed buffer space of one frame in bytes, a frame needing more moves the stream into a larger buffer
+	const unsigned STREAM_FRAME_SIZE = 1u << 21;
+
 	const float NEAR_PLANE = 0.05f;
 	const float FAR_PLANE = 500.f;
 
+	// portal recursion limits. Nested level is rendered only if the portal it is seen through covers enough pixels
+	const int PORTAL_MAX_ITERATIONS = 6;
+	const float PORTAL_MIN_SCREEN_AREA = 64.0f;
+	const float PORTAL_FRAME_BUDGET_MS = 40.0f;
+
+	// linear light under one step of 8 bit sRGB color (1/255 on the linear segment of the curve) is not visible,
+	// bounds point light volumes
+	const float LIGHT_CUTOFF = 1.0f / (255.0f * 12.92f);
+
+	// spot lights do not attenuate, they reach only this far so they can be assigned to light clusters
+	const float SPOT_LIGHT_RANGE = 50.0f;
+
+	// lights added at once to the room when testing light culling and how far they reach
+	const unsigned LIGHT_SPAWN_COUNT = 100;
+	const float SPAWNED_LIGHT_RANGE = 3.0f;
+
+	// number of frames the profiler statistics are computed from, the overlay text is refreshed this often
+	const unsigned PROFILER_HISTORY = 240;
+	const float PROFILER_OVERLAY_REFRESH = 0.25f;
+	const char* const PROFILER_CSV_PATH = "profile.csv";
+
+	// render statistics are printed every this many frames while dumping is turned on
+	const unsigned RENDER_STATS_DUMP_FRAMES = 300;
+
+	// headless benchmark renders this many frames per portal recursion level, simulated at a fixed frame rate
+	const unsigned BENCHMARK_FRAMES_PER_PHASE = 600;
+	const double BENCHMARK_FRAME_TIME = 1.0 / 60.0;
+	const char* const BENCHMARK_OUTPUT_PATH = "benchmark.json";
+
+	// linked program binaries are kept here between launches, the file is rebuilt when the driver changes
+	const char* const PROGRAM_CACHE_PATH = "res/shaders/programs.cache";
+
 	const glm::vec3 WORLD_UP(0.0f, 1.0f, 0.0f);
 	const glm::vec3 WORLD_RIGHT(1.0f, 0.0f, 0.0f);
 
@@ -27,6 +27,14 @@ namespace kvasnric
 		//{
 		//	GLUTWrapper::TerminateWithError(err.what());
 		//}
+		// --benchmark [output.json] flies the predefined camera through the scene without a visible window
+		if (argc > 1 && std::string(argv[1]) == "--benchmark")
+		{
+			GLUTWrapper::InitHeadless(argc, argv, new PortalTestRoom());
+			GLUTWrapper::RunBenchmark(argc > 2 ? argv[2] : BENCHMARK_OUTPUT_PATH);
+			return 0;
+		}
+
 		GLUTWrapper::Init(argc, argv, new PortalTestRoom());
 		GLUTWrapper::Run();
 